@@ -0,0 +1,75 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <poll.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-async.h"
+
+int main(int argc, const char** argv) {
+    if (argc < 4 || argc%2 != 0) {
+        fprintf(stderr, "Read ranges of a zstd file concurrently with the async API, waiting for them with poll, and print them as they complete\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst <OFFSET> <LENGTH> [<OFFSET> <LENGTH>...]\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    ZSTDSeek_AsyncReader *reader = ZSTDSeek_createAsyncReader(sctx, 0);
+    if(!reader){
+        fprintf(stderr, "Can't create the reader\n");
+        return -1;
+    }
+
+    size_t reads = (size_t)(argc - 2)/2;
+    for(size_t i = 0; i < reads; i++){
+        size_t length = strtoull(argv[3 + 2*i], NULL, 10);
+        void *buff = malloc(length ? length : 1);
+        if(!buff || ZSTDSeek_submitRead(reader, buff, strtoull(argv[2 + 2*i], NULL, 10), length, (void *)i, NULL) != 0){
+            fprintf(stderr, "Can't submit the read\n");
+            return -1;
+        }
+    }
+
+    //an event loop would wait for other file descriptors too
+    struct pollfd pfd = {ZSTDSeek_asyncFd(reader), POLLIN, 0};
+    ZSTDSeek_AsyncCompletion completions[16];
+    int ret = 0;
+    while(reads > 0 && poll(&pfd, 1, -1) >= 0){
+        size_t count = ZSTDSeek_reapCompletions(reader, completions, 16);
+        for(size_t i = 0; i < count; i++){
+            ZSTDSeek_AsyncCompletion *c = &completions[i];
+            if(c->length == (size_t)ZSTDSEEK_ERR_READ){
+                fprintf(stderr, "Can't read range %zu\n", (size_t)c->user);
+                ret = -1;
+            }else{
+                printf("== range %zu: %zu bytes from %zu\n", (size_t)c->user, c->length, c->offset);
+                fwrite(c->buff, c->length, 1, stdout);
+                printf("\n");
+            }
+            free(c->buff);
+        }
+        reads -= count;
+    }
+
+    ZSTDSeek_freeAsyncReader(reader);
+    ZSTDSeek_free(sctx);
+
+    return ret;
+}
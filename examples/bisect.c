@@ -0,0 +1,117 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-bisect.h"
+
+#define BUFFSIZE (128*1024)
+
+//the key of a line is the number it begins with, eg a unix timestamp
+static int extractNumber(const void *record, size_t size, void *key, void *user){
+    (void)user;
+    const char *p = (const char *)record;
+    uint64_t value = 0;
+    size_t i = 0;
+    for(; i < size && p[i] >= '0' && p[i] <= '9'; i++){
+        value = value*10 + (uint64_t)(p[i] - '0');
+    }
+    if(i == 0){
+        return -1;
+    }
+    *(uint64_t *)key = value;
+    return 0;
+}
+
+static int compareNumber(const void *a, const void *b, void *user){
+    (void)user;
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static ZSTDSeek_KeySummary* openSummary(ZSTDSeek_Context *sctx, const ZSTDSeek_KeyFunctions *kf, const char *file){
+    char summaryFile[4096];
+    snprintf(summaryFile, sizeof(summaryFile), "%s.keys", file);
+
+    ZSTDSeek_KeySummary *summary = ZSTDSeek_loadKeySummary(sctx, kf, summaryFile);
+    if(summary){
+        return summary;
+    }
+
+    summary = ZSTDSeek_buildKeySummary(sctx, kf, 0);
+    if(summary && ZSTDSeek_saveKeySummary(summary, summaryFile) != 0){
+        fprintf(stderr, "Can't save the summary to %s\n", summaryFile);
+    }
+    return summary;
+}
+
+int main(int argc, const char** argv) {
+    if (argc<3 || argc>5) {
+        fprintf(stderr, "Print the lines of a zstd file sorted by the number they begin with, from the first with a number >= FROM to the last one < TO\n");
+        fprintf(stderr, "With -s the summary of the frames is saved to <FILE>.zst.keys and reused\n");
+        fprintf(stderr, "Usage: %s [-s] <FILE>.zst <FROM> [<TO>]\n", argv[0]);
+        return 1;
+    }
+
+    int useSummary = argv[1][0] == '-' && argv[1][1] == 's' && argv[1][2] == 0;
+    argv += useSummary;
+    argc -= useSummary;
+    if(argc < 3){
+        fprintf(stderr, "Missing arguments\n");
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    ZSTDSeek_KeyFunctions kf = {'\n', sizeof(uint64_t), extractNumber, compareNumber, NULL};
+    ZSTDSeek_KeySummary *summary = NULL;
+    if(useSummary && !(summary = openSummary(sctx, &kf, argv[1]))){
+        fprintf(stderr, "Can't build the summary\n");
+        return -1;
+    }
+
+    uint64_t from = strtoull(argv[2], NULL, 10);
+    size_t start, end = ZSTDSeek_uncompressedFileSize(sctx);
+    if(argc == 4){
+        uint64_t to = strtoull(argv[3], NULL, 10);
+        if(ZSTDSeek_bisect(sctx, &kf, summary, &to, &end) != 0){
+            fprintf(stderr, "Search failed\n");
+            return -1;
+        }
+    }
+    if(ZSTDSeek_bisect(sctx, &kf, summary, &from, &start) != 0){
+        fprintf(stderr, "Search failed\n");
+        return -1;
+    }
+
+    uint8_t buff[BUFFSIZE];
+    size_t len;
+    while(start < end && (len = ZSTDSeek_read(buff, end - start < BUFFSIZE ? end - start : BUFFSIZE, sctx)) > 0){
+        fwrite(buff, len, 1, stdout);
+        start += len;
+    }
+
+    if(summary){
+        ZSTDSeek_freeKeySummary(summary);
+    }
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-bloom.h"
+
+static ZSTDSeek_BloomIndex* openIndex(ZSTDSeek_Context *sctx, const char *file){
+    char indexFile[4096];
+    snprintf(indexFile, sizeof(indexFile), "%s.bloom", file);
+
+    ZSTDSeek_BloomIndex *index = ZSTDSeek_loadBloomIndex(sctx, indexFile);
+    if(index){
+        return index;
+    }
+
+    index = ZSTDSeek_buildBloomIndex(sctx, NULL, 0);
+    if(index && ZSTDSeek_saveBloomIndex(index, indexFile) != 0){
+        fprintf(stderr, "Can't save the index to %s\n", indexFile);
+    }
+    return index;
+}
+
+static int printMatch(size_t pos, void *user){
+    (void)user;
+    printf("%zu\n", pos);
+    return 0;
+}
+
+int main(int argc, const char** argv) {
+    if (argc!=3) {
+        fprintf(stderr, "Print the positions of a token, eg an id or an IP address, in a zstd file decoding only the frames that may contain it\n");
+        fprintf(stderr, "The Bloom filters of the frames are saved to <FILE>.zst.bloom\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst <TOKEN>\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    ZSTDSeek_BloomIndex *index = openIndex(sctx, argv[1]);
+    if(!index){
+        fprintf(stderr, "Can't index the file\n");
+        return -1;
+    }
+
+    size_t candidates = 0;
+    for(size_t i = 0; i < ZSTDSeek_bloomIndexLength(index); i++){
+        candidates += ZSTDSeek_bloomMayContain(index, i, argv[2], strlen(argv[2]));
+    }
+    fprintf(stderr, "Decoding %zu of %zu frames\n", candidates, ZSTDSeek_bloomIndexLength(index));
+
+    if(ZSTDSeek_bloomFindToken(sctx, index, argv[2], strlen(argv[2]), printMatch, NULL, 0) != 0){
+        fprintf(stderr, "Search failed\n");
+        return -1;
+    }
+
+    ZSTDSeek_freeBloomIndex(index);
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
@@ -0,0 +1,55 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-write.h"
+
+int main(int argc, const char** argv) {
+    if (argc<3) {
+        fprintf(stderr, "Concatenate zstd files in a single seekable zstd file, without decompressing them.\n");
+        fprintf(stderr, "Usage: %s <OUT>.zst <IN>.zst...\n", argv[0]);
+        return 1;
+    }
+
+    FILE* outF = fopen(argv[1], "wb");
+    if(!outF){
+        fprintf(stderr, "Can't open out file %s\n", argv[1]);
+        return -1;
+    }
+
+    ZSTDSeek_Writer *w = ZSTDSeek_createWriter(outF, ZSTD_CLEVEL_DEFAULT);
+
+    for(int i = 2; i < argc; i++){
+        ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[i]);
+        if(!sctx){
+            fprintf(stderr, "Can't create the context for %s\n", argv[i]);
+            return -1;
+        }
+
+        size_t frames = ZSTDSeek_getJumpTableOfContext(sctx)->length - 1;
+        if(ZSTDSeek_writerAddFrames(w, sctx, 0, frames) != 0){
+            fprintf(stderr, "Can't copy the frames of %s\n", argv[i]);
+            return -1;
+        }
+        printf("%s: %zu frames\n", argv[i], frames);
+
+        ZSTDSeek_free(sctx);
+    }
+
+    int ret = ZSTDSeek_writerClose(w);
+    fclose(outF);
+
+    return ret;
+}
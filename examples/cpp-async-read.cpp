@@ -0,0 +1,79 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <cstdio>
+#include <cstdlib>
+#include <coroutine>
+#include <stdexcept>
+#include <vector>
+#include <poll.h>
+#include "../zstd-seek.hpp"
+#include "../zstd-seek-async.hpp"
+
+//a coroutine that starts right away and is never awaited
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::abort(); }
+    };
+};
+
+static size_t pending = 0;
+static int ret = 0;
+
+static Detached readRange(zstdseek::AsyncReader &reader, size_t index, size_t offset, size_t length){
+    std::vector<char> buff(length);
+    size_t n = co_await reader.read(buff.data(), offset, length);
+    if(n == (size_t)ZSTDSEEK_ERR_READ){
+        fprintf(stderr, "Can't read range %zu\n", index);
+        ret = -1;
+    }else{
+        printf("== range %zu: %zu bytes from %zu\n", index, n, offset);
+        fwrite(buff.data(), n, 1, stdout);
+        printf("\n");
+    }
+    pending--;
+}
+
+int main(int argc, const char** argv) {
+    if (argc < 4 || argc%2 != 0) {
+        fprintf(stderr, "Read ranges of a zstd file concurrently with the C++ coroutines of the async API and print them as they complete\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst <OFFSET> <LENGTH> [<OFFSET> <LENGTH>...]\n", argv[0]);
+        return 1;
+    }
+
+    try{
+        zstdseek::Context ctx = zstdseek::Context::fromFile(argv[1]);
+        zstdseek::AsyncReader reader(ctx.get());
+
+        size_t reads = (size_t)(argc - 2)/2;
+        for(size_t i = 0; i < reads; i++){
+            pending++;
+            readRange(reader, i, strtoull(argv[2 + 2*i], NULL, 10), strtoull(argv[3 + 2*i], NULL, 10));
+        }
+
+        //an event loop would wait for other file descriptors too
+        struct pollfd pfd = {reader.fd(), POLLIN, 0};
+        while(pending > 0 && poll(&pfd, 1, -1) >= 0){
+            reader.poll();
+        }
+    }catch(const std::runtime_error &e){
+        fprintf(stderr, "%s\n", e.what());
+        return -1;
+    }
+
+    return ret;
+}
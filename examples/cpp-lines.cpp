@@ -0,0 +1,52 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "../zstd-seek.hpp"
+
+int main(int argc, const char** argv) {
+    if (argc!=4) {
+        fprintf(stderr, "Print COUNT lines of a zstd file starting from the first one that begins at or after OFFSET, reading it with zstdseek::IStream\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst <OFFSET> <COUNT>\n", argv[0]);
+        return 1;
+    }
+
+    try{
+        zstdseek::Context ctx = zstdseek::Context::fromFile(argv[1]);
+        zstdseek::IStream in(ctx);
+
+        size_t offset = strtoull(argv[2], NULL, 10);
+        size_t count = strtoull(argv[3], NULL, 10);
+        std::string line;
+        in.seekg(offset > 0 ? offset - 1 : 0);
+        if(offset > 0){ //skip up until the end of the line before offset
+            std::getline(in, line);
+        }
+        for(size_t i = 0; i < count && std::getline(in, line); i++){
+            std::cout << line << '\n';
+        }
+        if(in.bad()){
+            fprintf(stderr, "Error while reading\n");
+            return -1;
+        }
+    }catch(const std::runtime_error &e){
+        fprintf(stderr, "%s\n", e.what());
+        return -1;
+    }
+
+    return 0;
+}
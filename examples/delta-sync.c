@@ -0,0 +1,98 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-delta.h"
+
+static void usage(const char *name){
+    fprintf(stderr, "Synchronize two versions of a zstd file shipping only the frames that changed.\n");
+    fprintf(stderr, "Usage: %s diff <OLD>.zst <NEW>.zst <PATCH>\n", name);
+    fprintf(stderr, "       %s apply <OLD>.zst <PATCH> <OUT>.zst\n", name);
+}
+
+static int diff(const char *oldFile, const char *newFile, const char *patchFile){
+    ZSTDSeek_Context* oldSctx = ZSTDSeek_createFromFile(oldFile);
+    ZSTDSeek_Context* newSctx = ZSTDSeek_createFromFile(newFile);
+    if(!oldSctx || !newSctx){
+        fprintf(stderr, "Can't create the contexts\n");
+        return -1;
+    }
+
+    FILE *patch = fopen(patchFile, "wb");
+    if(!patch){
+        fprintf(stderr, "Can't open patch file %s\n", patchFile);
+        return -1;
+    }
+
+    size_t copied, literal;
+    int ret = ZSTDSeek_createPatch(oldSctx, newSctx, patch, &copied, &literal);
+    if(ret == 0){
+        printf("%zu frames unchanged, %zu frames in the patch\n", copied, literal);
+    }
+
+    fclose(patch);
+    ZSTDSeek_free(oldSctx);
+    ZSTDSeek_free(newSctx);
+    return ret;
+}
+
+static int apply(const char *oldFile, const char *patchFile, const char *outFile){
+    ZSTDSeek_Context* oldSctx = ZSTDSeek_createFromFile(oldFile);
+    if(!oldSctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    FILE *patch = fopen(patchFile, "rb");
+    if(!patch){
+        fprintf(stderr, "Can't open patch file %s\n", patchFile);
+        return -1;
+    }
+    FILE *out = fopen(outFile, "wb");
+    if(!out){
+        fprintf(stderr, "Can't open out file %s\n", outFile);
+        return -1;
+    }
+
+    int ret = ZSTDSeek_applyPatch(oldSctx, patch, out);
+
+    fclose(out);
+    fclose(patch);
+    ZSTDSeek_free(oldSctx);
+    return ret;
+}
+
+int main(int argc, const char** argv) {
+    if (argc!=5) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int ret;
+    if(strcmp(argv[1], "diff") == 0){
+        ret = diff(argv[2], argv[3], argv[4]);
+    }else if(strcmp(argv[1], "apply") == 0){
+        ret = apply(argv[2], argv[3], argv[4]);
+    }else{
+        usage(argv[0]);
+        return 1;
+    }
+
+    if(ret != 0){
+        fprintf(stderr, "%s failed\n", argv[1]);
+    }
+    return ret;
+}
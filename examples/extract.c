@@ -0,0 +1,52 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-write.h"
+
+#define DEFAULT_LEVEL 3
+
+int main(int argc, const char** argv) {
+    if (argc<5 || argc>6) {
+        fprintf(stderr, "Extract an uncompressed range of a zstd file in a new seekable zstd file.\n");
+        fprintf(stderr, "Only the frames at the edges of the range are compressed again, the others are copied.\n");
+        fprintf(stderr, "Usage: %s <IN>.zst <OFFSET> <LENGTH> <OUT>.zst [LEVEL]\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFileWithoutJumpTable(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    FILE* outF = fopen(argv[4], "wb");
+    if(!outF){
+        fprintf(stderr, "Can't open out file %s\n", argv[4]);
+        return -1;
+    }
+
+    int level = argc>5 ? atoi(argv[5]) : DEFAULT_LEVEL;
+    if(ZSTDSeek_extractRange(sctx, strtoull(argv[2], NULL, 10), strtoull(argv[3], NULL, 10), outF, level) != 0){
+        fprintf(stderr, "Extraction failed\n");
+        fclose(outF);
+        return -1;
+    }
+
+    fclose(outF);
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
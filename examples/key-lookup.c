@@ -0,0 +1,102 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-keyindex.h"
+
+//the key of a line is the value of its first "id" field, eg {"id":"a1b2",...} or {"id": 42,...}
+static int extractId(const void *record, size_t size, const void **key, size_t *keySize, void *user){
+    (void)user;
+    const char *p = (const char *)record;
+    const char *end = p + size;
+    for(; p + 5 <= end; p++){
+        if(memcmp(p, "\"id\"", 4) != 0){
+            continue;
+        }
+        p += 4;
+        while(p < end && (*p == ' ' || *p == ':')){
+            p++;
+        }
+        if(p < end && *p == '"'){
+            p++;
+            const char *q = memchr(p, '"', end - p);
+            if(!q){
+                return -1;
+            }
+            *key = p;
+            *keySize = q - p;
+            return 0;
+        }
+        const char *q = p;
+        while(q < end && *q != ',' && *q != '}' && *q != ' '){
+            q++;
+        }
+        *key = p;
+        *keySize = q - p;
+        return q > p ? 0 : -1;
+    }
+    return -1;
+}
+
+int main(int argc, const char** argv) {
+    if (argc<3) {
+        fprintf(stderr, "Print the lines of a zstd file of JSON objects, one per line, with the given ids\n");
+        fprintf(stderr, "The index of the ids is saved to <FILE>.zst.kidx\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst <ID>...\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    char indexFile[4096];
+    snprintf(indexFile, sizeof(indexFile), "%s.kidx", argv[1]);
+    ZSTDSeek_KeyIndex *index = ZSTDSeek_openKeyIndex(sctx, indexFile, extractId, NULL);
+    if(!index){
+        if(ZSTDSeek_buildKeyIndex(sctx, '\n', extractId, NULL, indexFile, 0) != 0 ||
+           !(index = ZSTDSeek_openKeyIndex(sctx, indexFile, extractId, NULL))){
+            fprintf(stderr, "Can't index the file\n");
+            return -1;
+        }
+    }
+
+    int ret = 0;
+    for(int i = 2; i < argc; i++){
+        const void *record;
+        size_t length;
+        int found = ZSTDSeek_lookupKey(sctx, index, argv[i], strlen(argv[i]), &record, &length, NULL);
+        if(found < 0){
+            fprintf(stderr, "Lookup failed\n");
+            return -1;
+        }
+        if(found){
+            fwrite(record, length, 1, stdout);
+            fputc('\n', stdout);
+        }else{
+            fprintf(stderr, "%s: not found\n", argv[i]);
+            ret = 1;
+        }
+    }
+
+    ZSTDSeek_closeKeyIndex(index);
+    ZSTDSeek_free(sctx);
+
+    return ret;
+}
@@ -0,0 +1,88 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-records.h"
+
+#define BUFFSIZE (128*1024)
+
+static ZSTDSeek_RecordIndex* openIndex(ZSTDSeek_Context *sctx, const char *file){
+    char indexFile[4096];
+    snprintf(indexFile, sizeof(indexFile), "%s.lines", file);
+
+    ZSTDSeek_RecordIndex *index = ZSTDSeek_loadRecordIndex(sctx, indexFile);
+    if(index && ZSTDSeek_recordDelimiter(index) == '\n'){
+        return index;
+    }
+    if(index){
+        ZSTDSeek_freeRecordIndex(index);
+    }
+
+    index = ZSTDSeek_buildRecordIndex(sctx, '\n', 0);
+    if(index && ZSTDSeek_saveRecordIndex(index, indexFile) != 0){
+        fprintf(stderr, "Can't save the index to %s\n", indexFile);
+    }
+    return index;
+}
+
+int main(int argc, const char** argv) {
+    if (argc!=2 && argc!=3 && argc!=4) {
+        fprintf(stderr, "Print the number of lines of a zstd file, or COUNT lines starting from line FIRST (counting from 1)\n");
+        fprintf(stderr, "The line index is saved to <FILE>.zst.lines\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst [<FIRST> [<COUNT>]]\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    ZSTDSeek_RecordIndex *index = openIndex(sctx, argv[1]);
+    if(!index){
+        fprintf(stderr, "Can't index the file\n");
+        return -1;
+    }
+
+    if(argc == 2){
+        printf("%zu\n", ZSTDSeek_recordCount(index));
+    }else{
+        size_t first = strtoull(argv[2], NULL, 10);
+        size_t count = argc == 4 ? strtoull(argv[3], NULL, 10) : 1;
+        if(first == 0 || ZSTDSeek_seekToRecord(sctx, index, first - 1) != 0){
+            fprintf(stderr, "No line %s\n", argv[2]);
+            return -1;
+        }
+
+        uint8_t buff[BUFFSIZE];
+        size_t len;
+        while(count > 0 && (len = ZSTDSeek_read(buff, BUFFSIZE, sctx)) > 0){
+            size_t i = 0;
+            while(i < len && count > 0){
+                if(buff[i++] == '\n'){
+                    count--;
+                }
+            }
+            fwrite(buff, i, 1, stdout);
+        }
+    }
+
+    ZSTDSeek_freeRecordIndex(index);
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
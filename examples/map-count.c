@@ -0,0 +1,103 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#define _GNU_SOURCE //memmem
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-mapping.h"
+
+typedef struct{
+    const char *data;
+    size_t size;
+    size_t start;
+    size_t end;
+    const char *needle;
+    size_t needleLen;
+    size_t count;
+} Slice;
+
+void* countSlice(void *arg){
+    Slice *s = (Slice *)arg;
+    size_t pos = s->start;
+    while(pos < s->end){
+        size_t avail = s->size - pos;
+        size_t window = s->end - pos + s->needleLen - 1; //the matches starting in the slice
+        const char *match = memmem(s->data + pos, window < avail ? window : avail, s->needle, s->needleLen);
+        if(!match){
+            break;
+        }
+        s->count++;
+        pos = (size_t)(match - s->data) + 1;
+    }
+    return NULL;
+}
+
+int main(int argc, const char** argv) {
+    if (argc<3 || argc>5) {
+        fprintf(stderr, "Count the occurrences of STRING in the uncompressed data of a zstd file, searching it with memmem in memory\n");
+        fprintf(stderr, "The data is mapped with ZSTDSeek_createMapping, at most RESIDENT MiB in memory, and searched by THREADS threads\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst <STRING> [<RESIDENT> [<THREADS>]]\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    size_t resident = argc >= 4 ? strtoull(argv[3], NULL, 10) * 1024 * 1024 : 0;
+    int nthreads = argc == 5 ? atoi(argv[4]) : ZSTDSeek_defaultNumberOfThreads();
+    if(nthreads <= 0 || strlen(argv[2]) == 0){
+        fprintf(stderr, "Invalid arguments\n");
+        return -1;
+    }
+    ZSTDSeek_Mapping *map = ZSTDSeek_createMapping(sctx, resident, nthreads);
+    if(!map){
+        perror("Can't map the file");
+        return -1;
+    }
+
+    const char *data = ZSTDSeek_mappingAddress(map);
+    size_t size = ZSTDSeek_mappingSize(map);
+    Slice *slices = calloc(nthreads, sizeof(Slice));
+    pthread_t *threads = calloc(nthreads, sizeof(pthread_t));
+    for(int i = 0; i < nthreads; i++){
+        slices[i].data = data;
+        slices[i].size = size;
+        slices[i].start = size / nthreads * i;
+        slices[i].end = i == nthreads - 1 ? size : size / nthreads * (i + 1);
+        slices[i].needle = argv[2];
+        slices[i].needleLen = strlen(argv[2]);
+        pthread_create(&threads[i], NULL, countSlice, &slices[i]);
+    }
+    size_t count = 0;
+    for(int i = 0; i < nthreads; i++){
+        pthread_join(threads[i], NULL);
+        count += slices[i].count;
+    }
+    printf("%zu\n", count);
+    fprintf(stderr, "%zu bytes resident at the end\n", ZSTDSeek_mappingResidentSize(map));
+
+    free(slices);
+    free(threads);
+    ZSTDSeek_freeMapping(map);
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
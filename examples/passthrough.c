@@ -0,0 +1,77 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../zstd-seek.h"
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+//send the compressed bytes with sendfile when possible, the data is never copied in user space
+static int sendRange(ZSTDSeek_Context *sctx, size_t pos, size_t size, FILE *out){
+#ifdef __linux__
+    int fd = ZSTDSeek_fileno(sctx);
+    if(fd >= 0){
+        fflush(out);
+        off_t offset = (off_t)pos;
+        while(size > 0){
+            ssize_t sent = sendfile(fileno(out), fd, &offset, size);
+            if(sent <= 0){
+                break;
+            }
+            size -= sent;
+        }
+        if(size == 0){
+            return 0;
+        }
+        pos = (size_t)offset; //sendfile is not supported by the output, fallback to fwrite
+    }
+#endif
+    const uint8_t *buff = ZSTDSeek_getCompressedBuffer(sctx, NULL);
+    return fwrite(buff + pos, 1, size, out) == size ? 0 : -1;
+}
+
+int main(int argc, const char** argv) {
+    if (argc!=4) {
+        fprintf(stderr, "Write to stdout the compressed frames that cover an uncompressed range, without decompressing them.\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst <OFFSET> <LENGTH> > <OUT>.zst\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFileWithoutJumpTable(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    ZSTDSeek_CompressedExtent extent;
+    if(ZSTDSeek_getCompressedExtent(sctx, strtoull(argv[2], NULL, 10), strtoull(argv[3], NULL, 10), &extent) != 0){
+        fprintf(stderr, "Invalid range\n");
+        return -1;
+    }
+
+    fprintf(stderr, "Frames %zu-%zu, %zu compressed bytes at %zu\n", extent.firstFrame, extent.lastFrame, extent.compressedSize, extent.compressedPos);
+    fprintf(stderr, "Discard %zu bytes at the beginning and %zu at the end of the decompressed output\n", extent.skip, extent.trim);
+
+    if(sendRange(sctx, extent.compressedPos, extent.compressedSize, stdout) != 0){
+        fprintf(stderr, "Error while writing\n");
+        return -1;
+    }
+
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-write.h"
+
+#define MIN_HOT_FRAME_SIZE (4*1024)
+#define DEFAULT_COLD_FRAME_SIZE (4*1024*1024)
+#define DEFAULT_LEVEL 3
+
+typedef struct {
+    uint64_t accesses;
+    uint64_t decodedBytes;
+    uint64_t returnedBytes;
+} heat;
+
+//read a heatmap written by ZSTDSeek_writeAccessStats
+static heat* loadHeatmap(const char *file, size_t frames){
+    FILE *f = fopen(file, "r");
+    if(!f){
+        return NULL;
+    }
+    heat *h = calloc(frames > 0 ? frames : 1, sizeof(heat));
+    if(!h){
+        fclose(f);
+        return NULL;
+    }
+    char line[512];
+    while(fgets(line, sizeof(line), f)){
+        if(line[0]=='#'){
+            continue;
+        }
+        size_t frame, cPos, uPos, uSize;
+        unsigned long long accesses, decoded, returned;
+        if(sscanf(line, "%zu %zu %zu %zu %llu %llu %llu", &frame, &cPos, &uPos, &uSize, &accesses, &decoded, &returned) != 7 || frame >= frames){
+            fprintf(stderr, "Heatmap does not match the archive: %s", line);
+            free(h);
+            fclose(f);
+            return NULL;
+        }
+        h[frame] = (heat){accesses, decoded, returned};
+    }
+    fclose(f);
+    return h;
+}
+
+static size_t nextPow2(size_t v){
+    size_t p = 1;
+    while(p < v){
+        p <<= 1;
+    }
+    return p;
+}
+
+/*
+ * Cold frames are merged up to coldFrameSize.
+ * Hot frames that decode much more than they return are split into frames of about the average read size.
+ * Everything else keeps its size.
+ */
+static size_t targetFrameSize(heat h, size_t frameSize, size_t coldFrameSize){
+    if(h.accesses == 0){
+        return coldFrameSize;
+    }
+    if(h.returnedBytes > 0 && h.decodedBytes / h.returnedBytes >= 2){
+        size_t target = nextPow2(h.returnedBytes / h.accesses);
+        if(target < MIN_HOT_FRAME_SIZE){
+            target = MIN_HOT_FRAME_SIZE;
+        }
+        if(target < frameSize){
+            return target;
+        }
+    }
+    return frameSize;
+}
+
+int main(int argc, const char** argv) {
+    if (argc<4 || argc>6) {
+        fprintf(stderr, "Rewrite a zstd file with frame sizes driven by an access heatmap.\n");
+        fprintf(stderr, "The heatmap is the output of ZSTDSeek_writeAccessStats.\n");
+        fprintf(stderr, "Usage: %s <IN>.zst <HEATMAP> <OUT>.zst [COLD FRAME SIZE] [LEVEL]\n", argv[0]);
+        return 1;
+    }
+
+    size_t coldFrameSize = argc>4 ? strtoull(argv[4], NULL, 10) : DEFAULT_COLD_FRAME_SIZE;
+    int level = argc>5 ? atoi(argv[5]) : DEFAULT_LEVEL;
+    if(coldFrameSize == 0){
+        fprintf(stderr, "Invalid cold frame size %s\n", argv[4]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+    if(ZSTDSeek_initializeJumpTable(sctx) != 0 || jt->length == 0){
+        fprintf(stderr, "Can't read the frames of %s\n", argv[1]);
+        ZSTDSeek_free(sctx);
+        return -1;
+    }
+    size_t frames = jt->length - 1;
+
+    heat *h = loadHeatmap(argv[2], frames);
+    if(!h){
+        fprintf(stderr, "Can't load the heatmap %s\n", argv[2]);
+        ZSTDSeek_free(sctx);
+        return -1;
+    }
+
+    FILE* outF = fopen(argv[3], "wb");
+    if(!outF){
+        fprintf(stderr, "Can't open out file %s\n", argv[3]);
+        free(h);
+        ZSTDSeek_free(sctx);
+        return -1;
+    }
+    ZSTDSeek_Writer *w = ZSTDSeek_createWriter(outF, level);
+
+    size_t pendingCapacity = coldFrameSize;
+    uint8_t *pending = malloc(pendingCapacity);
+    size_t pendingSize = 0; //cold data waiting to be merged in a bigger frame
+
+    int ret = w && pending ? 0 : -1;
+    if(ret != 0){
+        fprintf(stderr, "Can't create the writer\n");
+    }
+    for(size_t i = 0; i < frames && ret == 0; i++){
+        size_t frameSize = jt->records[i+1].uncompressedPos - jt->records[i].uncompressedPos;
+        size_t target = targetFrameSize(h[i], frameSize, coldFrameSize);
+        int cold = h[i].accesses == 0;
+
+        if(!cold && pendingSize > 0){
+            ret |= ZSTDSeek_writerAddFrame(w, pending, pendingSize);
+            pendingSize = 0;
+        }
+
+        if(pendingSize + frameSize > pendingCapacity){
+            uint8_t *tmp = realloc(pending, pendingSize + frameSize);
+            if(!tmp){
+                fprintf(stderr, "Out of memory\n");
+                ret = -1;
+                break;
+            }
+            pending = tmp;
+            pendingCapacity = pendingSize + frameSize;
+        }
+        if(ZSTDSeek_seek(sctx, jt->records[i].uncompressedPos, SEEK_SET) != 0 ||
+           ZSTDSeek_read(pending + pendingSize, frameSize, sctx) != frameSize){
+            fprintf(stderr, "Error while reading frame %zu\n", i);
+            ret = -1;
+            break;
+        }
+        pendingSize += frameSize;
+
+        size_t offset = 0;
+        while(pendingSize - offset >= target && ret == 0){
+            ret |= ZSTDSeek_writerAddFrame(w, pending + offset, target);
+            offset += target;
+        }
+        if(!cold && offset < pendingSize){
+            ret |= ZSTDSeek_writerAddFrame(w, pending + offset, pendingSize - offset);
+            offset = pendingSize;
+        }
+        memmove(pending, pending + offset, pendingSize - offset);
+        pendingSize -= offset;
+    }
+    if(ret == 0 && pendingSize > 0){
+        ret |= ZSTDSeek_writerAddFrame(w, pending, pendingSize);
+    }
+
+    if(ret == 0){
+        printf("%zu frames in, %zu frames out\n", frames, ZSTDSeek_writerNumberOfFrames(w));
+    }else{
+        fprintf(stderr, "Can't write %s\n", argv[3]);
+    }
+
+    if(w && ZSTDSeek_writerClose(w) != 0){
+        ret = -1;
+    }
+    if(fclose(outF) != 0){
+        ret = -1;
+    }
+    free(pending);
+    free(h);
+    ZSTDSeek_free(sctx);
+
+    return ret;
+}
@@ -0,0 +1,82 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../zstd-seek.h"
+
+#define BUFFSIZE (128*1024)
+
+int saveCheckpoint(ZSTDSeek_Context *sctx, const char *file){
+    ZSTDSeek_ResumeToken token;
+    uint8_t buff[ZSTDSEEK_RESUME_TOKEN_ENCODED_SIZE];
+    if(ZSTDSeek_getResumeToken(sctx, &token) != 0){
+        return -1;
+    }
+    ZSTDSeek_encodeResumeToken(&token, buff);
+
+    FILE *f = fopen(file, "wb");
+    if(!f){
+        return -1;
+    }
+    int ret = fwrite(buff, sizeof(buff), 1, f) == 1 ? 0 : -1;
+    return fclose(f) == 0 ? ret : -1;
+}
+
+int main(int argc, const char** argv) {
+    if (argc!=3 && argc!=4) {
+        fprintf(stderr, "Print up to N bytes of a zstd file from the checkpoint, all of them by default, then save the new checkpoint\n");
+        fprintf(stderr, "Without a checkpoint it starts from the beginning, every run continues where the previous one stopped\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst <CHECKPOINT> [<N>]\n", argv[0]);
+        return 1;
+    }
+
+    //the jump table is not needed to resume, only the frame of the checkpoint is parsed
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFileWithoutJumpTable(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    FILE *f = fopen(argv[2], "rb");
+    if(f){
+        uint8_t buff[ZSTDSEEK_RESUME_TOKEN_ENCODED_SIZE];
+        ZSTDSeek_ResumeToken token;
+        size_t len = fread(buff, 1, sizeof(buff), f);
+        fclose(f);
+        if(ZSTDSeek_decodeResumeToken(buff, len, &token) != 0 || ZSTDSeek_seekToResumeToken(sctx, &token) != 0){
+            fprintf(stderr, "The checkpoint is not of this file\n");
+            return -1;
+        }
+    }
+
+    size_t n = argc == 4 ? strtoull(argv[3], NULL, 10) : SIZE_MAX;
+    uint8_t *buff = malloc(BUFFSIZE);
+    size_t len;
+    while(n > 0 && (len = ZSTDSeek_read(buff, n < BUFFSIZE ? n : BUFFSIZE, sctx)) > 0){
+        fwrite(buff, len, 1, stdout);
+        n -= len;
+    }
+    fflush(stdout);
+
+    if(saveCheckpoint(sctx, argv[2]) != 0){
+        fprintf(stderr, "Can't save the checkpoint\n");
+        return -1;
+    }
+
+    free(buff);
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
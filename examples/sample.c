@@ -0,0 +1,56 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-sample.h"
+
+static int printLine(size_t pos, const void *record, size_t size, void *user){
+    if(user){
+        printf("%zu:", pos);
+    }
+    fwrite(record, size, 1, stdout);
+    putchar('\n');
+    return 0;
+}
+
+int main(int argc, const char** argv) {
+    int offsets = argc > 1 && argv[1][0] == '-' && argv[1][1] == 'b';
+    if (argc - offsets != 3 && argc - offsets != 4) {
+        fprintf(stderr, "Print K random lines of a zstd file decompressing only about K frames, the same ones for the same SEED\n");
+        fprintf(stderr, "With -b print the offset of each line too\n");
+        fprintf(stderr, "Usage: %s [-b] <FILE>.zst <K> [<SEED>]\n", argv[0]);
+        return 1;
+    }
+    argv += offsets;
+    argc -= offsets;
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    uint64_t seed = argc == 4 ? strtoull(argv[3], NULL, 10) : (uint64_t)time(NULL);
+    int ret = ZSTDSeek_sampleRecords(sctx, '\n', strtoull(argv[2], NULL, 10), seed, printLine, offsets ? sctx : NULL, 0);
+    if(ret != 0){
+        fprintf(stderr, "Can't sample the file\n");
+    }
+
+    ZSTDSeek_free(sctx);
+
+    return ret;
+}
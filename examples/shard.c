@@ -0,0 +1,98 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-shard.h"
+
+#define BUFFSIZE (128*1024)
+
+/*
+ * What a worker does with a descriptor: it needs only the compressed bytes of the shard, not the whole file nor its jump table.
+ */
+static int processShard(const uint8_t *compressed, const uint8_t *descriptor){
+    ZSTDSeek_Shard shard;
+    if(ZSTDSeek_decodeShard(descriptor, ZSTDSEEK_SHARD_ENCODED_SIZE, &shard) != 0){
+        fprintf(stderr, "Invalid shard descriptor\n");
+        return -1;
+    }
+
+    ZSTDSeek_Context *sctx = ZSTDSeek_createWithoutJumpTable((void *)(compressed + shard.compressedPos), shard.compressedSize);
+    if(!sctx || ZSTDSeek_seek(sctx, (long)shard.skip, SEEK_SET) != 0){
+        fprintf(stderr, "Can't open the shard\n");
+        return -1;
+    }
+
+    uint8_t buff[BUFFSIZE];
+    uint64_t left = shard.length;
+    while(left > 0){
+        size_t len = ZSTDSeek_read(buff, left < BUFFSIZE ? left : BUFFSIZE, sctx);
+        if(len == 0 || len == (size_t)ZSTDSEEK_ERR_READ){
+            fprintf(stderr, "Can't read the shard\n");
+            ZSTDSeek_free(sctx);
+            return -1;
+        }
+        fwrite(buff, len, 1, stdout);
+        left -= len;
+    }
+
+    ZSTDSeek_free(sctx);
+    return 0;
+}
+
+int main(int argc, const char** argv) {
+    if (argc!=3 && argc!=4) {
+        fprintf(stderr, "Split the lines of a zstd file in N shards and print them, or print the lines of shard K (counting from 0)\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst <N> [<K>]\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    size_t length;
+    ZSTDSeek_Shard *shards = ZSTDSeek_planShards(sctx, '\n', strtoull(argv[2], NULL, 10), &length);
+    if(!shards){
+        fprintf(stderr, "Can't plan the shards\n");
+        return -1;
+    }
+
+    int ret = 0;
+    if(argc == 3){
+        printf("%-6s %14s %14s %10s %14s %14s\n", "shard", "offset", "length", "frame", "compressedPos", "compressedSize");
+        for(size_t i = 0; i < length; i++){
+            printf("%-6zu %14llu %14llu %10llu %14llu %14llu\n", i, (unsigned long long)shards[i].offset, (unsigned long long)shards[i].length,
+                   (unsigned long long)shards[i].firstFrame, (unsigned long long)shards[i].compressedPos, (unsigned long long)shards[i].compressedSize);
+        }
+    }else{
+        size_t k = strtoull(argv[3], NULL, 10);
+        if(k >= length){
+            fprintf(stderr, "There are only %zu shards\n", length);
+            ret = -1;
+        }else{
+            uint8_t descriptor[ZSTDSEEK_SHARD_ENCODED_SIZE];
+            ZSTDSeek_encodeShard(&shards[k], descriptor);
+            ret = processShard(ZSTDSeek_getCompressedBuffer(sctx, NULL), descriptor);
+        }
+    }
+
+    free(shards);
+    ZSTDSeek_free(sctx);
+
+    return ret;
+}
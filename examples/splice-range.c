@@ -0,0 +1,51 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-splice.h"
+
+int main(int argc, const char** argv) {
+    if (argc!=2 && argc!=4) {
+        fprintf(stderr, "Write to stdout LENGTH bytes of the uncompressed data of a zstd file from OFFSET, or all of it\n");
+        fprintf(stderr, "If stdout is a pipe or a socket the data is spliced to it, without copying it\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst [<OFFSET> <LENGTH>]\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    size_t offset = argc == 4 ? strtoull(argv[2], NULL, 10) : 0;
+    size_t length = argc == 4 ? strtoull(argv[3], NULL, 10) : ZSTDSeek_uncompressedFileSize(sctx);
+    size_t written;
+    int ret = ZSTDSeek_spliceRange(sctx, offset, length, fileno(stdout), &written);
+    if(ret == ZSTDSEEK_ERR_BEYOND_END_SEEK){
+        fprintf(stderr, "Invalid range\n");
+        return -1;
+    }
+    if(ret != 0){
+        perror("Error while writing");
+        fprintf(stderr, "%zu bytes written\n", written);
+        return -1;
+    }
+
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-write.h"
+
+static int writeShard(ZSTDSeek_Context *sctx, const char *prefix, int shard, size_t firstFrame, size_t lastFrame){
+    char outFileName[4096];
+    snprintf(outFileName, sizeof(outFileName), "%s.%d.zst", prefix, shard);
+
+    FILE* outF = fopen(outFileName, "wb");
+    if(!outF){
+        fprintf(stderr, "Can't open out file %s\n", outFileName);
+        return -1;
+    }
+
+    ZSTDSeek_Writer *w = ZSTDSeek_createWriter(outF, ZSTD_CLEVEL_DEFAULT);
+    int ret = ZSTDSeek_writerAddFrames(w, sctx, firstFrame, lastFrame - firstFrame);
+    if(ZSTDSeek_writerClose(w) != 0){
+        ret = -1;
+    }
+    fclose(outF);
+
+    printf("%s: frames %zu-%zu\n", outFileName, firstFrame, lastFrame - 1);
+    return ret;
+}
+
+int main(int argc, const char** argv) {
+    if (argc<4) {
+        fprintf(stderr, "Split a zstd file in seekable zstd files at the given frame indexes, without decompressing it.\n");
+        fprintf(stderr, "Each shard starts at one of the frame indexes, the files are named <OUT PREFIX>.<N>.zst\n");
+        fprintf(stderr, "Usage: %s <IN>.zst <OUT PREFIX> <FRAME INDEX>...\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    size_t frames = ZSTDSeek_getJumpTableOfContext(sctx)->length - 1;
+    size_t firstFrame = 0;
+    int shard = 0;
+    for(int i = 3; i <= argc; i++){
+        size_t lastFrame = i < argc ? strtoull(argv[i], NULL, 10) : frames;
+        if(lastFrame <= firstFrame || lastFrame > frames){
+            fprintf(stderr, "Invalid frame index %zu, expected a value between %zu and %zu\n", lastFrame, firstFrame + 1, frames);
+            return -1;
+        }
+        if(writeShard(sctx, argv[2], shard++, firstFrame, lastFrame) != 0){
+            fprintf(stderr, "Can't write shard %d\n", shard - 1);
+            return -1;
+        }
+        firstFrame = lastFrame;
+        if(firstFrame == frames){
+            break;
+        }
+    }
+
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
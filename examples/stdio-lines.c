@@ -0,0 +1,66 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-stdio.h"
+
+//plain stdio code, unaware of zstd
+static int printLines(FILE *f, long offset, size_t count){
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t len;
+    if(fseek(f, offset > 0 ? offset - 1 : 0, SEEK_SET) != 0){
+        return -1;
+    }
+    if(offset > 0){ //skip up until the end of the line before offset
+        getline(&line, &capacity, f);
+    }
+    for(size_t i = 0; i < count && (len = getline(&line, &capacity, f)) >= 0; i++){
+        fwrite(line, 1, (size_t)len, stdout);
+    }
+    free(line);
+    return ferror(f) ? -1 : 0;
+}
+
+int main(int argc, const char** argv) {
+    if (argc!=4) {
+        fprintf(stderr, "Print COUNT lines of a zstd file starting from the first one that begins at or after OFFSET, reading it with fseek and getline\n");
+        fprintf(stderr, "Usage: %s <FILE>.zst <OFFSET> <COUNT>\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    FILE *f = ZSTDSeek_fopen(sctx);
+    if(!f){
+        perror("Can't open the stream");
+        return -1;
+    }
+
+    if(printLines(f, strtol(argv[2], NULL, 10), strtoull(argv[3], NULL, 10)) != 0){
+        fprintf(stderr, "Error while reading\n");
+        return -1;
+    }
+
+    fclose(f);
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-reverse.h"
+
+#define BUFFSIZE (128*1024)
+
+int main(int argc, const char** argv) {
+    int reverse = argc == 3 && strcmp(argv[1], "-r") == 0;
+    if (argc!=2 && argc!=3) {
+        fprintf(stderr, "Print the last N lines of a zstd file, 10 by default, or all of them from the last to the first like tac\n");
+        fprintf(stderr, "Usage: %s [-r | <N>] <FILE>.zst\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[argc-1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    ZSTDSeek_ReverseReader *reader = ZSTDSeek_createReverseReader(sctx, 1);
+    if(!reader){
+        fprintf(stderr, "Can't create the reader\n");
+        return -1;
+    }
+
+    int ret = 0;
+    const void *line;
+    size_t size;
+    size_t pos = ZSTDSeek_uncompressedFileSize(sctx);
+    size_t n = reverse ? SIZE_MAX : argc == 3 ? strtoull(argv[1], NULL, 10) : 10;
+    for(size_t i = 0; i < n && (ret = ZSTDSeek_readPreviousRecord(reader, '\n', &line, &size, &pos)) == 1; i++){
+        if(reverse){
+            fwrite(line, size, 1, stdout);
+            putchar('\n');
+        }
+    }
+    if(ret < 0){
+        fprintf(stderr, "Can't read the file\n");
+        return -1;
+    }
+
+    //the last lines are printed going forward from the first one
+    if(!reverse && ZSTDSeek_seek(sctx, (long)pos, SEEK_SET) == 0){
+        uint8_t buff[BUFFSIZE];
+        size_t len;
+        while((len = ZSTDSeek_read(buff, BUFFSIZE, sctx)) > 0 && len != (size_t)ZSTDSEEK_ERR_READ){
+            fwrite(buff, len, 1, stdout);
+        }
+    }
+
+    ZSTDSeek_freeReverseReader(reader);
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-tar.h"
+
+#define BUFFSIZE (128*1024)
+
+static ZSTDSeek_TarIndex* openIndex(ZSTDSeek_Context *sctx, const char *archive){
+    char indexFile[4096];
+    snprintf(indexFile, sizeof(indexFile), "%s.idx", archive);
+
+    ZSTDSeek_TarIndex *index = ZSTDSeek_loadTarIndex(sctx, indexFile);
+    if(index){
+        return index;
+    }
+
+    index = ZSTDSeek_buildTarIndex(sctx, 0);
+    if(index && ZSTDSeek_saveTarIndex(index, indexFile) != 0){
+        fprintf(stderr, "Can't save the index to %s\n", indexFile);
+    }
+    return index;
+}
+
+//create the parent directories of path, refusing to go outside of the output directory
+static int makeParents(char *path){
+    if(path[0] == '/' || strstr(path, "../") == path || strstr(path, "/../")){
+        return -1;
+    }
+    for(char *p = strchr(path, '/'); p; p = strchr(p + 1, '/')){
+        *p = 0;
+        int ret = mkdir(path, 0755);
+        *p = '/';
+        if(ret != 0 && errno != EEXIST){
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int extractMember(const ZSTDSeek_TarMember *member, ZSTDSeek_Context *view, void *user){
+    char outFileName[4096];
+    snprintf(outFileName, sizeof(outFileName), "%s/%s", (const char *)user, member->path);
+    if(makeParents(outFileName) != 0){
+        fprintf(stderr, "Refusing to extract %s\n", member->path);
+        return 0;
+    }
+
+    FILE *outF = fopen(outFileName, "wb");
+    if(!outF){
+        fprintf(stderr, "Can't open out file %s\n", outFileName);
+        return 0;
+    }
+
+    uint8_t buff[BUFFSIZE];
+    size_t len;
+    while((len = ZSTDSeek_read(buff, BUFFSIZE, view)) > 0){
+        fwrite(buff, len, 1, outF);
+    }
+    fclose(outF);
+
+    printf("%s\n", member->path);
+    return 0;
+}
+
+int main(int argc, const char** argv) {
+    if (argc!=2 && argc<4) {
+        fprintf(stderr, "List or extract members of a .tar.zst using an index built in parallel and saved to <FILE>.tar.zst.idx\n");
+        fprintf(stderr, "Usage: %s <FILE>.tar.zst [<OUT DIR> <MEMBER>...]\n", argv[0]);
+        return 1;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return -1;
+    }
+
+    ZSTDSeek_TarIndex *index = openIndex(sctx, argv[1]);
+    if(!index){
+        fprintf(stderr, "Can't index the archive\n");
+        return -1;
+    }
+
+    if(argc == 2){
+        for(size_t i = 0; i < ZSTDSeek_tarIndexLength(index); i++){
+            const ZSTDSeek_TarMember *m = ZSTDSeek_getTarMember(index, i);
+            printf("%c %06o %12zu %12zu %s\n", m->type, m->mode, m->size, m->offset, m->path);
+        }
+    }else{
+        const ZSTDSeek_TarMember **members = malloc((argc - 3)*sizeof(ZSTDSeek_TarMember *));
+        size_t n = 0;
+        for(int i = 3; i < argc; i++){
+            const ZSTDSeek_TarMember *m = ZSTDSeek_findTarMember(index, argv[i]);
+            if(!m || m->type != '0'){
+                fprintf(stderr, "%s: not a regular file in the archive\n", argv[i]);
+                continue;
+            }
+            members[n++] = m;
+        }
+        if(ZSTDSeek_forEachTarMemberParallel(sctx, members, n, extractMember, (void *)argv[2], 0) != 0){
+            fprintf(stderr, "Extraction failed\n");
+            return -1;
+        }
+        free(members);
+    }
+
+    ZSTDSeek_freeTarIndex(index);
+    ZSTDSeek_free(sctx);
+
+    return 0;
+}
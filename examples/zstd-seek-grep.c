@@ -0,0 +1,126 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under both the MIT license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv3 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+****************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../zstd-seek.h"
+#include "../zstd-seek-search.h"
+
+typedef struct {
+    int count;      //-c
+    int offsets;    //-b
+    size_t matches;
+} GrepOptions;
+
+static int printLine(size_t pos, const void *data, size_t size, void *user){
+    GrepOptions *options = (GrepOptions *)user;
+    options->matches++;
+    if(!options->count){
+        if(options->offsets){
+            printf("%zu:", pos);
+        }
+        fwrite(data, size, 1, stdout);
+        fputc('\n', stdout);
+    }
+    return 0;
+}
+
+//a fixed string as a regular expression, to ignore the case
+static char* escapeRegex(const char *s){
+    char *regex = malloc(2*strlen(s) + 1);
+    char *p = regex;
+    for(; regex && *s; s++){
+        if(strchr("\\.[]{}()*+?^$|", *s)){
+            *p++ = '\\';
+        }
+        *p++ = *s;
+    }
+    if(regex){
+        *p = 0;
+    }
+    return regex;
+}
+
+int main(int argc, const char** argv) {
+    GrepOptions options = {0, 0, 0};
+    int regex = 0;
+    int ignoreCase = 0;
+    int nthreads = 0;
+
+    int i = 1;
+    for(; i < argc && argv[i][0] == '-'; i++){
+        if(strcmp(argv[i], "-E") == 0){
+            regex = 1;
+        }else if(strcmp(argv[i], "-i") == 0){
+            ignoreCase = 1;
+        }else if(strcmp(argv[i], "-c") == 0){
+            options.count = 1;
+        }else if(strcmp(argv[i], "-b") == 0){
+            options.offsets = 1;
+        }else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+            nthreads = atoi(argv[++i]);
+        }else{
+            break;
+        }
+    }
+    if (argc - i != 2) {
+        fprintf(stderr, "Print the lines of a zstd file that contain PATTERN, searching the frames in parallel\n");
+        fprintf(stderr, "Usage: %s [-E] [-i] [-c] [-b] [-j THREADS] <PATTERN> <FILE>.zst\n", argv[0]);
+        fprintf(stderr, "  -E  PATTERN is an extended regular expression, it's a fixed string otherwise\n");
+        fprintf(stderr, "  -i  ignore the case\n");
+        fprintf(stderr, "  -c  print only the number of matching lines\n");
+        fprintf(stderr, "  -b  print the position of each line in the uncompressed file\n");
+        fprintf(stderr, "  -j  the number of threads, one per CPU by default\n");
+        return 2;
+    }
+
+    ZSTDSeek_Pattern *pattern;
+    if(regex){
+        pattern = ZSTDSeek_createRegexPattern(argv[i], ignoreCase);
+    }else if(ignoreCase){
+        char *escaped = escapeRegex(argv[i]);
+        pattern = escaped ? ZSTDSeek_createRegexPattern(escaped, 1) : NULL;
+        free(escaped);
+    }else{
+        pattern = ZSTDSeek_createSubstringPattern(argv[i], strlen(argv[i]));
+    }
+    if(!pattern){
+        fprintf(stderr, "Invalid pattern\n");
+        return 2;
+    }
+
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFile(argv[i+1]);
+    if(!sctx){
+        fprintf(stderr, "Can't create the context\n");
+        return 2;
+    }
+
+    static char outBuff[1 << 20];
+    setvbuf(stdout, outBuff, _IOFBF, sizeof(outBuff));
+
+    if(ZSTDSeek_grepParallel(sctx, pattern, '\n', printLine, &options, nthreads) != 0){
+        fprintf(stderr, "Search failed\n");
+        return 2;
+    }
+    if(options.count){
+        printf("%zu\n", options.matches);
+    }
+    fflush(stdout);
+
+    ZSTDSeek_freePattern(pattern);
+    ZSTDSeek_free(sctx);
+
+    return options.matches ? 0 : 1;
+}
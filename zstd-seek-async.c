@@ -0,0 +1,348 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "zstd-seek-async.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+typedef struct ZSTDSeek_AsyncRequest_s{
+    ZSTDSeek_AsyncCompletion completion;
+    struct ZSTDSeek_AsyncRequest_s *next;
+} ZSTDSeek_AsyncRequest;
+
+typedef struct{
+    ZSTDSeek_AsyncRequest *head;
+    ZSTDSeek_AsyncRequest *tail;
+} ZSTDSeek_AsyncQueue;
+
+struct ZSTDSeek_AsyncReader_s{
+    ZSTDSeek_Context *sctx;
+    size_t size;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t submitted; //wakes up the workers
+    pthread_cond_t completed; //wakes up ZSTDSeek_waitCompletion
+    ZSTDSeek_AsyncQueue queued;
+    ZSTDSeek_AsyncQueue done;
+    size_t pending; //the reads submitted and not reaped yet
+    uint64_t nextId;
+    int stop;
+
+    int readFd;  //the same eventfd on Linux, a pipe elsewhere
+    int writeFd;
+
+    ZSTDSeek_Context **views;
+    int nviews;
+    pthread_t *threads;
+    int nthreads; //the threads started
+};
+
+void ZSTDSeek_asyncPush(ZSTDSeek_AsyncQueue *queue, ZSTDSeek_AsyncRequest *request){
+    request->next = NULL;
+    if(queue->tail){
+        queue->tail->next = request;
+    }else{
+        queue->head = request;
+    }
+    queue->tail = request;
+}
+
+ZSTDSeek_AsyncRequest* ZSTDSeek_asyncPop(ZSTDSeek_AsyncQueue *queue){
+    ZSTDSeek_AsyncRequest *request = queue->head;
+    if(request){
+        queue->head = request->next;
+        if(!queue->head){
+            queue->tail = NULL;
+        }
+    }
+    return request;
+}
+
+/*
+ * Make the file descriptor readable if and only if there are completions, with the mutex held.
+ */
+void ZSTDSeek_asyncSignal(ZSTDSeek_AsyncReader *reader){
+#ifndef _WIN32
+    if(reader->readFd < 0){
+        return;
+    }
+    uint8_t drain[64];
+    while(read(reader->readFd, drain, sizeof(drain)) > 0); //an eventfd is reset by a single read
+    if(reader->done.head){
+        uint64_t one = 1;
+#ifdef __linux__
+        size_t size = sizeof(one);
+#else
+        size_t size = 1;
+#endif
+        if(write(reader->writeFd, &one, size) < 0){
+            DEBUG("Can't signal the completion\n");
+        }
+    }
+#endif
+}
+
+void ZSTDSeek_asyncRead(ZSTDSeek_AsyncReader *reader, ZSTDSeek_Context *view, ZSTDSeek_AsyncCompletion *completion){
+    size_t requested = completion->length;
+    completion->length = 0;
+    if(completion->offset >= reader->size){
+        return;
+    }
+    if(ZSTDSeek_seek(view, (long)completion->offset, SEEK_SET) != 0){
+        completion->length = ZSTDSEEK_ERR_READ;
+        return;
+    }
+    while(completion->length < requested){
+        size_t len = ZSTDSeek_read((uint8_t *)completion->buff + completion->length, requested - completion->length, view);
+        if(len == (size_t)ZSTDSEEK_ERR_READ){
+            completion->length = ZSTDSEEK_ERR_READ;
+            return;
+        }
+        if(len == 0){
+            return;
+        }
+        completion->length += len;
+    }
+}
+
+typedef struct{
+    ZSTDSeek_AsyncReader *reader;
+    ZSTDSeek_Context *view;
+} ZSTDSeek_AsyncWorker;
+
+void* ZSTDSeek_asyncWorker(void *arg){
+    ZSTDSeek_AsyncWorker *worker = (ZSTDSeek_AsyncWorker *)arg;
+    ZSTDSeek_AsyncReader *reader = worker->reader;
+    ZSTDSeek_Context *view = worker->view;
+    free(worker);
+
+    pthread_mutex_lock(&reader->mutex);
+    while(1){
+        while(!reader->stop && !reader->queued.head){
+            pthread_cond_wait(&reader->submitted, &reader->mutex);
+        }
+        if(reader->stop){
+            break;
+        }
+        ZSTDSeek_AsyncRequest *request = ZSTDSeek_asyncPop(&reader->queued);
+        pthread_mutex_unlock(&reader->mutex);
+
+        ZSTDSeek_asyncRead(reader, view, &request->completion);
+
+        pthread_mutex_lock(&reader->mutex);
+        int wasEmpty = reader->done.head == NULL;
+        ZSTDSeek_asyncPush(&reader->done, request);
+        if(wasEmpty){
+            ZSTDSeek_asyncSignal(reader);
+        }
+        pthread_cond_broadcast(&reader->completed);
+    }
+    pthread_mutex_unlock(&reader->mutex);
+    return NULL;
+}
+
+ZSTDSeek_AsyncReader* ZSTDSeek_createAsyncReader(ZSTDSeek_Context *sctx, int nthreads){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return NULL;
+    }
+    if(ZSTDSeek_initializeJumpTable(sctx) != 0){
+        return NULL;
+    }
+    if(nthreads <= 0){
+        nthreads = ZSTDSeek_defaultNumberOfThreads();
+    }
+
+    ZSTDSeek_AsyncReader *reader = calloc(1, sizeof(ZSTDSeek_AsyncReader));
+    if(!reader){
+        return NULL;
+    }
+    reader->sctx = sctx;
+    reader->size = ZSTDSeek_uncompressedFileSize(sctx);
+    reader->readFd = reader->writeFd = -1;
+
+#ifdef __linux__
+    reader->readFd = reader->writeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#elif !defined(_WIN32)
+    int fds[2];
+    if(pipe(fds) == 0){
+        reader->readFd = fds[0];
+        reader->writeFd = fds[1];
+        for(int i = 0; i < 2; i++){
+            fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+        }
+    }
+#endif
+#ifndef _WIN32
+    if(reader->readFd < 0){
+        DEBUG("Can't create the file descriptor\n");
+        free(reader);
+        return NULL;
+    }
+#endif
+
+    pthread_mutex_init(&reader->mutex, NULL);
+    pthread_cond_init(&reader->submitted, NULL);
+    pthread_cond_init(&reader->completed, NULL);
+
+    //the views are created here, the threads only use them
+    reader->views = calloc(nthreads, sizeof(ZSTDSeek_Context *));
+    reader->threads = calloc(nthreads, sizeof(pthread_t));
+    if(!reader->views || !reader->threads){
+        ZSTDSeek_freeAsyncReader(reader);
+        return NULL;
+    }
+    reader->nviews = nthreads;
+    for(int i = 0; i < nthreads; i++){
+        ZSTDSeek_AsyncWorker *worker = malloc(sizeof(ZSTDSeek_AsyncWorker));
+        reader->views[i] = ZSTDSeek_createView(sctx, 0, reader->size);
+        if(!worker || !reader->views[i]){
+            free(worker);
+            break;
+        }
+        worker->reader = reader;
+        worker->view = reader->views[i];
+        if(pthread_create(&reader->threads[i], NULL, ZSTDSeek_asyncWorker, worker) != 0){
+            free(worker);
+            break;
+        }
+        reader->nthreads++;
+    }
+    if(reader->nthreads == 0){
+        DEBUG("Can't start the threads\n");
+        ZSTDSeek_freeAsyncReader(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+int ZSTDSeek_submitRead(ZSTDSeek_AsyncReader *reader, void *buff, size_t offset, size_t length, void *user, uint64_t *id){
+    if(!reader || (!buff && length > 0)){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    ZSTDSeek_AsyncRequest *request = malloc(sizeof(ZSTDSeek_AsyncRequest));
+    if(!request){
+        return -1;
+    }
+    request->completion.buff = buff;
+    request->completion.offset = offset;
+    request->completion.length = length; //the worker replaces it with the bytes read
+    request->completion.user = user;
+
+    pthread_mutex_lock(&reader->mutex);
+    request->completion.id = reader->nextId++;
+    if(id){
+        *id = request->completion.id;
+    }
+    ZSTDSeek_asyncPush(&reader->queued, request);
+    reader->pending++;
+    pthread_cond_signal(&reader->submitted);
+    pthread_mutex_unlock(&reader->mutex);
+    return 0;
+}
+
+int ZSTDSeek_asyncFd(ZSTDSeek_AsyncReader *reader){
+    return reader ? reader->readFd : -1;
+}
+
+size_t ZSTDSeek_reapCompletions(ZSTDSeek_AsyncReader *reader, ZSTDSeek_AsyncCompletion *completions, size_t max){
+    if(!reader || (!completions && max > 0)){
+        DEBUG("Invalid argument\n");
+        return 0;
+    }
+
+    size_t count = 0;
+    pthread_mutex_lock(&reader->mutex);
+    ZSTDSeek_AsyncRequest *request;
+    while(count < max && (request = ZSTDSeek_asyncPop(&reader->done))){
+        completions[count++] = request->completion;
+        reader->pending--;
+        free(request);
+    }
+    if(count > 0){
+        ZSTDSeek_asyncSignal(reader);
+    }
+    pthread_mutex_unlock(&reader->mutex);
+    return count;
+}
+
+int ZSTDSeek_waitCompletion(ZSTDSeek_AsyncReader *reader, ZSTDSeek_AsyncCompletion *completion){
+    if(!reader || !completion){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&reader->mutex);
+    while(!reader->done.head && reader->pending > 0){
+        pthread_cond_wait(&reader->completed, &reader->mutex);
+    }
+    ZSTDSeek_AsyncRequest *request = ZSTDSeek_asyncPop(&reader->done);
+    if(request){
+        *completion = request->completion;
+        reader->pending--;
+        free(request);
+        ZSTDSeek_asyncSignal(reader);
+    }
+    pthread_mutex_unlock(&reader->mutex);
+    return request ? 0 : -1;
+}
+
+void ZSTDSeek_freeAsyncReader(ZSTDSeek_AsyncReader *reader){
+    if(!reader){
+        return;
+    }
+
+    pthread_mutex_lock(&reader->mutex);
+    reader->stop = 1;
+    pthread_cond_broadcast(&reader->submitted);
+    pthread_mutex_unlock(&reader->mutex);
+    for(int i = 0; i < reader->nthreads; i++){
+        pthread_join(reader->threads[i], NULL);
+    }
+
+    ZSTDSeek_AsyncQueue *queues[2] = {&reader->queued, &reader->done};
+    for(int i = 0; i < 2; i++){
+        ZSTDSeek_AsyncRequest *request;
+        while((request = ZSTDSeek_asyncPop(queues[i]))){
+            free(request);
+        }
+    }
+    for(int i = 0; i < reader->nviews; i++){
+        if(reader->views[i]){
+            ZSTDSeek_free(reader->views[i]);
+        }
+    }
+#ifndef _WIN32
+    if(reader->writeFd != reader->readFd){
+        close(reader->writeFd);
+    }
+    close(reader->readFd);
+#endif
+    pthread_cond_destroy(&reader->completed);
+    pthread_cond_destroy(&reader->submitted);
+    pthread_mutex_destroy(&reader->mutex);
+    free(reader->views);
+    free(reader->threads);
+    free(reader);
+}
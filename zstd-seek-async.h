@@ -0,0 +1,78 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_ASYNC_
+#define _ZSTD_SEEK_ASYNC_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Structs */
+
+typedef struct ZSTDSeek_AsyncReader_s ZSTDSeek_AsyncReader;
+
+typedef struct{
+    uint64_t id;   //the id set by ZSTDSeek_submitRead
+    void *buff;
+    size_t offset;
+    size_t length; //the bytes read in buff, less than requested at the end of the context, ZSTDSEEK_ERR_READ in case of failure
+    void *user;
+} ZSTDSeek_AsyncCompletion;
+
+/* Async API */
+
+/*
+ * Create a reader that serves reads of sctx on a pool of nthreads threads (<= 0 means one per CPU), each with its own view,
+ * so an event loop can read without waiting for the frames to be decompressed or the pages of the file to be loaded.
+ * The jump table of sctx is fully initialized first. sctx must outlive the reader.
+ * Returns 0 in case of failure.
+ */
+ZSTDSeek_AsyncReader* ZSTDSeek_createAsyncReader(ZSTDSeek_Context *sctx, int nthreads);
+
+/*
+ * Queue a read of length bytes from offset into buff, that must stay valid until its completion.
+ * id, if not NULL, is set to an identifier of the read, it's in the completion along with user.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_submitRead(ZSTDSeek_AsyncReader *reader, void *buff, size_t offset, size_t length, void *user, uint64_t *id);
+
+/*
+ * Returns a file descriptor that is readable while there are completions to reap, to wait with epoll, poll or select.
+ * It's an eventfd on Linux and a pipe elsewhere. Don't read or close it.
+ * Returns -1 if not available, eg on Windows, use ZSTDSeek_waitCompletion instead.
+ */
+int ZSTDSeek_asyncFd(ZSTDSeek_AsyncReader *reader);
+
+/*
+ * Copy up to max completed reads in completions, without waiting.
+ * Returns how many.
+ */
+size_t ZSTDSeek_reapCompletions(ZSTDSeek_AsyncReader *reader, ZSTDSeek_AsyncCompletion *completions, size_t max);
+
+/*
+ * Wait for a read to complete and copy it in completion.
+ * Returns 0 on success, -1 if there are no reads queued.
+ */
+int ZSTDSeek_waitCompletion(ZSTDSeek_AsyncReader *reader, ZSTDSeek_AsyncCompletion *completion);
+
+/*
+ * Free the reader. The reads in progress are waited for, the ones not started yet are discarded.
+ */
+void ZSTDSeek_freeAsyncReader(ZSTDSeek_AsyncReader *reader);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,140 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_ASYNC_HPP_
+#define _ZSTD_SEEK_ASYNC_HPP_
+
+/*
+ * C++20 coroutines on top of the async API, header only.
+ *
+ *     zstdseek::AsyncReader reader(sctx);
+ *     //register reader.fd() in the event loop, when it's readable call reader.poll()
+ *     size_t n = co_await reader.read(buff, offset, length);
+ *
+ * The coroutines are resumed by poll, in the thread of the event loop, never by the threads of the reader.
+ * The failure to create the reader throws std::runtime_error.
+ */
+
+#include <coroutine>
+#include <cstddef>
+#include <stdexcept>
+#include "zstd-seek-async.h"
+
+namespace zstdseek {
+
+class AsyncReader {
+public:
+    explicit AsyncReader(ZSTDSeek_Context *sctx, int nthreads = 0) : reader(ZSTDSeek_createAsyncReader(sctx, nthreads)) {
+        if(!reader){
+            throw std::runtime_error("Can't create the async reader");
+        }
+    }
+
+    ~AsyncReader() {
+        ZSTDSeek_freeAsyncReader(reader);
+    }
+
+    AsyncReader(const AsyncReader&) = delete;
+    AsyncReader& operator=(const AsyncReader&) = delete;
+
+    class ReadAwaiter {
+    public:
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) noexcept {
+            handle = h;
+            if(ZSTDSeek_submitRead(reader, buff, offset, length, this, nullptr) != 0){
+                result = (size_t)ZSTDSEEK_ERR_READ;
+                return false; //resume now
+            }
+            return true;
+        }
+
+        /*
+         * The bytes read, less than requested at the end of the context, ZSTDSEEK_ERR_READ in case of failure.
+         */
+        size_t await_resume() const noexcept {
+            return result;
+        }
+
+    private:
+        friend class AsyncReader;
+
+        ReadAwaiter(ZSTDSeek_AsyncReader *reader, void *buff, size_t offset, size_t length) noexcept
+            : reader(reader), buff(buff), offset(offset), length(length) {}
+
+        ZSTDSeek_AsyncReader *reader;
+        void *buff;
+        size_t offset;
+        size_t length;
+        size_t result = 0;
+        std::coroutine_handle<> handle;
+    };
+
+    /*
+     * Read length bytes from offset into buff, that must stay valid until the read is resumed.
+     */
+    ReadAwaiter read(void *buff, size_t offset, size_t length) noexcept {
+        return ReadAwaiter(reader, buff, offset, length);
+    }
+
+    /*
+     * The file descriptor to wait for in the event loop, see ZSTDSeek_asyncFd.
+     */
+    int fd() const noexcept {
+        return ZSTDSeek_asyncFd(reader);
+    }
+
+    /*
+     * Resume the coroutines whose reads are complete, without waiting. Returns how many.
+     */
+    size_t poll() {
+        ZSTDSeek_AsyncCompletion completions[64];
+        size_t total = 0;
+        size_t count;
+        while((count = ZSTDSeek_reapCompletions(reader, completions, 64)) > 0){
+            for(size_t i = 0; i < count; i++){
+                ReadAwaiter *awaiter = static_cast<ReadAwaiter *>(completions[i].user);
+                awaiter->result = completions[i].length;
+                awaiter->handle.resume();
+            }
+            total += count;
+        }
+        return total;
+    }
+
+    /*
+     * Wait for a read to complete and resume its coroutine. Returns false if there are no reads in progress.
+     */
+    bool wait() {
+        ZSTDSeek_AsyncCompletion completion;
+        if(ZSTDSeek_waitCompletion(reader, &completion) != 0){
+            return false;
+        }
+        ReadAwaiter *awaiter = static_cast<ReadAwaiter *>(completion.user);
+        awaiter->result = completion.length;
+        awaiter->handle.resume();
+        return true;
+    }
+
+    ZSTDSeek_AsyncReader* get() const noexcept {
+        return reader;
+    }
+
+private:
+    ZSTDSeek_AsyncReader *reader;
+};
+
+}
+
+#endif
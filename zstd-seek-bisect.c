@@ -0,0 +1,447 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "zstd-seek-bisect.h"
+#include "zstd-seek-internal.h"
+
+#define BISECT_BUFFSIZE (64*1024)
+
+#define BISECT_PENDING 0
+#define BISECT_FOUND 1
+#define BISECT_NONE 2
+
+struct ZSTDSeek_KeySummary_s{
+    uint8_t delimiter;
+    size_t keySize;
+    size_t length;         //the number of frames in the context
+    size_t *starts;        //where each frame begins in the context
+    size_t *positions;     //where the representative of each frame begins, SIZE_MAX if there is none
+    uint8_t *keys;         //the key of each representative, keySize bytes each
+    size_t compressedSize; //the file the summary was built for
+    uint64_t fileHash;
+    size_t viewStart;
+    size_t size;
+};
+
+typedef struct{
+    ZSTDSeek_Context *sctx;
+    uint8_t delimiter;
+    uint8_t *buff;
+    size_t capacity;
+    size_t begin;   //the unread data is buff[begin, end)
+    size_t end;
+    size_t scanned; //buff[begin, scanned) has no delimiter
+    size_t pos;     //the position of buff[begin] in the context
+    int eof;
+} ZSTDSeek_BisectReader;
+
+typedef struct{
+    const ZSTDSeek_KeyFunctions *kf;
+    ZSTDSeek_KeySummary *summary;
+    uint8_t *status;
+    size_t end;
+} ZSTDSeek_BisectScan;
+
+int ZSTDSeek_bisectReaderStart(ZSTDSeek_BisectReader *r, size_t pos){
+    r->begin = r->end = r->scanned = 0;
+    r->pos = pos;
+    r->eof = 0;
+    return ZSTDSeek_seek(r->sctx, (long)pos, SEEK_SET);
+}
+
+/*
+ * Returns 1 and the next record, without the delimiter, 0 at the end of the file, -1 on failure.
+ */
+int ZSTDSeek_bisectNextRecord(ZSTDSeek_BisectReader *r, const uint8_t **record, size_t *size, size_t *recordPos){
+    while(1){
+        uint8_t *d = memchr(r->buff + r->scanned, r->delimiter, r->end - r->scanned);
+        if(d || (r->eof && r->end > r->begin)){
+            size_t len = (d ? (size_t)(d - r->buff) : r->end) - r->begin;
+            size_t consumed = len + (d ? 1 : 0);
+            *record = r->buff + r->begin;
+            *size = len;
+            *recordPos = r->pos;
+            r->begin += consumed;
+            r->scanned = r->begin;
+            r->pos += consumed;
+            return 1;
+        }
+        if(r->eof){
+            return 0;
+        }
+        r->scanned = r->end;
+
+        //make room for the rest of the record
+        if(r->begin > 0){
+            memmove(r->buff, r->buff + r->begin, r->end - r->begin);
+            r->end -= r->begin;
+            r->scanned -= r->begin;
+            r->begin = 0;
+        }
+        if(r->end == r->capacity){
+            size_t capacity = r->capacity ? r->capacity*2 : BISECT_BUFFSIZE;
+            uint8_t *tmp = realloc(r->buff, capacity);
+            if(!tmp){
+                return -1;
+            }
+            r->buff = tmp;
+            r->capacity = capacity;
+        }
+
+        size_t len = ZSTDSeek_read(r->buff + r->end, r->capacity - r->end, r->sctx);
+        if(len == (size_t)ZSTDSEEK_ERR_READ){
+            return -1;
+        }
+        if(len == 0){
+            r->eof = 1;
+        }
+        r->end += len;
+    }
+}
+
+/*
+ * Find the representative of the frame starting at start.
+ * Returns 1 if found, 0 if no record with a key begins after start, -1 on failure.
+ */
+int ZSTDSeek_bisectProbe(ZSTDSeek_BisectReader *r, const ZSTDSeek_KeyFunctions *kf, size_t start, void *key, size_t *pos){
+    if(ZSTDSeek_bisectReaderStart(r, start) != 0){
+        return -1;
+    }
+
+    const uint8_t *record;
+    size_t size;
+    size_t recordPos;
+    int ret;
+    if(start > 0 && (ret = ZSTDSeek_bisectNextRecord(r, &record, &size, &recordPos)) != 1){ //the record that crosses start belongs to the previous frame
+        return ret;
+    }
+    while((ret = ZSTDSeek_bisectNextRecord(r, &record, &size, &recordPos)) == 1){
+        if(kf->extract(record, size, key, kf->user) == 0){
+            *pos = recordPos;
+            return 1;
+        }
+    }
+    return ret;
+}
+
+/*
+ * Where the frames covered by sctx begin, in the coordinates of sctx.
+ */
+size_t* ZSTDSeek_bisectFrameStarts(ZSTDSeek_Context *sctx, size_t *length){
+    ZSTDSeek_FrameRange *ranges = ZSTDSeek_frameRanges(sctx, length);
+    size_t *starts = ranges ? malloc((*length > 0 ? *length : 1)*sizeof(size_t)) : NULL;
+    if(!starts){
+        free(ranges);
+        return NULL;
+    }
+
+    size_t start = ZSTDSeek_getViewStart(sctx);
+    for(size_t i = 0; i < *length; i++){
+        starts[i] = ranges[i].start - start;
+    }
+    free(ranges);
+    return starts;
+}
+
+int ZSTDSeek_bisect(ZSTDSeek_Context *sctx, const ZSTDSeek_KeyFunctions *kf, ZSTDSeek_KeySummary *summary, const void *key, size_t *pos){
+    if(!sctx || !kf || !kf->extract || !kf->compare || !key || kf->keySize == 0){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    size_t length = 0;
+    size_t *starts = summary ? summary->starts : ZSTDSeek_bisectFrameStarts(sctx, &length);
+    if(summary){
+        length = summary->length;
+    }
+    ZSTDSeek_BisectReader r = {sctx, kf->delimiter, NULL, 0, 0, 0, 0, 0, 0};
+    uint8_t *probeKey = malloc(kf->keySize);
+    int ret = -1;
+    if(!starts || !probeKey){
+        goto cleanup;
+    }
+
+    //find the first frame whose representative is not smaller than key, the record is in the frame before it
+    size_t lo = 0;
+    size_t hi = length;
+    size_t scanFrom = 0; //the position of the representative of the frame before lo
+    while(lo < hi){
+        size_t m = lo + (hi-lo)/2;
+        int found;
+        size_t probePos = SIZE_MAX;
+        if(summary){
+            probePos = summary->positions[m];
+            found = probePos != SIZE_MAX;
+            if(found){
+                memcpy(probeKey, summary->keys + m*kf->keySize, kf->keySize);
+            }
+        }else if((found = ZSTDSeek_bisectProbe(&r, kf, starts[m], probeKey, &probePos)) < 0){
+            goto cleanup;
+        }
+
+        if(found && kf->compare(probeKey, key, kf->user) < 0){
+            lo = m + 1;
+            scanFrom = probePos;
+        }else{
+            hi = m;
+        }
+    }
+
+    //then scan that frame
+    const uint8_t *record;
+    size_t size;
+    size_t recordPos = ZSTDSeek_uncompressedFileSize(sctx);
+    int next;
+    if(ZSTDSeek_bisectReaderStart(&r, scanFrom) != 0){
+        goto cleanup;
+    }
+    while((next = ZSTDSeek_bisectNextRecord(&r, &record, &size, &recordPos)) == 1){
+        if(kf->extract(record, size, probeKey, kf->user) == 0 && kf->compare(probeKey, key, kf->user) >= 0){
+            break;
+        }
+    }
+    if(next < 0){
+        goto cleanup;
+    }
+    if(next == 0){
+        recordPos = ZSTDSeek_uncompressedFileSize(sctx);
+    }
+
+    if(pos){
+        *pos = recordPos;
+    }
+    ret = ZSTDSeek_seek(sctx, (long)recordPos, SEEK_SET);
+
+cleanup:
+    if(!summary){
+        free(starts);
+    }
+    free(probeKey);
+    free(r.buff);
+    return ret;
+}
+
+int ZSTDSeek_bisectScanFrame(const void *data, size_t size, size_t uncompressedPos, size_t frame, void *user){
+    (void)frame;
+    ZSTDSeek_BisectScan *scan = (ZSTDSeek_BisectScan *)user;
+    ZSTDSeek_KeySummary *summary = scan->summary;
+    if(size == 0){
+        return 0;
+    }
+
+    //the frames are the same of ZSTDSeek_bisectFrameStarts, with strictly increasing starts
+    size_t l = 0;
+    size_t r = summary->length;
+    while(r - l > 1){
+        size_t m = l + (r-l)/2;
+        if(summary->starts[m] > uncompressedPos){
+            r = m;
+        }else{
+            l = m;
+        }
+    }
+
+    //look for the representative among the records that end in this frame, the others are left to ZSTDSeek_bisectProbe
+    const uint8_t *p = (const uint8_t *)data;
+    const uint8_t *end = p + size;
+    int last = uncompressedPos + size == scan->end;
+    if(uncompressedPos > 0){
+        p = memchr(p, scan->kf->delimiter, size);
+        if(!p){
+            return 0;
+        }
+        p++;
+    }
+    while(p < end){
+        const uint8_t *d = memchr(p, scan->kf->delimiter, end - p);
+        if(!d && !last){
+            return 0;
+        }
+        if(scan->kf->extract(p, (d ? d : end) - p, summary->keys + l*summary->keySize, scan->kf->user) == 0){
+            summary->positions[l] = uncompressedPos + (p - (const uint8_t *)data);
+            scan->status[l] = BISECT_FOUND;
+            return 0;
+        }
+        p = d ? d + 1 : end;
+    }
+    if(last){
+        scan->status[l] = BISECT_NONE;
+    }
+    return 0;
+}
+
+ZSTDSeek_KeySummary* ZSTDSeek_newKeySummary(ZSTDSeek_Context *sctx, const ZSTDSeek_KeyFunctions *kf, size_t length){
+    ZSTDSeek_KeySummary *summary = calloc(1, sizeof(ZSTDSeek_KeySummary));
+    if(!summary){
+        return NULL;
+    }
+    summary->delimiter = kf->delimiter;
+    summary->keySize = kf->keySize;
+    summary->length = length;
+    summary->viewStart = ZSTDSeek_getViewStart(sctx);
+    summary->size = ZSTDSeek_uncompressedFileSize(sctx);
+    ZSTDSeek_getCompressedBuffer(sctx, &summary->compressedSize);
+    summary->fileHash = ZSTDSeek_fileHash(sctx);
+    summary->positions = malloc((length ? length : 1)*sizeof(size_t));
+    summary->keys = malloc((length ? length : 1)*kf->keySize);
+    if(!summary->positions || !summary->keys){
+        ZSTDSeek_freeKeySummary(summary);
+        return NULL;
+    }
+    for(size_t i = 0; i < length; i++){
+        summary->positions[i] = SIZE_MAX;
+    }
+    return summary;
+}
+
+ZSTDSeek_KeySummary* ZSTDSeek_buildKeySummary(ZSTDSeek_Context *sctx, const ZSTDSeek_KeyFunctions *kf, int nthreads){
+    if(!sctx || !kf || !kf->extract || kf->keySize == 0){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+
+    size_t length;
+    size_t *starts = ZSTDSeek_bisectFrameStarts(sctx, &length);
+    if(!starts){
+        return NULL;
+    }
+    ZSTDSeek_KeySummary *summary = ZSTDSeek_newKeySummary(sctx, kf, length);
+    if(!summary){
+        free(starts);
+        return NULL;
+    }
+    summary->starts = starts;
+
+    ZSTDSeek_BisectScan scan = {kf, summary, calloc(length ? length : 1, 1), summary->size};
+    if(!scan.status || ZSTDSeek_forEachFrameParallel(sctx, ZSTDSeek_bisectScanFrame, &scan, nthreads) != 0){
+        DEBUG("Can't scan the frames\n");
+        goto fail;
+    }
+
+    //the representatives that cross the end of their frame are decoded on their own
+    ZSTDSeek_BisectReader r = {sctx, kf->delimiter, NULL, 0, 0, 0, 0, 0, 0};
+    for(size_t i = 0; i < length; i++){
+        if(scan.status[i] == BISECT_PENDING &&
+           ZSTDSeek_bisectProbe(&r, kf, starts[i], summary->keys + i*kf->keySize, &summary->positions[i]) < 0){
+            free(r.buff);
+            goto fail;
+        }
+    }
+    free(r.buff);
+
+    free(scan.status);
+    return summary;
+
+fail:
+    free(scan.status);
+    ZSTDSeek_freeKeySummary(summary);
+    return NULL;
+}
+
+int ZSTDSeek_saveKeySummary(ZSTDSeek_KeySummary *summary, const char *file){
+    if(!summary || !file){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    FILE *f = fopen(file, "wb");
+    if(!f){
+        DEBUG("Unable to open '%s'\n", file);
+        return -1;
+    }
+
+    int ret = ZSTDSeek_writeLE(f, ZSTDSEEK_KEY_SUMMARY_MAGICNUMBER, 8) |
+              ZSTDSeek_writeLE(f, ZSTDSEEK_KEY_SUMMARY_VERSION, 8) |
+              ZSTDSeek_writeLE(f, summary->compressedSize, 8) |
+              ZSTDSeek_writeLE(f, summary->fileHash, 8) |
+              ZSTDSeek_writeLE(f, summary->viewStart, 8) |
+              ZSTDSeek_writeLE(f, summary->size, 8) |
+              ZSTDSeek_writeLE(f, summary->delimiter, 8) |
+              ZSTDSeek_writeLE(f, summary->keySize, 8) |
+              ZSTDSeek_writeLE(f, summary->length, 8);
+    for(size_t i = 0; i < summary->length && ret == 0; i++){
+        ret = ZSTDSeek_writeLE(f, summary->starts[i], 8) |
+              ZSTDSeek_writeLE(f, summary->positions[i] == SIZE_MAX ? UINT64_MAX : summary->positions[i], 8);
+        if(ret == 0 && fwrite(summary->keys + i*summary->keySize, 1, summary->keySize, f) != summary->keySize){
+            ret = -1;
+        }
+    }
+
+    if(fclose(f) != 0){
+        ret = -1;
+    }
+    return ret;
+}
+
+ZSTDSeek_KeySummary* ZSTDSeek_loadKeySummary(ZSTDSeek_Context *sctx, const ZSTDSeek_KeyFunctions *kf, const char *file){
+    if(!sctx || !kf || kf->keySize == 0 || !file){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+
+    FILE *f = fopen(file, "rb");
+    if(!f){
+        DEBUG("Unable to open '%s'\n", file);
+        return NULL;
+    }
+
+    ZSTDSeek_KeySummary *summary = NULL;
+    uint64_t magic, version, compressedSize, fileHash, viewStart, size, delimiter, keySize, length;
+    size_t sctxCompressedSize;
+    ZSTDSeek_getCompressedBuffer(sctx, &sctxCompressedSize);
+    if(ZSTDSeek_readLE(f, &magic, 8) || ZSTDSeek_readLE(f, &version, 8) || ZSTDSeek_readLE(f, &compressedSize, 8) ||
+       ZSTDSeek_readLE(f, &fileHash, 8) || ZSTDSeek_readLE(f, &viewStart, 8) || ZSTDSeek_readLE(f, &size, 8) || ZSTDSeek_readLE(f, &delimiter, 8) ||
+       ZSTDSeek_readLE(f, &keySize, 8) || ZSTDSeek_readLE(f, &length, 8) ||
+       magic != ZSTDSEEK_KEY_SUMMARY_MAGICNUMBER || version != ZSTDSEEK_KEY_SUMMARY_VERSION ||
+       compressedSize != sctxCompressedSize || fileHash != ZSTDSeek_fileHash(sctx) || viewStart != ZSTDSeek_getViewStart(sctx) ||
+       size != ZSTDSeek_uncompressedFileSize(sctx) || delimiter != kf->delimiter || keySize != kf->keySize){
+        DEBUG("'%s' is not a key summary of this file\n", file);
+        goto fail;
+    }
+
+    summary = ZSTDSeek_newKeySummary(sctx, kf, length);
+    if(!summary || !(summary->starts = malloc((length ? length : 1)*sizeof(size_t)))){
+        goto fail;
+    }
+    for(size_t i = 0; i < length; i++){
+        uint64_t start, pos;
+        if(ZSTDSeek_readLE(f, &start, 8) || ZSTDSeek_readLE(f, &pos, 8) ||
+           fread(summary->keys + i*keySize, 1, keySize, f) != keySize){
+            goto fail;
+        }
+        summary->starts[i] = start;
+        summary->positions[i] = pos == UINT64_MAX ? SIZE_MAX : pos;
+    }
+
+    fclose(f);
+    return summary;
+
+fail:
+    fclose(f);
+    if(summary){
+        ZSTDSeek_freeKeySummary(summary);
+    }
+    return NULL;
+}
+
+void ZSTDSeek_freeKeySummary(ZSTDSeek_KeySummary *summary){
+    if(!summary){
+        DEBUG("Invalid argument\n");
+        return;
+    }
+    free(summary->starts);
+    free(summary->positions);
+    free(summary->keys);
+    free(summary);
+}
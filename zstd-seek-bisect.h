@@ -0,0 +1,88 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_BISECT_
+#define _ZSTD_SEEK_BISECT_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Key summary constants */
+#define ZSTDSEEK_KEY_SUMMARY_MAGICNUMBER 0x534B535A //"ZSKS"
+#define ZSTDSEEK_KEY_SUMMARY_VERSION 2
+
+/* Structs */
+
+/*
+ * Extract the key of a record, without the delimiter, into key, which is keySize bytes.
+ * Return 0 on success, anything else if the record has no key, eg an empty line. Records without a key are skipped.
+ */
+typedef int (*ZSTDSeek_KeyExtractor)(const void *record, size_t size, void *key, void *user);
+
+/*
+ * Compare two keys like memcmp.
+ */
+typedef int (*ZSTDSeek_KeyComparator)(const void *a, const void *b, void *user);
+
+typedef struct{
+    uint8_t delimiter;             //the byte that ends the records, eg '\n'
+    size_t keySize;                //the size of a key, keys have a fixed size
+    ZSTDSeek_KeyExtractor extract;
+    ZSTDSeek_KeyComparator compare;
+    void *user;                    //passed to extract and compare
+} ZSTDSeek_KeyFunctions;
+
+typedef struct ZSTDSeek_KeySummary_s ZSTDSeek_KeySummary;
+
+/* Bisect API */
+
+/*
+ * Seek sctx to the first record with a key greater than or equal to key. The records must be sorted by key.
+ * Every frame is represented by the first record that begins after its first byte, or by the first record of the file for the first frame.
+ * Without a summary the representatives of O(log(frames)) frames are decoded to find the frame where the record is, then only that frame is scanned.
+ * With a summary built by ZSTDSeek_buildKeySummary only that frame is decoded.
+ * If pos is not NULL the position of the record is written there, it's the size of the file if all the keys are smaller.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_bisect(ZSTDSeek_Context *sctx, const ZSTDSeek_KeyFunctions *kf, ZSTDSeek_KeySummary *summary, const void *key, size_t *pos);
+
+/*
+ * Build the summary of sctx used by ZSTDSeek_bisect, ie the key of the representative of every frame.
+ * The keys of a frame are within its key and the one of the next frame.
+ * The frames are decompressed on nthreads threads, <= 0 means one per CPU, so kf->extract must be thread safe.
+ * Returns 0 in case of failure.
+ */
+ZSTDSeek_KeySummary* ZSTDSeek_buildKeySummary(ZSTDSeek_Context *sctx, const ZSTDSeek_KeyFunctions *kf, int nthreads);
+
+/*
+ * Save the summary to file. Returns 0 on success.
+ */
+int ZSTDSeek_saveKeySummary(ZSTDSeek_KeySummary *summary, const char *file);
+
+/*
+ * Load a summary saved with ZSTDSeek_saveKeySummary for sctx.
+ * Returns 0 in case of failure or if it was built for a different file, delimiter or key size.
+ */
+ZSTDSeek_KeySummary* ZSTDSeek_loadKeySummary(ZSTDSeek_Context *sctx, const ZSTDSeek_KeyFunctions *kf, const char *file);
+
+/*
+ * Free the summary.
+ */
+void ZSTDSeek_freeKeySummary(ZSTDSeek_KeySummary *summary);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,553 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "zstd-seek-bloom.h"
+#include "zstd-seek-internal.h"
+
+#define BLOOM_HASHES 7                 //the optimal number for ZSTDSEEK_BLOOM_BITS_PER_TOKEN bits per token
+#define BLOOM_CONTINUES 1              //the frame begins inside a token that begins in a previous frame
+#define BLOOM_OVERFLOW (ZSTDSEEK_BLOOM_MAX_TOKEN_SIZE + 1)
+
+struct ZSTDSeek_BloomIndex_s{
+    uint8_t isToken[256];
+    size_t length;         //the number of frames
+    uint64_t *offsets;     //where the filter of each frame begins in words, length+1 entries
+    uint64_t *words;
+    uint8_t *flags;
+    size_t compressedSize; //the size of the file the index was built for
+    uint64_t fileHash;     //and its fingerprint
+};
+
+typedef struct{
+    uint64_t *words;
+    size_t nwords;
+    size_t size;
+    int allToken;                  //the frame has no separators
+    uint8_t head[BLOOM_OVERFLOW];  //the token at the beginning of the frame, it may continue a previous one
+    size_t headSize;               //BLOOM_OVERFLOW if too long to be indexed
+    uint8_t tail[BLOOM_OVERFLOW];  //the token at the end of the frame, it may continue in the next one
+    size_t tailSize;
+} ZSTDSeek_BloomFrame;
+
+typedef struct{
+    ZSTDSeek_BloomIndex *index;
+    ZSTDSeek_BloomFrame *frames;
+} ZSTDSeek_BloomBuild;
+
+void ZSTDSeek_bloomAdd(uint64_t *words, size_t nwords, uint64_t h){
+    uint64_t bits = (uint64_t)nwords*64;
+    uint64_t h2 = (h >> 32) | 1;
+    for(uint64_t i = 0; i < BLOOM_HASHES; i++){
+        uint64_t b = (h + i*h2) % bits;
+        words[b/64] |= 1ULL << (b%64);
+    }
+}
+
+int ZSTDSeek_bloomTest(const uint64_t *words, size_t nwords, uint64_t h){
+    uint64_t bits = (uint64_t)nwords*64;
+    uint64_t h2 = (h >> 32) | 1;
+    for(uint64_t i = 0; i < BLOOM_HASHES; i++){
+        uint64_t b = (h + i*h2) % bits;
+        if(!(words[b/64] & (1ULL << (b%64)))){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int ZSTDSeek_bloomCompareHashes(const void *a, const void *b){
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+void ZSTDSeek_bloomSetToken(uint8_t *dst, size_t *dstSize, const uint8_t *src, size_t size){
+    if(size > ZSTDSEEK_BLOOM_MAX_TOKEN_SIZE){
+        *dstSize = BLOOM_OVERFLOW;
+        return;
+    }
+    memcpy(dst, src, size);
+    *dstSize = size;
+}
+
+int ZSTDSeek_bloomScanFrame(const void *data, size_t size, size_t uncompressedPos, size_t frame, void *user){
+    (void)uncompressedPos;
+    ZSTDSeek_BloomBuild *build = (ZSTDSeek_BloomBuild *)user;
+    ZSTDSeek_BloomFrame *f = &build->frames[frame];
+    const uint8_t *isToken = build->index->isToken;
+    const uint8_t *p = (const uint8_t *)data;
+    f->size = size;
+
+    //the tokens at the edges are indexed later, when the neighbour frames are known
+    size_t headEnd = 0;
+    while(headEnd < size && isToken[p[headEnd]]){
+        headEnd++;
+    }
+    size_t tailStart = size;
+    while(tailStart > headEnd && isToken[p[tailStart-1]]){
+        tailStart--;
+    }
+    f->allToken = headEnd == size;
+    ZSTDSeek_bloomSetToken(f->head, &f->headSize, p, headEnd);
+    ZSTDSeek_bloomSetToken(f->tail, &f->tailSize, p + tailStart, f->allToken ? size : size - tailStart);
+
+    size_t n = 0;
+    size_t capacity = 1024;
+    uint64_t *hashes = malloc(capacity*sizeof(uint64_t));
+    if(!hashes){
+        return -1;
+    }
+    for(size_t i = headEnd; i < tailStart;){
+        while(i < tailStart && !isToken[p[i]]){
+            i++;
+        }
+        size_t start = i;
+        while(i < tailStart && isToken[p[i]]){
+            i++;
+        }
+        if(i == start || i - start > ZSTDSEEK_BLOOM_MAX_TOKEN_SIZE){
+            continue;
+        }
+        if(n == capacity){
+            uint64_t *tmp = realloc(hashes, 2*capacity*sizeof(uint64_t));
+            if(!tmp){
+                free(hashes);
+                return -1;
+            }
+            hashes = tmp;
+            capacity *= 2;
+        }
+        hashes[n++] = ZSTDSeek_mixedHash(p + start, i - start);
+    }
+
+    //the filter is sized on the distinct tokens, plus the two at the edges
+    qsort(hashes, n, sizeof(uint64_t), ZSTDSeek_bloomCompareHashes);
+    size_t distinct = 0;
+    for(size_t i = 0; i < n; i++){
+        if(i == 0 || hashes[i] != hashes[i-1]){
+            hashes[distinct++] = hashes[i];
+        }
+    }
+    f->nwords = ((distinct + 2)*ZSTDSEEK_BLOOM_BITS_PER_TOKEN + 63)/64;
+    f->words = calloc(f->nwords, sizeof(uint64_t));
+    if(!f->words){
+        free(hashes);
+        return -1;
+    }
+    for(size_t i = 0; i < distinct; i++){
+        ZSTDSeek_bloomAdd(f->words, f->nwords, hashes[i]);
+    }
+    free(hashes);
+    return 0;
+}
+
+void ZSTDSeek_bloomAddToken(ZSTDSeek_BloomFrame *f, const uint8_t *token, size_t size){
+    if(size > 0 && size <= ZSTDSEEK_BLOOM_MAX_TOKEN_SIZE){
+        ZSTDSeek_bloomAdd(f->words, f->nwords, ZSTDSeek_mixedHash(token, size));
+    }
+}
+
+void ZSTDSeek_bloomIndexEdges(ZSTDSeek_BloomIndex *index, ZSTDSeek_BloomFrame *frames){
+    //follow the tokens across the frames, each is indexed in the frame where it begins
+    uint8_t token[2*BLOOM_OVERFLOW];
+    size_t tokenSize = 0;
+    size_t tokenFrame = 0;
+    int open = 0;
+    for(size_t i = 0; i < index->length; i++){
+        ZSTDSeek_BloomFrame *f = &frames[i];
+        if(f->size == 0){
+            continue;
+        }
+
+        if(open && f->headSize > 0){
+            index->flags[i] |= BLOOM_CONTINUES;
+            if(tokenSize + f->headSize > ZSTDSEEK_BLOOM_MAX_TOKEN_SIZE){
+                tokenSize = BLOOM_OVERFLOW;
+            }else{
+                memcpy(token + tokenSize, f->head, f->headSize);
+                tokenSize += f->headSize;
+            }
+            if(f->allToken){
+                continue;
+            }
+            ZSTDSeek_bloomAddToken(&frames[tokenFrame], token, tokenSize);
+            open = 0;
+        }else{
+            if(open){
+                ZSTDSeek_bloomAddToken(&frames[tokenFrame], token, tokenSize);
+                open = 0;
+            }
+            if(f->allToken){
+                ZSTDSeek_bloomSetToken(token, &tokenSize, f->head, f->headSize);
+                tokenFrame = i;
+                open = 1;
+                continue;
+            }
+            ZSTDSeek_bloomAddToken(f, f->head, f->headSize);
+        }
+
+        if(f->tailSize > 0){
+            ZSTDSeek_bloomSetToken(token, &tokenSize, f->tail, f->tailSize);
+            tokenFrame = i;
+            open = 1;
+        }
+    }
+    if(open){
+        ZSTDSeek_bloomAddToken(&frames[tokenFrame], token, tokenSize);
+    }
+}
+
+ZSTDSeek_BloomIndex* ZSTDSeek_newBloomIndex(ZSTDSeek_Context *sctx, size_t length){
+    ZSTDSeek_BloomIndex *index = calloc(1, sizeof(ZSTDSeek_BloomIndex));
+    if(!index){
+        return NULL;
+    }
+    index->length = length;
+    ZSTDSeek_getCompressedBuffer(sctx, &index->compressedSize);
+    index->fileHash = ZSTDSeek_fileHash(sctx);
+    index->offsets = calloc(length + 1, sizeof(uint64_t));
+    index->flags = calloc(length ? length : 1, 1);
+    if(!index->offsets || !index->flags){
+        ZSTDSeek_freeBloomIndex(index);
+        return NULL;
+    }
+    return index;
+}
+
+ZSTDSeek_BloomIndex* ZSTDSeek_buildBloomIndex(ZSTDSeek_Context *sctx, const char *separators, int nthreads){
+    if(!sctx || ZSTDSeek_getViewStart(sctx) != 0){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+    if(ZSTDSeek_initializeJumpTable(sctx) != 0){
+        DEBUG("Can't initialize the jump table\n");
+        return NULL;
+    }
+
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+    size_t length = jt->length > 0 ? jt->length - 1 : 0;
+    ZSTDSeek_BloomBuild build;
+    build.index = ZSTDSeek_newBloomIndex(sctx, length);
+    build.frames = calloc(length ? length : 1, sizeof(ZSTDSeek_BloomFrame));
+    if(!build.index || !build.frames){
+        goto fail;
+    }
+
+    memset(build.index->isToken, 1, sizeof(build.index->isToken));
+    for(const char *s = separators ? separators : ZSTDSEEK_BLOOM_DEFAULT_SEPARATORS; *s; s++){
+        build.index->isToken[(uint8_t)*s] = 0;
+    }
+
+    if(ZSTDSeek_forEachFrameParallel(sctx, ZSTDSeek_bloomScanFrame, &build, nthreads) != 0){
+        DEBUG("Can't scan the frames\n");
+        goto fail;
+    }
+    for(size_t i = 0; i < length; i++){
+        if(!build.frames[i].words && !(build.frames[i].words = calloc(1, sizeof(uint64_t)))){ //empty frames
+            goto fail;
+        }
+        build.frames[i].nwords = build.frames[i].nwords ? build.frames[i].nwords : 1;
+    }
+    ZSTDSeek_bloomIndexEdges(build.index, build.frames);
+
+    //pack the filters
+    for(size_t i = 0; i < length; i++){
+        build.index->offsets[i+1] = build.index->offsets[i] + build.frames[i].nwords;
+    }
+    build.index->words = malloc((build.index->offsets[length] ? build.index->offsets[length] : 1)*sizeof(uint64_t));
+    if(!build.index->words){
+        goto fail;
+    }
+    for(size_t i = 0; i < length; i++){
+        memcpy(build.index->words + build.index->offsets[i], build.frames[i].words, build.frames[i].nwords*sizeof(uint64_t));
+        free(build.frames[i].words);
+    }
+    free(build.frames);
+    return build.index;
+
+fail:
+    for(size_t i = 0; build.frames && i < length; i++){
+        free(build.frames[i].words);
+    }
+    free(build.frames);
+    if(build.index){
+        ZSTDSeek_freeBloomIndex(build.index);
+    }
+    return NULL;
+}
+
+int ZSTDSeek_saveBloomIndex(ZSTDSeek_BloomIndex *index, const char *file){
+    if(!index || !file){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    FILE *f = fopen(file, "wb");
+    if(!f){
+        DEBUG("Unable to open '%s'\n", file);
+        return -1;
+    }
+
+    int ret = ZSTDSeek_writeLE(f, ZSTDSEEK_BLOOM_INDEX_MAGICNUMBER, 8) |
+              ZSTDSeek_writeLE(f, ZSTDSEEK_BLOOM_INDEX_VERSION, 8) |
+              ZSTDSeek_writeLE(f, index->compressedSize, 8) |
+              ZSTDSeek_writeLE(f, index->fileHash, 8) |
+              ZSTDSeek_writeLE(f, index->length, 8);
+    if(ret == 0 && fwrite(index->isToken, 1, sizeof(index->isToken), f) != sizeof(index->isToken)){
+        ret = -1;
+    }
+    for(size_t i = 0; i < index->length && ret == 0; i++){
+        ret = ZSTDSeek_writeLE(f, index->flags[i], 8) |
+              ZSTDSeek_writeLE(f, index->offsets[i+1] - index->offsets[i], 8);
+        for(uint64_t w = index->offsets[i]; w < index->offsets[i+1] && ret == 0; w++){
+            ret = ZSTDSeek_writeLE(f, index->words[w], 8);
+        }
+    }
+
+    if(fclose(f) != 0){
+        ret = -1;
+    }
+    return ret;
+}
+
+ZSTDSeek_BloomIndex* ZSTDSeek_loadBloomIndex(ZSTDSeek_Context *sctx, const char *file){
+    if(!sctx || !file){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+
+    FILE *f = fopen(file, "rb");
+    if(!f){
+        DEBUG("Unable to open '%s'\n", file);
+        return NULL;
+    }
+
+    ZSTDSeek_BloomIndex *index = NULL;
+    uint64_t magic, version, compressedSize, fileHash, length;
+    size_t sctxCompressedSize;
+    ZSTDSeek_getCompressedBuffer(sctx, &sctxCompressedSize);
+    if(ZSTDSeek_readLE(f, &magic, 8) || ZSTDSeek_readLE(f, &version, 8) || ZSTDSeek_readLE(f, &compressedSize, 8) ||
+       ZSTDSeek_readLE(f, &fileHash, 8) || ZSTDSeek_readLE(f, &length, 8) || magic != ZSTDSEEK_BLOOM_INDEX_MAGICNUMBER ||
+       version != ZSTDSEEK_BLOOM_INDEX_VERSION || compressedSize != sctxCompressedSize || fileHash != ZSTDSeek_fileHash(sctx)){
+        DEBUG("'%s' is not a bloom index of this file\n", file);
+        goto fail;
+    }
+
+    index = ZSTDSeek_newBloomIndex(sctx, length);
+    if(!index || fread(index->isToken, 1, sizeof(index->isToken), f) != sizeof(index->isToken)){
+        goto fail;
+    }
+    size_t capacity = 0;
+    for(size_t i = 0; i < length; i++){
+        uint64_t flags, nwords;
+        if(ZSTDSeek_readLE(f, &flags, 8) || ZSTDSeek_readLE(f, &nwords, 8) || nwords == 0){
+            goto fail;
+        }
+        index->flags[i] = (uint8_t)flags;
+        index->offsets[i+1] = index->offsets[i] + nwords;
+        if(index->offsets[i+1] > capacity){
+            capacity = index->offsets[i+1]*2;
+            uint64_t *tmp = realloc(index->words, capacity*sizeof(uint64_t));
+            if(!tmp){
+                goto fail;
+            }
+            index->words = tmp;
+        }
+        for(uint64_t w = index->offsets[i]; w < index->offsets[i+1]; w++){
+            if(ZSTDSeek_readLE(f, &index->words[w], 8)){
+                goto fail;
+            }
+        }
+    }
+
+    fclose(f);
+    return index;
+
+fail:
+    fclose(f);
+    if(index){
+        ZSTDSeek_freeBloomIndex(index);
+    }
+    return NULL;
+}
+
+size_t ZSTDSeek_bloomIndexLength(ZSTDSeek_BloomIndex *index){
+    return index ? index->length : 0;
+}
+
+int ZSTDSeek_bloomMayContain(ZSTDSeek_BloomIndex *index, size_t frame, const void *token, size_t size){
+    if(!index || frame >= index->length){
+        DEBUG("Invalid argument\n");
+        return 0;
+    }
+    if(size > ZSTDSEEK_BLOOM_MAX_TOKEN_SIZE){
+        return 1;
+    }
+    return ZSTDSeek_bloomTest(index->words + index->offsets[frame], index->offsets[frame+1] - index->offsets[frame],
+                              ZSTDSeek_mixedHash(token, size));
+}
+
+typedef struct {
+    size_t frame;
+    size_t *matches;
+    size_t n;
+    size_t capacity;
+} ZSTDSeek_BloomCandidate;
+
+typedef struct {
+    ZSTDSeek_Context *sctx;
+    ZSTDSeek_BloomIndex *index;
+    const uint8_t *token;
+    size_t size;
+    size_t fileSize;
+    ZSTDSeek_BloomCandidate *candidates;
+    size_t n;
+} ZSTDSeek_BloomJob;
+
+typedef struct {
+    uint8_t *buff;
+    size_t buffSize;
+} ZSTDSeek_BloomBuffer;
+
+int ZSTDSeek_bloomSearchFrame(size_t index, ZSTDSeek_ParallelSlot *slot, void *user){
+    ZSTDSeek_BloomJob *job = (ZSTDSeek_BloomJob *)user;
+    ZSTDSeek_BloomCandidate *c = &job->candidates[index];
+    ZSTDSeek_BloomBuffer *buffer = (ZSTDSeek_BloomBuffer *)slot->local;
+    if(!buffer && !(buffer = slot->local = calloc(1, sizeof(ZSTDSeek_BloomBuffer)))){
+        return -1;
+    }
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(job->sctx);
+    size_t start = jt->records[c->frame].uncompressedPos;
+    size_t frameSize = jt->records[c->frame+1].uncompressedPos - start;
+
+    //read the beginning of the next frame too, for the occurrences that cross the end of this one
+    size_t extra = job->fileSize - (start + frameSize);
+    extra = extra < job->size ? extra : job->size;
+    size_t total = frameSize + extra;
+    if(total > buffer->buffSize){
+        uint8_t *tmp = realloc(buffer->buff, total);
+        if(!tmp){
+            return -1;
+        }
+        buffer->buff = tmp;
+        buffer->buffSize = total;
+    }
+    if(ZSTDSeek_moveView(slot->view, start, total) != 0){
+        return -1;
+    }
+    for(size_t done = 0; done < total;){
+        size_t len = ZSTDSeek_read(buffer->buff + done, total - done, slot->view);
+        if(len == 0 || len == (size_t)ZSTDSEEK_ERR_READ){
+            return -1;
+        }
+        done += len;
+    }
+
+    const uint8_t *isToken = job->index->isToken;
+    const uint8_t *buff = buffer->buff;
+    for(size_t o = 0; o < frameSize; o++){
+        const uint8_t *p = memchr(buff + o, job->token[0], frameSize - o);
+        if(!p){
+            break;
+        }
+        o = p - buff;
+        if(o + job->size > total || memcmp(p, job->token, job->size) != 0){
+            continue;
+        }
+        int left = o == 0 ? !(job->index->flags[c->frame] & BLOOM_CONTINUES) : !isToken[buff[o-1]];
+        int right = o + job->size == total || !isToken[buff[o + job->size]]; //o + size == total only at the end of the file
+        if(!left || !right){
+            continue;
+        }
+        if(c->n == c->capacity){
+            size_t capacity = c->capacity ? 2*c->capacity : 16;
+            size_t *tmp = realloc(c->matches, capacity*sizeof(size_t));
+            if(!tmp){
+                return -1;
+            }
+            c->matches = tmp;
+            c->capacity = capacity;
+        }
+        c->matches[c->n++] = start + o;
+    }
+    return 0;
+}
+
+void ZSTDSeek_bloomFreeBuffer(void *local){
+    ZSTDSeek_BloomBuffer *buffer = (ZSTDSeek_BloomBuffer *)local;
+    if(buffer){
+        free(buffer->buff);
+        free(buffer);
+    }
+}
+
+int ZSTDSeek_bloomFindToken(ZSTDSeek_Context *sctx, ZSTDSeek_BloomIndex *index, const void *token, size_t size, ZSTDSeek_TokenCallback fn, void *user, int nthreads){
+    if(!sctx || !index || !token || size == 0 || !fn){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    for(size_t i = 0; i < size; i++){
+        if(!index->isToken[((const uint8_t *)token)[i]]){
+            DEBUG("The token contains a separator\n");
+            return -1;
+        }
+    }
+    if(ZSTDSeek_initializeJumpTable(sctx) != 0 || ZSTDSeek_getJumpTableOfContext(sctx)->length != index->length + 1){
+        DEBUG("The index doesn't match the file\n");
+        return -1;
+    }
+
+    ZSTDSeek_BloomJob job;
+    job.sctx = sctx;
+    job.index = index;
+    job.token = (const uint8_t *)token;
+    job.size = size;
+    job.fileSize = ZSTDSeek_uncompressedFileSize(sctx);
+    job.n = 0;
+    job.candidates = calloc(index->length ? index->length : 1, sizeof(ZSTDSeek_BloomCandidate));
+    if(!job.candidates){
+        return -1;
+    }
+    for(size_t i = 0; i < index->length; i++){
+        if(ZSTDSeek_bloomMayContain(index, i, token, size)){
+            job.candidates[job.n++].frame = i;
+        }
+    }
+
+    int ret = ZSTDSeek_forEachIndexParallel(sctx, job.n, ZSTDSeek_bloomSearchFrame, ZSTDSeek_bloomFreeBuffer, &job, nthreads);
+
+    //the candidates are in file order
+    for(size_t i = 0; i < job.n && ret == 0; i++){
+        for(size_t m = 0; m < job.candidates[i].n && ret == 0; m++){
+            ret = fn(job.candidates[i].matches[m], user);
+        }
+    }
+
+    for(size_t i = 0; i < job.n; i++){
+        free(job.candidates[i].matches);
+    }
+    free(job.candidates);
+    return ret;
+}
+
+void ZSTDSeek_freeBloomIndex(ZSTDSeek_BloomIndex *index){
+    if(!index){
+        DEBUG("Invalid argument\n");
+        return;
+    }
+    free(index->offsets);
+    free(index->words);
+    free(index->flags);
+    free(index);
+}
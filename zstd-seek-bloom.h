@@ -0,0 +1,87 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_BLOOM_
+#define _ZSTD_SEEK_BLOOM_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Bloom index constants */
+#define ZSTDSEEK_BLOOM_INDEX_MAGICNUMBER 0x4642535A //"ZSBF"
+#define ZSTDSEEK_BLOOM_INDEX_VERSION 2
+#define ZSTDSEEK_BLOOM_MAX_TOKEN_SIZE 255 //longer tokens are not indexed, searching them decodes every frame
+#define ZSTDSEEK_BLOOM_BITS_PER_TOKEN 10  //about 1% of false positives
+#define ZSTDSEEK_BLOOM_DEFAULT_SEPARATORS " \t\r\n\"'`()[]{}<>,;=&|"
+
+/* Structs */
+
+typedef struct ZSTDSeek_BloomIndex_s ZSTDSeek_BloomIndex;
+
+/*
+ * Called by ZSTDSeek_bloomFindToken for each occurrence of the token, in order.
+ * pos is the position in the uncompressed file. Return 0 to continue, anything else to stop.
+ */
+typedef int (*ZSTDSeek_TokenCallback)(size_t pos, void *user);
+
+/* Bloom Index API */
+
+/*
+ * Build a Bloom filter of the tokens of each frame of sctx, which must not be a view.
+ * Tokens are the runs of bytes that are not in separators, NULL means ZSTDSEEK_BLOOM_DEFAULT_SEPARATORS, eg ids and IP addresses.
+ * The frames are decompressed on nthreads threads, <= 0 means one per CPU.
+ * Tokens that cross the end of a frame are indexed in the frame where they begin.
+ * Returns 0 in case of failure.
+ */
+ZSTDSeek_BloomIndex* ZSTDSeek_buildBloomIndex(ZSTDSeek_Context *sctx, const char *separators, int nthreads);
+
+/*
+ * Save the index to file. Returns 0 on success.
+ */
+int ZSTDSeek_saveBloomIndex(ZSTDSeek_BloomIndex *index, const char *file);
+
+/*
+ * Load an index saved with ZSTDSeek_saveBloomIndex for the file of sctx.
+ * Returns 0 in case of failure or if the index was built for a different file.
+ */
+ZSTDSeek_BloomIndex* ZSTDSeek_loadBloomIndex(ZSTDSeek_Context *sctx, const char *file);
+
+/*
+ * Returns the number of frames in the index.
+ */
+size_t ZSTDSeek_bloomIndexLength(ZSTDSeek_BloomIndex *index);
+
+/*
+ * Returns 1 if a token beginning in frame may be token, 0 if it is not.
+ */
+int ZSTDSeek_bloomMayContain(ZSTDSeek_BloomIndex *index, size_t frame, const void *token, size_t size);
+
+/*
+ * Find the occurrences of token as a whole token, ie not as part of a longer one, decoding only the frames whose filter matches.
+ * token must not contain separators. The candidate frames are decompressed on nthreads threads, <= 0 means one per CPU.
+ * fn is called from the calling thread with the positions in order.
+ * Returns 0 on success, -1 on failure or the value returned by fn if it stopped the search.
+ */
+int ZSTDSeek_bloomFindToken(ZSTDSeek_Context *sctx, ZSTDSeek_BloomIndex *index, const void *token, size_t size, ZSTDSeek_TokenCallback fn, void *user, int nthreads);
+
+/*
+ * Free the index.
+ */
+void ZSTDSeek_freeBloomIndex(ZSTDSeek_BloomIndex *index);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
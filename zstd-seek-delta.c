@@ -0,0 +1,249 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "zstd-seek-delta.h"
+#include "zstd-seek-internal.h"
+#include "zstd-seek-write.h"
+
+typedef struct {
+    uint64_t hash; //the frame checksum or a hash of the compressed data
+    size_t compressedSize;
+    size_t uncompressedSize;
+} ZSTDSeek_FrameFingerprint;
+
+typedef struct {
+    ZSTDSeek_FrameFingerprint *fingerprints; //one per frame of the old file
+    size_t *slots; //open addressing hash table of frame indexes, SIZE_MAX when empty
+    size_t mask;
+} ZSTDSeek_FrameMap;
+
+int ZSTDSeek_hasChecksums(ZSTDSeek_Context *sctx){
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+    uint32_t checksum;
+    for(size_t i = 0; i+1 < jt->length; i++){
+        if(ZSTDSeek_getFrameChecksum(sctx, i, &checksum) != 0){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+ZSTDSeek_FrameFingerprint ZSTDSeek_fingerprintFrame(ZSTDSeek_Context *sctx, size_t frame, int useChecksums){
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+    ZSTDSeek_JumpTableRecord r = jt->records[frame];
+    ZSTDSeek_JumpTableRecord next = jt->records[frame+1];
+    ZSTDSeek_FrameFingerprint fp = {0, next.compressedPos - r.compressedPos, next.uncompressedPos - r.uncompressedPos};
+
+    uint32_t checksum;
+    if(useChecksums && ZSTDSeek_getFrameChecksum(sctx, frame, &checksum) == 0){
+        fp.hash = checksum; //no need to touch the frame data
+    }else{
+        const uint8_t *buff = (const uint8_t *)ZSTDSeek_getCompressedBuffer(sctx, NULL) + r.compressedPos;
+        fp.hash = ZSTDSeek_fnv1a(ZSTDSEEK_FNV_OFFSET_BASIS, buff, fp.compressedSize);
+    }
+    return fp;
+}
+
+size_t ZSTDSeek_fingerprintSlot(ZSTDSeek_FrameFingerprint fp, size_t mask){
+    uint64_t h = fp.hash ^ ((uint64_t)fp.compressedSize * ZSTDSEEK_FNV_PRIME) ^ ((uint64_t)fp.uncompressedSize << 17);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t)h & mask;
+}
+
+int ZSTDSeek_sameFingerprint(ZSTDSeek_FrameFingerprint a, ZSTDSeek_FrameFingerprint b){
+    return a.hash == b.hash && a.compressedSize == b.compressedSize && a.uncompressedSize == b.uncompressedSize;
+}
+
+int ZSTDSeek_buildFrameMap(ZSTDSeek_FrameMap *map, ZSTDSeek_Context *sctx, int useChecksums){
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+    size_t frames = jt->length - 1;
+    size_t capacity = 16;
+    while(capacity < frames*2){
+        capacity <<= 1;
+    }
+
+    map->fingerprints = malloc(frames*sizeof(ZSTDSeek_FrameFingerprint));
+    map->slots = malloc(capacity*sizeof(size_t));
+    map->mask = capacity - 1;
+    if(!map->fingerprints || !map->slots){
+        free(map->fingerprints);
+        free(map->slots);
+        return -1;
+    }
+    memset(map->slots, 0xff, capacity*sizeof(size_t));
+
+    for(size_t i = 0; i < frames; i++){
+        ZSTDSeek_FrameFingerprint fp = ZSTDSeek_fingerprintFrame(sctx, i, useChecksums);
+        map->fingerprints[i] = fp;
+        size_t slot = ZSTDSeek_fingerprintSlot(fp, map->mask);
+        while(map->slots[slot] != SIZE_MAX){
+            if(ZSTDSeek_sameFingerprint(map->fingerprints[map->slots[slot]], fp)){
+                break; //keep the first copy
+            }
+            slot = (slot + 1) & map->mask;
+        }
+        if(map->slots[slot] == SIZE_MAX){
+            map->slots[slot] = i;
+        }
+    }
+    return 0;
+}
+
+size_t ZSTDSeek_findFrame(ZSTDSeek_FrameMap *map, ZSTDSeek_FrameFingerprint fp){
+    size_t slot = ZSTDSeek_fingerprintSlot(fp, map->mask);
+    while(map->slots[slot] != SIZE_MAX){
+        if(ZSTDSeek_sameFingerprint(map->fingerprints[map->slots[slot]], fp)){
+            return map->slots[slot];
+        }
+        slot = (slot + 1) & map->mask;
+    }
+    return SIZE_MAX;
+}
+
+int ZSTDSeek_createPatch(ZSTDSeek_Context *oldSctx, ZSTDSeek_Context *newSctx, FILE *patch, size_t *copiedFrames, size_t *literalFrames){
+    if(!oldSctx || !newSctx || !patch){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    if(ZSTDSeek_initializeJumpTable(oldSctx) != 0 || ZSTDSeek_initializeJumpTable(newSctx) != 0){
+        DEBUG("Can't initialize the jump tables\n");
+        return -1;
+    }
+
+    int useChecksums = ZSTDSeek_hasChecksums(oldSctx) && ZSTDSeek_hasChecksums(newSctx);
+
+    ZSTDSeek_FrameMap map;
+    if(ZSTDSeek_buildFrameMap(&map, oldSctx, useChecksums) != 0){
+        DEBUG("Can't index the old frames\n");
+        return -1;
+    }
+
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(newSctx);
+    const uint8_t *buff = ZSTDSeek_getCompressedBuffer(newSctx, NULL);
+    size_t frames = jt->length - 1;
+    size_t copied = 0;
+    size_t literal = 0;
+
+    int ret = ZSTDSeek_writeLE(patch, ZSTDSEEK_PATCH_MAGICNUMBER, 4) |
+              ZSTDSeek_writeLE(patch, ZSTDSEEK_PATCH_VERSION, 4) |
+              ZSTDSeek_writeLE(patch, frames, 8);
+
+    for(size_t i = 0; i < frames && ret == 0; i++){
+        ZSTDSeek_FrameFingerprint fp = ZSTDSeek_fingerprintFrame(newSctx, i, useChecksums);
+        size_t oldFrame = ZSTDSeek_findFrame(&map, fp);
+        if(oldFrame != SIZE_MAX){
+            ret = ZSTDSeek_writeLE(patch, ZSTDSEEK_PATCH_OP_COPY, 1) |
+                  ZSTDSeek_writeLE(patch, fp.compressedSize, 8) |
+                  ZSTDSeek_writeLE(patch, fp.uncompressedSize, 8) |
+                  ZSTDSeek_writeLE(patch, oldFrame, 8);
+            copied++;
+        }else{
+            ret = ZSTDSeek_writeLE(patch, ZSTDSEEK_PATCH_OP_LITERAL, 1) |
+                  ZSTDSeek_writeLE(patch, fp.compressedSize, 8) |
+                  ZSTDSeek_writeLE(patch, fp.uncompressedSize, 8);
+            if(ret == 0 && fwrite(buff + jt->records[i].compressedPos, 1, fp.compressedSize, patch) != fp.compressedSize){
+                ret = -1;
+            }
+            literal++;
+        }
+    }
+
+    free(map.fingerprints);
+    free(map.slots);
+
+    if(ret != 0){
+        DEBUG("Write error\n");
+        return -1;
+    }
+    if(copiedFrames){
+        *copiedFrames = copied;
+    }
+    if(literalFrames){
+        *literalFrames = literal;
+    }
+    return 0;
+}
+
+int ZSTDSeek_applyPatch(ZSTDSeek_Context *oldSctx, FILE *patch, FILE *out){
+    if(!oldSctx || !patch || !out){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    if(ZSTDSeek_initializeJumpTable(oldSctx) != 0){
+        DEBUG("Can't initialize the jump table\n");
+        return -1;
+    }
+
+    uint64_t magic, version, frames;
+    if(ZSTDSeek_readLE(patch, &magic, 4) || ZSTDSeek_readLE(patch, &version, 4) || ZSTDSeek_readLE(patch, &frames, 8) ||
+       magic != ZSTDSEEK_PATCH_MAGICNUMBER || version != ZSTDSEEK_PATCH_VERSION){
+        DEBUG("Not a valid patch\n");
+        return -1;
+    }
+
+    ZSTDSeek_Writer *w = ZSTDSeek_createWriter(out, ZSTD_CLEVEL_DEFAULT);
+    if(!w){
+        return -1;
+    }
+
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(oldSctx);
+    void *literal = NULL;
+    size_t literalCapacity = 0;
+    int ret = 0;
+
+    for(uint64_t i = 0; i < frames && ret == 0; i++){
+        uint64_t op, compressedSize, uncompressedSize;
+        if(ZSTDSeek_readLE(patch, &op, 1) || ZSTDSeek_readLE(patch, &compressedSize, 8) || ZSTDSeek_readLE(patch, &uncompressedSize, 8)){
+            DEBUG("Truncated patch\n");
+            ret = -1;
+        }else if(op == ZSTDSEEK_PATCH_OP_COPY){
+            uint64_t oldFrame;
+            if(ZSTDSeek_readLE(patch, &oldFrame, 8) || oldFrame + 1 >= jt->length ||
+               jt->records[oldFrame+1].compressedPos - jt->records[oldFrame].compressedPos != compressedSize ||
+               jt->records[oldFrame+1].uncompressedPos - jt->records[oldFrame].uncompressedPos != uncompressedSize){
+                DEBUG("The patch doesn't match the old file at frame %llu\n", (unsigned long long)i);
+                ret = -1;
+            }else{
+                ret = ZSTDSeek_writerAddFrames(w, oldSctx, oldFrame, 1);
+            }
+        }else if(op == ZSTDSEEK_PATCH_OP_LITERAL){
+            if(compressedSize > literalCapacity){
+                void *tmp = realloc(literal, compressedSize);
+                if(!tmp){
+                    ret = -1;
+                    break;
+                }
+                literal = tmp;
+                literalCapacity = compressedSize;
+            }
+            if(fread(literal, 1, compressedSize, patch) != compressedSize){
+                DEBUG("Truncated patch\n");
+                ret = -1;
+            }else{
+                ret = ZSTDSeek_writerAddCompressedFrame(w, literal, compressedSize, uncompressedSize);
+            }
+        }else{
+            DEBUG("Unknown patch operation %llu\n", (unsigned long long)op);
+            ret = -1;
+        }
+    }
+
+    free(literal);
+    if(ZSTDSeek_writerClose(w) != 0){
+        ret = -1;
+    }
+    return ret;
+}
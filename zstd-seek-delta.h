@@ -0,0 +1,49 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_DELTA_
+#define _ZSTD_SEEK_DELTA_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Patch format constants */
+#define ZSTDSEEK_PATCH_MAGICNUMBER 0x5044535A //"ZSDP"
+#define ZSTDSEEK_PATCH_VERSION 1
+#define ZSTDSEEK_PATCH_OP_COPY 0
+#define ZSTDSEEK_PATCH_OP_LITERAL 1
+
+/* Delta API */
+
+/*
+ * Compare the frames of oldSctx and newSctx and write to patch what is needed to rebuild newSctx from oldSctx.
+ * Frames of newSctx found in oldSctx are referenced by index, only the others are written in the patch.
+ * Frames are compared by compressed size, uncompressed size and checksum when both files have them
+ * in the seek table or in the frames, otherwise by a hash of their compressed data.
+ * copiedFrames and literalFrames, if not 0, are set to the number of frames referenced and written in the patch.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_createPatch(ZSTDSeek_Context *oldSctx, ZSTDSeek_Context *newSctx, FILE *patch, size_t *copiedFrames, size_t *literalFrames);
+
+/*
+ * Rebuild the new file from oldSctx and a patch created by ZSTDSeek_createPatch and write it to out, with a new seek table.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_applyPatch(ZSTDSeek_Context *oldSctx, FILE *patch, FILE *out);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
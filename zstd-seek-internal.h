@@ -0,0 +1,141 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+/*
+ * Functions shared by the modules of the library, they are not part of its API.
+ */
+
+#ifndef _ZSTD_SEEK_INTERNAL_
+#define _ZSTD_SEEK_INTERNAL_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Hash constants */
+
+#define ZSTDSEEK_FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define ZSTDSEEK_FNV_PRIME 0x100000001b3ULL
+
+/* Structs */
+
+/*
+ * What a thread of ZSTDSeek_forEachIndexParallel and ZSTDSeek_mapReduceIndexParallel passes to the callbacks, the same for all its calls.
+ */
+typedef struct {
+    ZSTDSeek_Context *view; //a view of the whole context, only used by this thread, the callbacks move it where they need
+    void *local;            //the data of the thread, eg its buffers, NULL until a callback sets it
+} ZSTDSeek_ParallelSlot;
+
+/*
+ * A frame that covers a context, see ZSTDSeek_frameRanges.
+ */
+typedef struct {
+    size_t frame; //as numbered in the jump table
+    size_t start; //the part of the frame in the context, in the coordinates of the jump table
+    size_t end;   //exclusive
+} ZSTDSeek_FrameRange;
+
+/*
+ * Called by ZSTDSeek_forEachIndexParallel for each index, concurrently from different threads.
+ * Return 0 to continue, anything else to stop.
+ */
+typedef int (*ZSTDSeek_IndexCallback)(size_t index, ZSTDSeek_ParallelSlot *slot, void *user);
+
+/*
+ * Called by ZSTDSeek_mapReduceIndexParallel for each index, concurrently from different threads.
+ * Set result to what has to be passed to ZSTDSeek_IndexReduceCallback for this index.
+ * Return 0 to continue, anything else to stop.
+ */
+typedef int (*ZSTDSeek_IndexMapCallback)(size_t index, ZSTDSeek_ParallelSlot *slot, void **result, void *user);
+
+/*
+ * Called by ZSTDSeek_mapReduceIndexParallel with the result of ZSTDSeek_IndexMapCallback for each index, in order.
+ * It owns result. Return 0 to continue, anything else to stop.
+ */
+typedef int (*ZSTDSeek_IndexReduceCallback)(void *result, size_t index, void *user);
+
+/*
+ * Frees the local data of a thread or a result, see ZSTDSeek_mapReduceIndexParallel.
+ */
+typedef void (*ZSTDSeek_FreeCallback)(void *data);
+
+/* Frames API */
+
+/*
+ * The non-empty frames that cover the context, clipped to it, in order. The jump table is fully initialized first.
+ * Returns an array to free, never empty even if length is set to 0, or NULL in case of failure.
+ */
+ZSTDSeek_FrameRange* ZSTDSeek_frameRanges(ZSTDSeek_Context *sctx, size_t *length);
+
+/* Little-endian API */
+
+/*
+ * Store the lowest bytes of value in p, at most 8, the least significant first.
+ */
+void ZSTDSeek_putLE(uint8_t *p, uint64_t value, size_t bytes);
+
+/*
+ * Load a value stored by ZSTDSeek_putLE.
+ */
+uint64_t ZSTDSeek_getLE(const uint8_t *p, size_t bytes);
+
+/*
+ * Like ZSTDSeek_putLE and ZSTDSeek_getLE but with a file, for the indexes saved by the modules.
+ * Return 0 on success, -1 in case of failure.
+ */
+int ZSTDSeek_writeLE(FILE *f, uint64_t value, size_t bytes);
+int ZSTDSeek_readLE(FILE *f, uint64_t *value, size_t bytes);
+
+/* Hash API */
+
+/*
+ * Continue the FNV-1a hash of some data with size more bytes, begin with ZSTDSEEK_FNV_OFFSET_BASIS.
+ */
+uint64_t ZSTDSeek_fnv1a(uint64_t hash, const void *data, size_t size);
+
+/*
+ * A fingerprint of the compressed file of a context, the same for all its views.
+ * With the size of the file it tells apart a different or rewritten file without reading all of it, eg in the resume tokens and the saved indexes.
+ */
+uint64_t ZSTDSeek_fileHash(ZSTDSeek_Context *sctx);
+
+/*
+ * FNV-1a followed by the finalizer of MurmurHash3, so that all the bits of the hash are well mixed, eg for the Bloom filters.
+ */
+uint64_t ZSTDSeek_mixedHash(const void *data, size_t size);
+
+/* Parallel API */
+
+/*
+ * Like ZSTDSeek_forEachFrameParallel but for the indexes in [0, n), eg of the frames or the members of an archive
+ * the caller picked: nothing is decompressed, fn reads what it needs through the view of its thread.
+ * Every thread begins with its own range of consecutive indexes and steals half of the biggest range left when done.
+ * The jump table is fully initialized first, so the views never modify it.
+ * freeLocal frees the local data of each thread at the end, free if NULL.
+ * Returns 0 on success, the value returned by fn if it stopped the processing or -1 in case of failure.
+ */
+int ZSTDSeek_forEachIndexParallel(ZSTDSeek_Context *sctx, size_t n, ZSTDSeek_IndexCallback fn, ZSTDSeek_FreeCallback freeLocal, void *user, int nthreads);
+
+/*
+ * Like ZSTDSeek_mapReduceFramesParallel but for the indexes in [0, n), see ZSTDSeek_forEachIndexParallel.
+ * freeResult frees the results mapped but not reduced when the processing stops, free if NULL.
+ */
+int ZSTDSeek_mapReduceIndexParallel(ZSTDSeek_Context *sctx, size_t n, ZSTDSeek_IndexMapCallback map, ZSTDSeek_IndexReduceCallback reduce,
+                                    ZSTDSeek_FreeCallback freeResult, ZSTDSeek_FreeCallback freeLocal, void *user, int nthreads);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
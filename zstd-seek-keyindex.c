@@ -0,0 +1,404 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "zstd-seek-keyindex.h"
+#include "zstd-seek-internal.h"
+
+#ifdef _WIN32
+#include "windows-mmap.h"
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+struct ZSTDSeek_KeyIndex_s{
+    void *map;
+    size_t mapSize;
+    const uint8_t *entries; //ZSTDSEEK_KEY_INDEX_ENTRY_SIZE bytes each, sorted by hash and offset
+    size_t length;
+    ZSTDSeek_RecordKeyExtractor extract;
+    void *user;
+    uint8_t *record;        //the last record found
+    size_t recordCapacity;
+};
+
+typedef struct{
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t length;
+} ZSTDSeek_KeyIndexEntry;
+
+typedef struct{
+    int visited;
+    size_t pos;                     //where the frame begins in the context
+    size_t size;
+    int hasStart;                   //a record begins in this frame
+    uint8_t *head;                  //the end of the record that begins in a previous frame, with its delimiter if hasStart
+    size_t headSize;
+    uint8_t *tail;                  //the beginning of the last record that begins in this frame
+    size_t tailSize;
+    ZSTDSeek_KeyIndexEntry *entries;//the records that begin and end in this frame
+    size_t n;
+    size_t capacity;
+} ZSTDSeek_KeyIndexFrame;
+
+typedef struct{
+    uint8_t delimiter;
+    ZSTDSeek_RecordKeyExtractor extract;
+    void *user;
+    ZSTDSeek_KeyIndexFrame *frames;
+} ZSTDSeek_KeyIndexBuild;
+
+int ZSTDSeek_keyIndexAdd(ZSTDSeek_KeyIndexBuild *build, ZSTDSeek_KeyIndexFrame *f, const uint8_t *record, size_t size, size_t pos){
+    const void *key;
+    size_t keySize;
+    if(build->extract(record, size, &key, &keySize, build->user) != 0){
+        return 0;
+    }
+    if(f->n == f->capacity){
+        size_t capacity = f->capacity ? 2*f->capacity : 256;
+        ZSTDSeek_KeyIndexEntry *tmp = realloc(f->entries, capacity*sizeof(ZSTDSeek_KeyIndexEntry));
+        if(!tmp){
+            return -1;
+        }
+        f->entries = tmp;
+        f->capacity = capacity;
+    }
+    f->entries[f->n++] = (ZSTDSeek_KeyIndexEntry){ZSTDSeek_mixedHash(key, keySize), pos, size};
+    return 0;
+}
+
+uint8_t* ZSTDSeek_keyIndexCopy(const uint8_t *data, size_t size){
+    uint8_t *copy = malloc(size ? size : 1);
+    if(copy){
+        memcpy(copy, data, size);
+    }
+    return copy;
+}
+
+int ZSTDSeek_keyIndexScanFrame(const void *data, size_t size, size_t uncompressedPos, size_t frame, void *user){
+    ZSTDSeek_KeyIndexBuild *build = (ZSTDSeek_KeyIndexBuild *)user;
+    ZSTDSeek_KeyIndexFrame *f = &build->frames[frame];
+    const uint8_t *p = (const uint8_t *)data;
+    const uint8_t *end = p + size;
+    f->visited = 1;
+    f->pos = uncompressedPos;
+    f->size = size;
+
+    //a record begins at the beginning of the context and after each delimiter
+    const uint8_t *start = p;
+    if(uncompressedPos > 0){
+        const uint8_t *d = memchr(p, build->delimiter, size);
+        start = d ? d + 1 : end + 1;
+    }
+    f->hasStart = start <= end;
+    f->headSize = (f->hasStart ? start : end) - p;
+    if(!(f->head = ZSTDSeek_keyIndexCopy(p, f->headSize))){
+        return -1;
+    }
+    if(!f->hasStart){
+        return 0;
+    }
+
+    //the records that end in this frame are indexed here, the last one when the following frames are known
+    while(1){
+        const uint8_t *d = memchr(start, build->delimiter, end - start);
+        if(!d){
+            break;
+        }
+        if(ZSTDSeek_keyIndexAdd(build, f, start, d - start, uncompressedPos + (start - p)) != 0){
+            return -1;
+        }
+        start = d + 1;
+    }
+    f->tailSize = end - start;
+    f->tail = ZSTDSeek_keyIndexCopy(start, f->tailSize);
+    return f->tail ? 0 : -1;
+}
+
+int ZSTDSeek_keyIndexCompareEntries(const void *a, const void *b){
+    const ZSTDSeek_KeyIndexEntry *x = (const ZSTDSeek_KeyIndexEntry *)a;
+    const ZSTDSeek_KeyIndexEntry *y = (const ZSTDSeek_KeyIndexEntry *)b;
+    if(x->hash != y->hash){
+        return x->hash < y->hash ? -1 : 1;
+    }
+    return x->offset < y->offset ? -1 : x->offset > y->offset;
+}
+
+int ZSTDSeek_keyIndexAppend(uint8_t **buff, size_t *size, size_t *capacity, const uint8_t *data, size_t len){
+    if(*size + len > *capacity){
+        size_t c = (*size + len)*2;
+        uint8_t *tmp = realloc(*buff, c);
+        if(!tmp){
+            return -1;
+        }
+        *buff = tmp;
+        *capacity = c;
+    }
+    memcpy(*buff + *size, data, len);
+    *size += len;
+    return 0;
+}
+
+int ZSTDSeek_keyIndexStitch(ZSTDSeek_KeyIndexBuild *build, size_t length, ZSTDSeek_KeyIndexFrame *into){
+    //the records that cross the end of a frame, their entries go in into as they are sorted later anyway
+    uint8_t *record = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+    size_t pos = 0;
+    int open = 0;
+    int ret = 0;
+    for(size_t i = 0; i < length && ret == 0; i++){
+        ZSTDSeek_KeyIndexFrame *f = &build->frames[i];
+        if(!f->visited || f->size == 0){
+            continue;
+        }
+        if(open){
+            ret = ZSTDSeek_keyIndexAppend(&record, &size, &capacity, f->head, f->hasStart ? f->headSize - 1 : f->headSize);
+            if(!f->hasStart || ret != 0){
+                continue;
+            }
+            ret = ZSTDSeek_keyIndexAdd(build, into, record, size, pos);
+            open = 0;
+        }
+        if(f->hasStart){
+            size = 0;
+            ret |= ZSTDSeek_keyIndexAppend(&record, &size, &capacity, f->tail, f->tailSize);
+            pos = f->pos + f->size - f->tailSize;
+            open = 1;
+        }
+    }
+    if(open && size > 0 && ret == 0){ //the last record may not end with the delimiter
+        ret = ZSTDSeek_keyIndexAdd(build, into, record, size, pos);
+    }
+    free(record);
+    return ret;
+}
+
+int ZSTDSeek_keyIndexWrite(ZSTDSeek_Context *sctx, uint8_t delimiter, ZSTDSeek_KeyIndexEntry *entries, size_t n, const char *file){
+    FILE *f = fopen(file, "wb");
+    if(!f){
+        DEBUG("Unable to open '%s'\n", file);
+        return -1;
+    }
+
+    size_t compressedSize;
+    ZSTDSeek_getCompressedBuffer(sctx, &compressedSize);
+    uint8_t header[ZSTDSEEK_KEY_INDEX_HEADER_SIZE] = {0};
+    ZSTDSeek_putLE(header, ZSTDSEEK_KEY_INDEX_MAGICNUMBER, 8);
+    ZSTDSeek_putLE(header + 8, ZSTDSEEK_KEY_INDEX_VERSION, 8);
+    ZSTDSeek_putLE(header + 16, compressedSize, 8);
+    ZSTDSeek_putLE(header + 24, ZSTDSeek_uncompressedFileSize(sctx), 8);
+    ZSTDSeek_putLE(header + 32, ZSTDSeek_getViewStart(sctx), 8);
+    ZSTDSeek_putLE(header + 40, delimiter, 8);
+    ZSTDSeek_putLE(header + 48, n, 8);
+    ZSTDSeek_putLE(header + 56, ZSTDSeek_fileHash(sctx), 8);
+    int ret = fwrite(header, 1, sizeof(header), f) == sizeof(header) ? 0 : -1;
+
+    uint8_t entry[ZSTDSEEK_KEY_INDEX_ENTRY_SIZE];
+    for(size_t i = 0; i < n && ret == 0; i++){
+        ZSTDSeek_putLE(entry, entries[i].hash, 8);
+        ZSTDSeek_putLE(entry + 8, entries[i].offset, 8);
+        ZSTDSeek_putLE(entry + 16, entries[i].length, 8);
+        ret = fwrite(entry, 1, sizeof(entry), f) == sizeof(entry) ? 0 : -1;
+    }
+
+    if(fclose(f) != 0){
+        ret = -1;
+    }
+    return ret;
+}
+
+int ZSTDSeek_buildKeyIndex(ZSTDSeek_Context *sctx, uint8_t delimiter, ZSTDSeek_RecordKeyExtractor extract, void *user, const char *file, int nthreads){
+    if(!sctx || !extract || !file){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    if(ZSTDSeek_initializeJumpTable(sctx) != 0){
+        DEBUG("Can't initialize the jump table\n");
+        return -1;
+    }
+
+    size_t length = ZSTDSeek_getJumpTableOfContext(sctx)->length;
+    ZSTDSeek_KeyIndexBuild build = {delimiter, extract, user, calloc(length ? length : 1, sizeof(ZSTDSeek_KeyIndexFrame))};
+    ZSTDSeek_KeyIndexEntry *entries = NULL;
+    int ret = -1;
+    if(!build.frames){
+        return -1;
+    }
+
+    if(ZSTDSeek_forEachFrameParallel(sctx, ZSTDSeek_keyIndexScanFrame, &build, nthreads) != 0){
+        DEBUG("Can't scan the frames\n");
+        goto cleanup;
+    }
+    if(ZSTDSeek_keyIndexStitch(&build, length, &build.frames[0]) != 0){
+        goto cleanup;
+    }
+
+    size_t n = 0;
+    for(size_t i = 0; i < length; i++){
+        n += build.frames[i].n;
+    }
+    entries = malloc((n ? n : 1)*sizeof(ZSTDSeek_KeyIndexEntry));
+    if(!entries){
+        goto cleanup;
+    }
+    n = 0;
+    for(size_t i = 0; i < length; i++){
+        memcpy(entries + n, build.frames[i].entries, build.frames[i].n*sizeof(ZSTDSeek_KeyIndexEntry));
+        n += build.frames[i].n;
+    }
+    qsort(entries, n, sizeof(ZSTDSeek_KeyIndexEntry), ZSTDSeek_keyIndexCompareEntries);
+
+    ret = ZSTDSeek_keyIndexWrite(sctx, delimiter, entries, n, file);
+
+cleanup:
+    for(size_t i = 0; i < length; i++){
+        free(build.frames[i].head);
+        free(build.frames[i].tail);
+        free(build.frames[i].entries);
+    }
+    free(build.frames);
+    free(entries);
+    return ret;
+}
+
+ZSTDSeek_KeyIndex* ZSTDSeek_openKeyIndex(ZSTDSeek_Context *sctx, const char *file, ZSTDSeek_RecordKeyExtractor extract, void *user){
+    if(!sctx || !file || !extract){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+
+    int fd = open(file, O_RDONLY, 0);
+    if(fd < 0){
+        DEBUG("Unable to open '%s'\n", file);
+        return NULL;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < ZSTDSEEK_KEY_INDEX_HEADER_SIZE){
+        DEBUG("'%s' is not a key index\n", file);
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED){
+        DEBUG("Unable to mmap '%s'\n", file);
+        return NULL;
+    }
+
+    const uint8_t *header = (const uint8_t *)map;
+    size_t compressedSize;
+    ZSTDSeek_getCompressedBuffer(sctx, &compressedSize);
+    uint64_t length = ZSTDSeek_getLE(header + 48, 8);
+    if(ZSTDSeek_getLE(header, 8) != ZSTDSEEK_KEY_INDEX_MAGICNUMBER || ZSTDSeek_getLE(header + 8, 8) != ZSTDSEEK_KEY_INDEX_VERSION ||
+       ZSTDSeek_getLE(header + 16, 8) != compressedSize || ZSTDSeek_getLE(header + 24, 8) != ZSTDSeek_uncompressedFileSize(sctx) ||
+       ZSTDSeek_getLE(header + 32, 8) != ZSTDSeek_getViewStart(sctx) || ZSTDSeek_getLE(header + 56, 8) != ZSTDSeek_fileHash(sctx) ||
+       (uint64_t)st.st_size != ZSTDSEEK_KEY_INDEX_HEADER_SIZE + length*ZSTDSEEK_KEY_INDEX_ENTRY_SIZE){
+        DEBUG("'%s' is not a key index of this file\n", file);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    ZSTDSeek_KeyIndex *index = calloc(1, sizeof(ZSTDSeek_KeyIndex));
+    if(!index){
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    index->map = map;
+    index->mapSize = st.st_size;
+    index->entries = header + ZSTDSEEK_KEY_INDEX_HEADER_SIZE;
+    index->length = length;
+    index->extract = extract;
+    index->user = user;
+    return index;
+}
+
+size_t ZSTDSeek_keyIndexLength(ZSTDSeek_KeyIndex *index){
+    return index ? index->length : 0;
+}
+
+int ZSTDSeek_lookupKey(ZSTDSeek_Context *sctx, ZSTDSeek_KeyIndex *index, const void *key, size_t keySize, const void **record, size_t *length, size_t *offset){
+    if(!sctx || !index || (!key && keySize) || !record || !length){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    //the first entry with the hash of key
+    uint64_t hash = ZSTDSeek_mixedHash(key, keySize);
+    size_t l = 0;
+    size_t r = index->length;
+    while(l < r){
+        size_t m = l + (r-l)/2;
+        if(ZSTDSeek_getLE(index->entries + m*ZSTDSEEK_KEY_INDEX_ENTRY_SIZE, 8) < hash){
+            l = m + 1;
+        }else{
+            r = m;
+        }
+    }
+
+    for(; l < index->length; l++){
+        const uint8_t *entry = index->entries + l*ZSTDSEEK_KEY_INDEX_ENTRY_SIZE;
+        if(ZSTDSeek_getLE(entry, 8) != hash){
+            break;
+        }
+        size_t recordOffset = ZSTDSeek_getLE(entry + 8, 8);
+        size_t recordLength = ZSTDSeek_getLE(entry + 16, 8);
+
+        if(recordLength > index->recordCapacity){
+            uint8_t *tmp = realloc(index->record, recordLength);
+            if(!tmp){
+                return -1;
+            }
+            index->record = tmp;
+            index->recordCapacity = recordLength;
+        }
+        if(ZSTDSeek_seek(sctx, (long)recordOffset, SEEK_SET) != 0){
+            return -1;
+        }
+        for(size_t done = 0; done < recordLength;){
+            size_t len = ZSTDSeek_read(index->record + done, recordLength - done, sctx);
+            if(len == 0 || len == (size_t)ZSTDSEEK_ERR_READ){
+                return -1;
+            }
+            done += len;
+        }
+
+        //different keys can have the same hash
+        const void *recordKey;
+        size_t recordKeySize;
+        if(index->extract(index->record, recordLength, &recordKey, &recordKeySize, index->user) == 0 &&
+           recordKeySize == keySize && memcmp(recordKey, key, keySize) == 0){
+            *record = index->record;
+            *length = recordLength;
+            if(offset){
+                *offset = recordOffset;
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void ZSTDSeek_closeKeyIndex(ZSTDSeek_KeyIndex *index){
+    if(!index){
+        DEBUG("Invalid argument\n");
+        return;
+    }
+    munmap(index->map, index->mapSize);
+    free(index->record);
+    free(index);
+}
@@ -0,0 +1,77 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_KEYINDEX_
+#define _ZSTD_SEEK_KEYINDEX_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Key index constants */
+#define ZSTDSEEK_KEY_INDEX_MAGICNUMBER 0x494B535A //"ZSKI"
+#define ZSTDSEEK_KEY_INDEX_VERSION 2
+#define ZSTDSEEK_KEY_INDEX_HEADER_SIZE 64
+#define ZSTDSEEK_KEY_INDEX_ENTRY_SIZE 24 //hash, offset and length of a record, 64 bit little endian each
+
+/* Structs */
+
+/*
+ * Find the key of a record, without the delimiter, and point key to it, usually inside record, eg the id of a JSON object.
+ * Return 0 on success, anything else if the record has no key. Records without a key are not indexed.
+ */
+typedef int (*ZSTDSeek_RecordKeyExtractor)(const void *record, size_t size, const void **key, size_t *keySize, void *user);
+
+typedef struct ZSTDSeek_KeyIndex_s ZSTDSeek_KeyIndex;
+
+/* Key Index API */
+
+/*
+ * Index the records of sctx, ended by delimiter, by the key returned by extract, and write the index to file.
+ * The frames are decompressed on nthreads threads, <= 0 means one per CPU, so extract must be thread safe.
+ * The index is a header followed by the hashes of the keys, sorted, along with the position and length of their records,
+ * so it can be mapped in memory and searched without loading it.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_buildKeyIndex(ZSTDSeek_Context *sctx, uint8_t delimiter, ZSTDSeek_RecordKeyExtractor extract, void *user, const char *file, int nthreads);
+
+/*
+ * Map in memory an index written by ZSTDSeek_buildKeyIndex for sctx. extract and user must be the ones used to build it.
+ * Returns 0 in case of failure or if the index was built for a different file.
+ */
+ZSTDSeek_KeyIndex* ZSTDSeek_openKeyIndex(ZSTDSeek_Context *sctx, const char *file, ZSTDSeek_RecordKeyExtractor extract, void *user);
+
+/*
+ * Returns the number of records in the index.
+ */
+size_t ZSTDSeek_keyIndexLength(ZSTDSeek_KeyIndex *index);
+
+/*
+ * Find the first record with key and read it from sctx, decoding only the frame where it begins up to the record.
+ * The key of the record is checked, so collisions of the hashes are never reported.
+ * record points to the record, without the delimiter, in a buffer owned by index and valid until the next lookup, length is its size.
+ * If offset is not NULL the position of the record is written there. sctx is left at the end of the record.
+ * Returns 1 if found, 0 if not, -1 on failure.
+ */
+int ZSTDSeek_lookupKey(ZSTDSeek_Context *sctx, ZSTDSeek_KeyIndex *index, const void *key, size_t keySize, const void **record, size_t *length, size_t *offset);
+
+/*
+ * Unmap and free the index.
+ */
+void ZSTDSeek_closeKeyIndex(ZSTDSeek_KeyIndex *index);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
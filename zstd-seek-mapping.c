@@ -0,0 +1,545 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#define _GNU_SOURCE //syscall
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include "zstd-seek-mapping.h"
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/userfaultfd.h>
+
+enum{
+    PAGE_MISSING,
+    PAGE_LOADING,
+    PAGE_RESIDENT,
+    PAGE_POISONED //the data couldn't be decompressed, the page raises SIGBUS
+};
+
+typedef struct ZSTDSeek_MappingChunk_s{
+    size_t firstPage;
+    size_t pages;
+    struct ZSTDSeek_MappingChunk_s *next;
+} ZSTDSeek_MappingChunk;
+
+struct ZSTDSeek_Mapping_s{
+    ZSTDSeek_Context *sctx;
+    size_t size;     //the uncompressed size
+    size_t viewStart;//the position of sctx in the jump table
+    size_t pageSize;
+    size_t length;   //the size of the address range, a multiple of pageSize
+    uint8_t *addr;
+    int uffd;
+    int stopFd;      //readable when the threads must stop
+    int poison;      //UFFDIO_POISON is supported
+
+    pthread_mutex_t mutex;
+    uint8_t *pages;  //the state of every page
+    ZSTDSeek_MappingChunk *oldest; //the pages loaded by each fault, in the order they were loaded
+    ZSTDSeek_MappingChunk *newest;
+    size_t resident; //the bytes of the pages resident or loading
+    size_t residentLimit;
+    size_t maxFillPages;
+
+    ZSTDSeek_Context **views;
+    int nviews;
+    pthread_t *threads;
+    int nthreads; //the threads started
+};
+
+/*
+ * The index of the frame of the jump table that contains the uncompressed position pos.
+ */
+size_t ZSTDSeek_mappingFrameOf(ZSTDSeek_JumpTable *jt, size_t pos){
+    size_t lo = 0;
+    size_t hi = jt->length - 1; //the last record is the end of the data
+    while(lo + 1 < hi){
+        size_t mid = lo + (hi - lo) / 2;
+        if(jt->records[mid].uncompressedPos <= pos){
+            lo = mid;
+        }else{
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*
+ * The pages to load to resolve a fault in page, with the mutex held: the ones of the frames that cover it, except the pages
+ * shared with other frames, that are missing and contiguous to it, at most maxFillPages.
+ */
+void ZSTDSeek_mappingFillRange(ZSTDSeek_Mapping *map, size_t page, size_t *first, size_t *end){
+    size_t ps = map->pageSize;
+    size_t pos = page * ps;
+    size_t pageEnd = pos + ps < map->size ? pos + ps : map->size;
+
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(map->sctx);
+    size_t frameStart = jt->records[ZSTDSeek_mappingFrameOf(jt, map->viewStart + pos)].uncompressedPos;
+    size_t frameEnd = jt->records[ZSTDSeek_mappingFrameOf(jt, map->viewStart + pageEnd - 1) + 1].uncompressedPos;
+    frameStart = frameStart > map->viewStart ? frameStart - map->viewStart : 0;
+    frameEnd = frameEnd - map->viewStart < map->size ? frameEnd - map->viewStart : map->size;
+
+    size_t lo = (frameStart + ps - 1) / ps;
+    size_t hi = (frameEnd == map->size ? map->length : frameEnd) / ps;
+    lo = lo < page ? lo : page;
+    hi = hi > page + 1 ? hi : page + 1;
+
+    size_t a = page;
+    size_t b = page + 1;
+    while(a > lo && map->pages[a-1] == PAGE_MISSING){
+        a--;
+    }
+    while(b < hi && map->pages[b] == PAGE_MISSING){
+        b++;
+    }
+    if(b - a > map->maxFillPages){ //mostly after the page, where a sequential access goes
+        size_t back = b - map->maxFillPages < page ? b - map->maxFillPages : page;
+        a = back > a ? back : a;
+        b = a + map->maxFillPages < b ? a + map->maxFillPages : b;
+    }
+    *first = a;
+    *end = b;
+}
+
+/*
+ * Discard the pages loaded first, with the mutex held.
+ */
+void ZSTDSeek_mappingReclaim(ZSTDSeek_Mapping *map){
+    ZSTDSeek_MappingChunk *chunk = map->oldest;
+    map->oldest = chunk->next;
+    if(!map->oldest){
+        map->newest = NULL;
+    }
+    //still under the mutex, so that no fault finds the pages missing while they are still mapped
+    memset(map->pages + chunk->firstPage, PAGE_MISSING, chunk->pages);
+    if(madvise(map->addr + chunk->firstPage * map->pageSize, chunk->pages * map->pageSize, MADV_DONTNEED) != 0){
+        DEBUG("Can't discard the pages\n");
+    }
+    map->resident -= chunk->pages * map->pageSize;
+    free(chunk);
+}
+
+void ZSTDSeek_mappingWake(ZSTDSeek_Mapping *map, size_t firstPage, size_t pages){
+    struct uffdio_range range = {(uintptr_t)(map->addr + firstPage * map->pageSize), pages * map->pageSize};
+    if(ioctl(map->uffd, UFFDIO_WAKE, &range) != 0){
+        DEBUG("Can't wake the threads\n");
+    }
+}
+
+/*
+ * Install the pages, waking the threads waiting for them.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_mappingCopy(ZSTDSeek_Mapping *map, size_t firstPage, size_t pages, const uint8_t *buff){
+    size_t len = pages * map->pageSize;
+    size_t done = 0;
+    while(done < len){
+        struct uffdio_copy copy = {(uintptr_t)(map->addr + firstPage * map->pageSize + done), (uintptr_t)(buff + done), len - done, 0, 0};
+        if(ioctl(map->uffd, UFFDIO_COPY, &copy) == 0){
+            return 0;
+        }
+        if(copy.copy > 0){
+            done += copy.copy;
+        }else if(errno == EEXIST){ //it shouldn't happen, skip the page
+            ZSTDSeek_mappingWake(map, firstPage + done / map->pageSize, 1);
+            done += map->pageSize;
+        }else if(errno != EAGAIN){
+            DEBUG("Can't copy the pages\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Make the access to the pages raise SIGBUS.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_mappingPoison(ZSTDSeek_Mapping *map, size_t firstPage, size_t pages){
+#ifdef UFFDIO_POISON
+    if(map->poison){
+        struct uffdio_poison poison = {{(uintptr_t)(map->addr + firstPage * map->pageSize), pages * map->pageSize}, 0, 0};
+        if(ioctl(map->uffd, UFFDIO_POISON, &poison) == 0){
+            return 0;
+        }
+        DEBUG("Can't poison the pages\n");
+    }
+#else
+    (void)map;
+    (void)firstPage;
+    (void)pages;
+#endif
+    return -1;
+}
+
+/*
+ * Resolve a fault at address decompressing the pages around it with view into buff, grown as needed.
+ */
+void ZSTDSeek_mappingFault(ZSTDSeek_Mapping *map, ZSTDSeek_Context *view, uint8_t **buff, size_t *buffSize, uintptr_t address){
+    size_t ps = map->pageSize;
+    size_t page = (address - (uintptr_t)map->addr) / ps;
+    if(address < (uintptr_t)map->addr || page * ps >= map->length){
+        return;
+    }
+
+    pthread_mutex_lock(&map->mutex);
+    uint8_t state = map->pages[page];
+    if(state != PAGE_MISSING){
+        pthread_mutex_unlock(&map->mutex);
+        if(state != PAGE_LOADING){ //loaded after the fault, the copy didn't wake this thread
+            ZSTDSeek_mappingWake(map, page, 1);
+        }
+        return; //otherwise it's woken by the copy in progress
+    }
+    size_t first, end;
+    ZSTDSeek_mappingFillRange(map, page, &first, &end);
+    size_t pages = end - first;
+    size_t len = pages * ps;
+    while(map->residentLimit && map->resident + len > map->residentLimit && map->oldest){
+        ZSTDSeek_mappingReclaim(map);
+    }
+    memset(map->pages + first, PAGE_LOADING, pages);
+    map->resident += len;
+    pthread_mutex_unlock(&map->mutex);
+
+    ZSTDSeek_MappingChunk *chunk = malloc(sizeof(ZSTDSeek_MappingChunk));
+    if(*buffSize < len){
+        free(*buff);
+        *buffSize = 0;
+        if(posix_memalign((void **)buff, ps, len) == 0){
+            *buffSize = len;
+        }else{
+            *buff = NULL;
+        }
+    }
+
+    size_t offset = first * ps;
+    size_t decoded = 0;
+    int failed = !chunk || *buffSize < len || ZSTDSeek_seek(view, (long)offset, SEEK_SET) != 0;
+    while(!failed && decoded < len && offset + decoded < map->size){
+        size_t n = ZSTDSeek_read(*buff + decoded, len - decoded, view);
+        if(n == (size_t)ZSTDSEEK_ERR_READ || n == 0){
+            failed = n == (size_t)ZSTDSEEK_ERR_READ;
+            break;
+        }
+        decoded += n;
+    }
+
+    if(failed){
+        DEBUG("Can't decompress the pages at %zu\n", offset);
+        if(*buffSize >= len){
+            memset(*buff, 0, len);
+        }
+    }else{
+        memset(*buff + decoded, 0, len - decoded); //after the end of the data
+    }
+
+    if(failed && ZSTDSeek_mappingPoison(map, first, pages) == 0){
+        pthread_mutex_lock(&map->mutex);
+        memset(map->pages + first, PAGE_POISONED, pages);
+        map->resident -= len;
+        pthread_mutex_unlock(&map->mutex);
+        free(chunk);
+        return;
+    }
+    if(!chunk || *buffSize < len || ZSTDSeek_mappingCopy(map, first, pages, *buff) != 0){
+        //the faulting threads fault again and the pages are loaded by another attempt
+        pthread_mutex_lock(&map->mutex);
+        memset(map->pages + first, PAGE_MISSING, pages);
+        map->resident -= len;
+        pthread_mutex_unlock(&map->mutex);
+        ZSTDSeek_mappingWake(map, first, pages);
+        free(chunk);
+        return;
+    }
+
+    pthread_mutex_lock(&map->mutex);
+    memset(map->pages + first, PAGE_RESIDENT, pages);
+    chunk->firstPage = first;
+    chunk->pages = pages;
+    chunk->next = NULL;
+    if(map->newest){
+        map->newest->next = chunk;
+    }else{
+        map->oldest = chunk;
+    }
+    map->newest = chunk;
+    pthread_mutex_unlock(&map->mutex);
+}
+
+typedef struct{
+    ZSTDSeek_Mapping *map;
+    ZSTDSeek_Context *view;
+} ZSTDSeek_MappingWorker;
+
+void* ZSTDSeek_mappingWorker(void *arg){
+    ZSTDSeek_MappingWorker *worker = (ZSTDSeek_MappingWorker *)arg;
+    ZSTDSeek_Mapping *map = worker->map;
+    ZSTDSeek_Context *view = worker->view;
+    free(worker);
+
+    uint8_t *buff = NULL;
+    size_t buffSize = 0;
+    struct pollfd fds[2] = {{map->uffd, POLLIN, 0}, {map->stopFd, POLLIN, 0}};
+    while(1){
+        if(poll(fds, 2, -1) < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            DEBUG("Can't wait for the faults\n");
+            break;
+        }
+        if(fds[1].revents){
+            break;
+        }
+        struct uffd_msg msg;
+        if(read(map->uffd, &msg, sizeof(msg)) != sizeof(msg)){
+            continue; //read by another thread
+        }
+        if(msg.event == UFFD_EVENT_PAGEFAULT){
+            ZSTDSeek_mappingFault(map, view, &buff, &buffSize, (uintptr_t)msg.arg.pagefault.address);
+        }
+    }
+    free(buff);
+    return NULL;
+}
+
+/*
+ * Open a userfaultfd, with the faults of the kernel too if allowed.
+ * Returns -1 in case of failure.
+ */
+int ZSTDSeek_mappingOpenUffd(int *poison){
+    *poison = 0;
+#ifdef UFFD_USER_MODE_ONLY
+    int flags[] = {O_CLOEXEC | O_NONBLOCK, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY};
+#else
+    int flags[] = {O_CLOEXEC | O_NONBLOCK}; //kernel headers older than 5.11
+#endif
+    for(size_t i = 0; i < sizeof(flags)/sizeof(flags[0]); i++){
+        int uffd = (int)syscall(SYS_userfaultfd, flags[i]);
+        if(uffd < 0){
+            continue;
+        }
+        struct uffdio_api api = {UFFD_API, 0, 0};
+        if(ioctl(uffd, UFFDIO_API, &api) != 0){
+            close(uffd);
+            return -1;
+        }
+#if defined(UFFDIO_POISON) && defined(UFFD_FEATURE_POISON)
+        if(api.features & UFFD_FEATURE_POISON){ //the features are enabled by the first UFFDIO_API only, so open it again
+            close(uffd);
+            uffd = (int)syscall(SYS_userfaultfd, flags[i]);
+            struct uffdio_api poisonApi = {UFFD_API, UFFD_FEATURE_POISON, 0};
+            if(uffd < 0 || ioctl(uffd, UFFDIO_API, &poisonApi) != 0){
+                if(uffd >= 0){
+                    close(uffd);
+                }
+                return -1;
+            }
+            *poison = 1;
+        }
+#endif
+        return uffd;
+    }
+    return -1;
+}
+
+ZSTDSeek_Mapping* ZSTDSeek_createMapping(ZSTDSeek_Context *sctx, size_t residentLimit, int nthreads){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        errno = EINVAL;
+        return NULL;
+    }
+    if(ZSTDSeek_initializeJumpTable(sctx) != 0){
+        return NULL;
+    }
+    if(nthreads <= 0){
+        nthreads = ZSTDSeek_defaultNumberOfThreads();
+    }
+
+    ZSTDSeek_Mapping *map = calloc(1, sizeof(ZSTDSeek_Mapping));
+    if(!map){
+        errno = ENOMEM;
+        return NULL;
+    }
+    map->sctx = sctx;
+    map->size = ZSTDSeek_uncompressedFileSize(sctx);
+    map->viewStart = ZSTDSeek_getViewStart(sctx);
+    map->pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    map->length = map->size > 0 ? (map->size + map->pageSize - 1) / map->pageSize * map->pageSize : map->pageSize;
+    map->addr = MAP_FAILED;
+    map->uffd = map->stopFd = -1;
+
+    size_t maxFill = ZSTDSEEK_MAPPING_MAX_FILL_SIZE;
+    if(residentLimit && residentLimit / nthreads < maxFill){ //the faults resolved at the same time fit in the limit
+        maxFill = residentLimit / nthreads;
+    }
+    map->maxFillPages = maxFill / map->pageSize > 0 ? maxFill / map->pageSize : 1;
+    map->residentLimit = residentLimit;
+    pthread_mutex_init(&map->mutex, NULL);
+
+    map->uffd = ZSTDSeek_mappingOpenUffd(&map->poison);
+    if(map->uffd < 0){
+        DEBUG("userfaultfd is not available\n");
+        ZSTDSeek_freeMapping(map);
+        errno = ENOSYS;
+        return NULL;
+    }
+    map->stopFd = eventfd(0, EFD_CLOEXEC);
+    map->pages = calloc(map->length / map->pageSize, 1);
+    map->addr = mmap(NULL, map->length, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(map->stopFd < 0 || !map->pages || map->addr == MAP_FAILED){
+        ZSTDSeek_freeMapping(map);
+        errno = ENOMEM;
+        return NULL;
+    }
+    struct uffdio_register reg = {{(uintptr_t)map->addr, map->length}, UFFDIO_REGISTER_MODE_MISSING, 0};
+    if(ioctl(map->uffd, UFFDIO_REGISTER, &reg) != 0){
+        DEBUG("Can't register the address range\n");
+        ZSTDSeek_freeMapping(map);
+        errno = ENOSYS;
+        return NULL;
+    }
+
+    //the views are created here, the threads only use them
+    map->views = calloc(nthreads, sizeof(ZSTDSeek_Context *));
+    map->threads = calloc(nthreads, sizeof(pthread_t));
+    if(!map->views || !map->threads){
+        ZSTDSeek_freeMapping(map);
+        errno = ENOMEM;
+        return NULL;
+    }
+    map->nviews = nthreads;
+    for(int i = 0; i < nthreads; i++){
+        ZSTDSeek_MappingWorker *worker = malloc(sizeof(ZSTDSeek_MappingWorker));
+        map->views[i] = ZSTDSeek_createView(sctx, 0, map->size);
+        if(!worker || !map->views[i]){
+            free(worker);
+            break;
+        }
+        worker->map = map;
+        worker->view = map->views[i];
+        if(pthread_create(&map->threads[i], NULL, ZSTDSeek_mappingWorker, worker) != 0){
+            free(worker);
+            break;
+        }
+        map->nthreads++;
+    }
+    if(map->nthreads == 0){
+        DEBUG("Can't start the threads\n");
+        ZSTDSeek_freeMapping(map);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return map;
+}
+
+const void* ZSTDSeek_mappingAddress(ZSTDSeek_Mapping *map){
+    return map ? map->addr : NULL;
+}
+
+size_t ZSTDSeek_mappingSize(ZSTDSeek_Mapping *map){
+    return map ? map->size : 0;
+}
+
+size_t ZSTDSeek_mappingResidentSize(ZSTDSeek_Mapping *map){
+    if(!map){
+        return 0;
+    }
+    pthread_mutex_lock(&map->mutex);
+    size_t resident = map->resident;
+    pthread_mutex_unlock(&map->mutex);
+    return resident;
+}
+
+void ZSTDSeek_freeMapping(ZSTDSeek_Mapping *map){
+    if(!map){
+        return;
+    }
+
+    if(map->nthreads > 0){
+        uint64_t one = 1;
+        if(write(map->stopFd, &one, sizeof(one)) != sizeof(one)){
+            DEBUG("Can't stop the threads\n");
+        }
+        for(int i = 0; i < map->nthreads; i++){
+            pthread_join(map->threads[i], NULL);
+        }
+    }
+    for(int i = 0; i < map->nviews; i++){
+        if(map->views[i]){
+            ZSTDSeek_free(map->views[i]);
+        }
+    }
+    if(map->addr != MAP_FAILED){
+        munmap(map->addr, map->length);
+    }
+    if(map->uffd >= 0){
+        close(map->uffd);
+    }
+    if(map->stopFd >= 0){
+        close(map->stopFd);
+    }
+    while(map->oldest){
+        ZSTDSeek_MappingChunk *chunk = map->oldest;
+        map->oldest = chunk->next;
+        free(chunk);
+    }
+    pthread_mutex_destroy(&map->mutex);
+    free(map->pages);
+    free(map->views);
+    free(map->threads);
+    free(map);
+}
+
+#else
+
+ZSTDSeek_Mapping* ZSTDSeek_createMapping(ZSTDSeek_Context *sctx, size_t residentLimit, int nthreads){
+    (void)sctx;
+    (void)residentLimit;
+    (void)nthreads;
+    DEBUG("userfaultfd is not available\n");
+    errno = ENOSYS;
+    return NULL;
+}
+
+const void* ZSTDSeek_mappingAddress(ZSTDSeek_Mapping *map){
+    (void)map;
+    return NULL;
+}
+
+size_t ZSTDSeek_mappingSize(ZSTDSeek_Mapping *map){
+    (void)map;
+    return 0;
+}
+
+size_t ZSTDSeek_mappingResidentSize(ZSTDSeek_Mapping *map){
+    (void)map;
+    return 0;
+}
+
+void ZSTDSeek_freeMapping(ZSTDSeek_Mapping *map){
+    (void)map;
+}
+
+#endif
@@ -0,0 +1,71 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_MAPPING_
+#define _ZSTD_SEEK_MAPPING_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Structs */
+
+typedef struct ZSTDSeek_Mapping_s ZSTDSeek_Mapping;
+
+/* Mapping constants */
+#define ZSTDSEEK_MAPPING_MAX_FILL_SIZE (8*1024*1024) //the most bytes decompressed to resolve a page fault
+
+/* Mapping API */
+
+/*
+ * Map the uncompressed data of sctx in memory, read only, eg to use pointers or code written for a mmap'd file.
+ * An address range as big as the uncompressed data is reserved but nothing is decompressed until it's accessed:
+ * the page faults are resolved by nthreads threads (<= 0 means one per CPU) with userfaultfd, each decompressing the frame
+ * that covers the page in the pages around it, so concurrent faults in different frames are resolved in parallel.
+ * If residentLimit is not 0 the pages loaded first are discarded, and loaded again when accessed, to keep the resident
+ * size within it. It should be well above the memory accessed at the same time by the threads of the program,
+ * or they keep discarding each other's pages.
+ * The jump table of sctx is fully initialized first. sctx must outlive the mapping.
+ * If the kernel resolves only the faults of user space, see UFFD_USER_MODE_ONLY, system calls that read a page not loaded yet,
+ * eg write from the mapping, fail with EFAULT.
+ * Where the data can't be decompressed the pages raise SIGBUS if the kernel supports UFFDIO_POISON, they are zeros otherwise.
+ * It requires Linux.
+ * Returns 0 in case of failure, with errno set to ENOSYS if userfaultfd is not available.
+ */
+ZSTDSeek_Mapping* ZSTDSeek_createMapping(ZSTDSeek_Context *sctx, size_t residentLimit, int nthreads);
+
+/*
+ * Returns the address of the uncompressed data, ZSTDSeek_mappingSize bytes long.
+ */
+const void* ZSTDSeek_mappingAddress(ZSTDSeek_Mapping *map);
+
+/*
+ * Returns the size of the uncompressed data.
+ */
+size_t ZSTDSeek_mappingSize(ZSTDSeek_Mapping *map);
+
+/*
+ * Returns the bytes of the mapping loaded in memory, or being loaded.
+ */
+size_t ZSTDSeek_mappingResidentSize(ZSTDSeek_Mapping *map);
+
+/*
+ * Unmap the data and stop the threads. No thread must access the mapping anymore.
+ */
+void ZSTDSeek_freeMapping(ZSTDSeek_Mapping *map);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
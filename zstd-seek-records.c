@@ -0,0 +1,327 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "zstd-seek-records.h"
+#include "zstd-seek-internal.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+typedef struct {
+    size_t pos;        //where the frame, or the part of it in the context, begins
+    size_t delimiters; //how many delimiters are before pos
+} ZSTDSeek_RecordCheckpoint;
+
+struct ZSTDSeek_RecordIndex_s{
+    uint8_t delimiter;
+    ZSTDSeek_RecordCheckpoint *checkpoints; //one per frame, sorted
+    size_t length;
+    size_t delimiters; //the total number of delimiters
+    size_t size;       //the uncompressed size
+    int unterminated;  //1 if the last record doesn't end with the delimiter
+    size_t compressedSize; //the size of the file the index was built for
+    uint64_t fileHash;     //and its fingerprint
+};
+
+typedef struct {
+    uint8_t delimiter;
+    ZSTDSeek_RecordCheckpoint *frames; //indexed by frame, pos is SIZE_MAX for the frames outside the context
+    uint8_t *lastBytes; //the last byte of each frame
+    size_t *sizes;
+} ZSTDSeek_RecordScan;
+
+size_t ZSTDSeek_countByte(const void *data, size_t size, uint8_t byte){
+    const uint8_t *p = (const uint8_t *)data;
+    size_t count = 0;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i needle = _mm256_set1_epi8((char)byte);
+    while(i + 32 <= size){
+        //the byte counters of acc can't overflow in 255 iterations, then they are summed in 64 bit lanes
+        __m256i acc = _mm256_setzero_si256();
+        size_t end = i + 255*32 < size ? i + 255*32 : size;
+        for(; i + 32 <= end; i += 32){
+            __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(v, needle));
+        }
+        __m256i sums = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+        count += (size_t)_mm256_extract_epi64(sums, 0) + (size_t)_mm256_extract_epi64(sums, 1) +
+                 (size_t)_mm256_extract_epi64(sums, 2) + (size_t)_mm256_extract_epi64(sums, 3);
+    }
+#elif defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8((char)byte);
+    while(i + 16 <= size){
+        //the byte counters of acc can't overflow in 255 iterations, then they are summed in 64 bit lanes
+        __m128i acc = _mm_setzero_si128();
+        size_t end = i + 255*16 < size ? i + 255*16 : size;
+        for(; i + 16 <= end; i += 16){
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(v, needle));
+        }
+        __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+        count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+#endif
+
+    for(; i < size; i++){
+        count += p[i] == byte;
+    }
+    return count;
+}
+
+int ZSTDSeek_recordScanFrame(const void *data, size_t size, size_t uncompressedPos, size_t frame, void *user){
+    ZSTDSeek_RecordScan *scan = (ZSTDSeek_RecordScan *)user;
+    scan->frames[frame] = (ZSTDSeek_RecordCheckpoint){uncompressedPos, ZSTDSeek_countByte(data, size, scan->delimiter)};
+    scan->lastBytes[frame] = size ? ((const uint8_t *)data)[size-1] : scan->delimiter;
+    scan->sizes[frame] = size;
+    return 0;
+}
+
+ZSTDSeek_RecordIndex* ZSTDSeek_newRecordIndex(ZSTDSeek_Context *sctx, uint8_t delimiter){
+    ZSTDSeek_RecordIndex *index = calloc(1, sizeof(ZSTDSeek_RecordIndex));
+    if(index){
+        index->delimiter = delimiter;
+        ZSTDSeek_getCompressedBuffer(sctx, &index->compressedSize);
+        index->fileHash = ZSTDSeek_fileHash(sctx);
+    }
+    return index;
+}
+
+ZSTDSeek_RecordIndex* ZSTDSeek_buildRecordIndex(ZSTDSeek_Context *sctx, uint8_t delimiter, int nthreads){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return NULL;
+    }
+
+    if(ZSTDSeek_initializeJumpTable(sctx) != 0){
+        DEBUG("Can't initialize the jump table\n");
+        return NULL;
+    }
+    size_t frames = ZSTDSeek_getJumpTableOfContext(sctx)->length;
+
+    ZSTDSeek_RecordScan scan;
+    scan.delimiter = delimiter;
+    scan.frames = malloc(frames*sizeof(ZSTDSeek_RecordCheckpoint));
+    scan.lastBytes = malloc(frames);
+    scan.sizes = malloc(frames*sizeof(size_t));
+    ZSTDSeek_RecordIndex *index = ZSTDSeek_newRecordIndex(sctx, delimiter);
+    if(!scan.frames || !scan.lastBytes || !scan.sizes || !index){
+        goto fail;
+    }
+    for(size_t i = 0; i < frames; i++){
+        scan.frames[i].pos = SIZE_MAX;
+    }
+
+    if(ZSTDSeek_forEachFrameParallel(sctx, ZSTDSeek_recordScanFrame, &scan, nthreads) != 0){
+        DEBUG("Can't scan the frames\n");
+        goto fail;
+    }
+
+    //turn the counts of the frames in the context in a prefix sum
+    index->checkpoints = malloc(frames*sizeof(ZSTDSeek_RecordCheckpoint));
+    if(!index->checkpoints){
+        goto fail;
+    }
+    uint8_t lastByte = delimiter;
+    for(size_t i = 0; i < frames; i++){
+        if(scan.frames[i].pos == SIZE_MAX){
+            continue;
+        }
+        index->checkpoints[index->length++] = (ZSTDSeek_RecordCheckpoint){scan.frames[i].pos, index->delimiters};
+        index->delimiters += scan.frames[i].delimiters;
+        index->size += scan.sizes[i];
+        if(scan.sizes[i]){
+            lastByte = scan.lastBytes[i];
+        }
+    }
+    index->unterminated = lastByte != delimiter;
+
+    free(scan.frames);
+    free(scan.lastBytes);
+    free(scan.sizes);
+    return index;
+
+fail:
+    free(scan.frames);
+    free(scan.lastBytes);
+    free(scan.sizes);
+    if(index){
+        ZSTDSeek_freeRecordIndex(index);
+    }
+    return NULL;
+}
+
+int ZSTDSeek_saveRecordIndex(ZSTDSeek_RecordIndex *index, const char *file){
+    if(!index || !file){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    FILE *f = fopen(file, "wb");
+    if(!f){
+        DEBUG("Unable to open '%s'\n", file);
+        return -1;
+    }
+
+    int ret = ZSTDSeek_writeLE(f, ZSTDSEEK_RECORD_INDEX_MAGICNUMBER, 8) |
+              ZSTDSeek_writeLE(f, ZSTDSEEK_RECORD_INDEX_VERSION, 8) |
+              ZSTDSeek_writeLE(f, index->compressedSize, 8) |
+              ZSTDSeek_writeLE(f, index->fileHash, 8) |
+              ZSTDSeek_writeLE(f, index->delimiter, 8) |
+              ZSTDSeek_writeLE(f, index->delimiters, 8) |
+              ZSTDSeek_writeLE(f, index->size, 8) |
+              ZSTDSeek_writeLE(f, index->unterminated, 8) |
+              ZSTDSeek_writeLE(f, index->length, 8);
+    for(size_t i = 0; i < index->length && ret == 0; i++){
+        ret = ZSTDSeek_writeLE(f, index->checkpoints[i].pos, 8) |
+              ZSTDSeek_writeLE(f, index->checkpoints[i].delimiters, 8);
+    }
+
+    if(fclose(f) != 0){
+        ret = -1;
+    }
+    return ret;
+}
+
+ZSTDSeek_RecordIndex* ZSTDSeek_loadRecordIndex(ZSTDSeek_Context *sctx, const char *file){
+    if(!sctx || !file){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+
+    FILE *f = fopen(file, "rb");
+    if(!f){
+        DEBUG("Unable to open '%s'\n", file);
+        return NULL;
+    }
+
+    ZSTDSeek_RecordIndex *index = ZSTDSeek_newRecordIndex(sctx, 0);
+    uint64_t magic, version, compressedSize, fileHash, delimiter, delimiters, size, unterminated, length;
+    if(!index || ZSTDSeek_readLE(f, &magic, 8) || ZSTDSeek_readLE(f, &version, 8) || ZSTDSeek_readLE(f, &compressedSize, 8) ||
+       ZSTDSeek_readLE(f, &fileHash, 8) || ZSTDSeek_readLE(f, &delimiter, 8) || ZSTDSeek_readLE(f, &delimiters, 8) || ZSTDSeek_readLE(f, &size, 8) ||
+       ZSTDSeek_readLE(f, &unterminated, 8) || ZSTDSeek_readLE(f, &length, 8) ||
+       magic != ZSTDSEEK_RECORD_INDEX_MAGICNUMBER || version != ZSTDSEEK_RECORD_INDEX_VERSION || compressedSize != index->compressedSize ||
+       fileHash != index->fileHash){
+        DEBUG("'%s' is not a record index of this file\n", file);
+        goto fail;
+    }
+
+    index->delimiter = (uint8_t)delimiter;
+    index->delimiters = delimiters;
+    index->size = size;
+    index->unterminated = (int)unterminated;
+    index->checkpoints = malloc(length*sizeof(ZSTDSeek_RecordCheckpoint));
+    if(!index->checkpoints){
+        goto fail;
+    }
+    for(; index->length < length; index->length++){
+        uint64_t pos, count;
+        if(ZSTDSeek_readLE(f, &pos, 8) || ZSTDSeek_readLE(f, &count, 8)){
+            goto fail;
+        }
+        index->checkpoints[index->length] = (ZSTDSeek_RecordCheckpoint){pos, count};
+    }
+
+    fclose(f);
+    return index;
+
+fail:
+    fclose(f);
+    if(index){
+        ZSTDSeek_freeRecordIndex(index);
+    }
+    return NULL;
+}
+
+size_t ZSTDSeek_recordCount(ZSTDSeek_RecordIndex *index){
+    if(!index){
+        DEBUG("Invalid argument\n");
+        return 0;
+    }
+    return index->delimiters + (index->unterminated ? 1 : 0);
+}
+
+uint8_t ZSTDSeek_recordDelimiter(ZSTDSeek_RecordIndex *index){
+    return index ? index->delimiter : 0;
+}
+
+int ZSTDSeek_seekToRecord(ZSTDSeek_Context *sctx, ZSTDSeek_RecordIndex *index, size_t n){
+    if(!sctx || !index){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    if(n >= ZSTDSeek_recordCount(index)){
+        DEBUG("Record %zu beyond the end of the file\n", n);
+        return ZSTDSEEK_ERR_BEYOND_END_SEEK;
+    }
+    if(n == 0){
+        return ZSTDSeek_seek(sctx, 0, SEEK_SET);
+    }
+
+    //record n begins after the n-th delimiter, find the last frame with less than n delimiters before it
+    size_t l = 0;
+    size_t r = index->length;
+    while(r - l > 1){
+        size_t m = l + (r-l)/2;
+        if(index->checkpoints[m].delimiters >= n){
+            r = m;
+        }else{
+            l = m;
+        }
+    }
+
+    ZSTDSeek_RecordCheckpoint c = index->checkpoints[l];
+    if(ZSTDSeek_seek(sctx, (long)c.pos, SEEK_SET) != 0){
+        return -1;
+    }
+
+    //the data is scanned in the decode buffer, and consumed up until the delimiter so nothing is decompressed twice
+    size_t missing = n - c.delimiters;
+    const void *data;
+    size_t len;
+    while(ZSTDSeek_peek(sctx, &data, &len) == 1){
+        const uint8_t *buff = (const uint8_t *)data;
+        size_t count = ZSTDSeek_countByte(buff, len, index->delimiter);
+        if(count < missing){
+            missing -= count;
+            ZSTDSeek_consume(sctx, len);
+            continue;
+        }
+        const uint8_t *p = buff;
+        while(1){
+            p = memchr(p, index->delimiter, buff + len - p);
+            p++;
+            if(--missing == 0){
+                break;
+            }
+        }
+        return ZSTDSeek_consume(sctx, (size_t)(p - buff));
+    }
+
+    DEBUG("The index doesn't match the file\n");
+    return -1;
+}
+
+void ZSTDSeek_freeRecordIndex(ZSTDSeek_RecordIndex *index){
+    if(!index){
+        DEBUG("Invalid argument\n");
+        return;
+    }
+    free(index->checkpoints);
+    free(index);
+}
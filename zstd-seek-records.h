@@ -0,0 +1,82 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_RECORDS_
+#define _ZSTD_SEEK_RECORDS_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Record index constants */
+#define ZSTDSEEK_RECORD_INDEX_MAGICNUMBER 0x4952535A //"ZSRI"
+#define ZSTDSEEK_RECORD_INDEX_VERSION 2
+
+/* Structs */
+
+typedef struct ZSTDSeek_RecordIndex_s ZSTDSeek_RecordIndex;
+
+/* Record Index API */
+
+/*
+ * Build an index of the records of sctx, eg lines when delimiter is '\n'.
+ * Records end with the delimiter, the last one can end with the file instead.
+ * The frames are decompressed once on nthreads threads (<= 0 means one per CPU) and the delimiters counted with SIMD instructions when available.
+ * The index stores how many records end before each frame, so it's as small as the jump table.
+ * Returns 0 in case of failure.
+ */
+ZSTDSeek_RecordIndex* ZSTDSeek_buildRecordIndex(ZSTDSeek_Context *sctx, uint8_t delimiter, int nthreads);
+
+/*
+ * Save the index to file. Returns 0 on success.
+ */
+int ZSTDSeek_saveRecordIndex(ZSTDSeek_RecordIndex *index, const char *file);
+
+/*
+ * Load an index saved with ZSTDSeek_saveRecordIndex for the file of sctx.
+ * Returns 0 in case of failure or if the index was built for a different file.
+ */
+ZSTDSeek_RecordIndex* ZSTDSeek_loadRecordIndex(ZSTDSeek_Context *sctx, const char *file);
+
+/*
+ * Returns the number of records, without decompressing anything.
+ */
+size_t ZSTDSeek_recordCount(ZSTDSeek_RecordIndex *index);
+
+/*
+ * Returns the delimiter the index was built with.
+ */
+uint8_t ZSTDSeek_recordDelimiter(ZSTDSeek_RecordIndex *index);
+
+/*
+ * Seek sctx to the beginning of record n, counting from 0.
+ * Only the frame with the beginning of the record is decompressed, up to the record.
+ * Returns 0 on success, ZSTDSEEK_ERR_BEYOND_END_SEEK if there are not enough records.
+ */
+int ZSTDSeek_seekToRecord(ZSTDSeek_Context *sctx, ZSTDSeek_RecordIndex *index, size_t n);
+
+/*
+ * Count the occurrences of byte in data, with SIMD instructions when available.
+ */
+size_t ZSTDSeek_countByte(const void *data, size_t size, uint8_t byte);
+
+/*
+ * Free the index.
+ */
+void ZSTDSeek_freeRecordIndex(ZSTDSeek_RecordIndex *index);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
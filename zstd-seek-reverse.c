@@ -0,0 +1,295 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "zstd-seek-reverse.h"
+#include "zstd-seek-internal.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+typedef struct{
+    ZSTDSeek_ReverseReader *reader;
+    ZSTD_DCtx *dctx;
+    uint8_t *data;
+    size_t capacity;
+    size_t frame; //the frame in data, as numbered in the frames of the reader
+    int ret;
+} ZSTDSeek_ReverseBuffer;
+
+struct ZSTDSeek_ReverseReader_s{
+    ZSTDSeek_Context *sctx;
+    size_t viewStart;
+    ZSTDSeek_FrameRange *frames; //the frames that cover the context, sorted
+    size_t length;
+    size_t next; //frames[next-1] is the next one to return
+
+    ZSTDSeek_ReverseBuffer buffs[2];
+    int current;     //the buffer returned last
+    int prefetch;
+    int prefetching; //a thread is decompressing frames[next-1] in the other buffer
+    pthread_t thread;
+
+    //the records
+    int started;
+    int pending;         //there is a record before the end
+    const uint8_t *data; //the frame being split in records
+    size_t dataPos;
+    size_t end;          //data[0, end) is still to be split
+    uint8_t *stitch;     //a record across frames, in the last stitchSize bytes
+    size_t stitchSize;
+    size_t stitchCapacity;
+};
+
+/*
+ * Find the last byte in data, with SIMD instructions when available.
+ */
+const uint8_t* ZSTDSeek_reverseFindByte(const uint8_t *data, size_t size, uint8_t byte){
+    size_t i = size;
+
+#if defined(__AVX2__)
+    const __m256i needle = _mm256_set1_epi8((char)byte);
+    for(; i >= 32; i -= 32){
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(data + i - 32)), needle));
+        if(mask){
+            return data + i - 32 + (31 - (size_t)__builtin_clz(mask));
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8((char)byte);
+    for(; i >= 16; i -= 16){
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i - 16)), needle));
+        if(mask){
+            return data + i - 16 + (31 - (size_t)__builtin_clz(mask));
+        }
+    }
+#endif
+
+    while(i > 0){
+        if(data[--i] == byte){
+            return data + i;
+        }
+    }
+    return NULL;
+}
+
+int ZSTDSeek_reverseDecompress(ZSTDSeek_ReverseBuffer *buff){
+    ZSTDSeek_ReverseReader *reader = buff->reader;
+    ZSTDSeek_FrameRange *frame = &reader->frames[buff->frame];
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(reader->sctx);
+    size_t size = jt->records[frame->frame+1].uncompressedPos - jt->records[frame->frame].uncompressedPos;
+    if(size > buff->capacity){
+        uint8_t *tmp = realloc(buff->data, size);
+        if(!tmp){
+            return buff->ret = -1;
+        }
+        buff->data = tmp;
+        buff->capacity = size;
+    }
+    size_t ret = ZSTDSeek_decompressFrame(reader->sctx, buff->dctx, frame->frame, buff->data, buff->capacity);
+    return buff->ret = ret == (size_t)ZSTDSEEK_ERR_READ || ret != size ? -1 : 0;
+}
+
+void* ZSTDSeek_reversePrefetch(void *arg){
+    ZSTDSeek_reverseDecompress((ZSTDSeek_ReverseBuffer *)arg);
+    return NULL;
+}
+
+ZSTDSeek_ReverseReader* ZSTDSeek_createReverseReader(ZSTDSeek_Context *sctx, int prefetch){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return NULL;
+    }
+
+    ZSTDSeek_ReverseReader *reader = calloc(1, sizeof(ZSTDSeek_ReverseReader));
+    if(!reader){
+        return NULL;
+    }
+    reader->sctx = sctx;
+    reader->prefetch = prefetch;
+    reader->current = 1;
+
+    reader->viewStart = ZSTDSeek_getViewStart(sctx);
+    reader->frames = ZSTDSeek_frameRanges(sctx, &reader->length);
+    if(!reader->frames){
+        goto fail;
+    }
+    reader->next = reader->length;
+
+    for(int i = 0; i < 2; i++){
+        reader->buffs[i].reader = reader;
+        reader->buffs[i].dctx = ZSTD_createDCtx();
+        if(!reader->buffs[i].dctx){
+            goto fail;
+        }
+    }
+    return reader;
+
+fail:
+    ZSTDSeek_freeReverseReader(reader);
+    return NULL;
+}
+
+int ZSTDSeek_readPreviousFrame(ZSTDSeek_ReverseReader *reader, const void **data, size_t *size, size_t *pos){
+    if(!reader || !data || !size){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    if(reader->next == 0){
+        return 0;
+    }
+
+    size_t i = reader->next - 1;
+    ZSTDSeek_ReverseBuffer *buff = &reader->buffs[1 - reader->current];
+    if(reader->prefetching){ //it's the frame we need
+        pthread_join(reader->thread, NULL);
+        reader->prefetching = 0;
+    }else{
+        buff->frame = i;
+        ZSTDSeek_reverseDecompress(buff);
+    }
+    if(buff->ret != 0){
+        DEBUG("Can't decompress frame %zu\n", reader->frames[i].frame);
+        return -1;
+    }
+    reader->current = 1 - reader->current;
+    reader->next = i;
+
+    //the buffer of the frame returned before is free now
+    if(reader->prefetch && i > 0){
+        ZSTDSeek_ReverseBuffer *other = &reader->buffs[1 - reader->current];
+        other->frame = i - 1;
+        reader->prefetching = pthread_create(&reader->thread, NULL, ZSTDSeek_reversePrefetch, other) == 0;
+    }
+
+    ZSTDSeek_FrameRange *frame = &reader->frames[i];
+    *data = buff->data + (frame->start - ZSTDSeek_getJumpTableOfContext(reader->sctx)->records[frame->frame].uncompressedPos);
+    *size = frame->end - frame->start;
+    if(pos){
+        *pos = frame->start - reader->viewStart;
+    }
+    return 1;
+}
+
+/*
+ * Prepend size bytes of data to the record being stitched.
+ */
+int ZSTDSeek_reversePrepend(ZSTDSeek_ReverseReader *reader, const uint8_t *data, size_t size){
+    if(reader->stitchSize + size > reader->stitchCapacity){
+        size_t capacity = reader->stitchCapacity ? reader->stitchCapacity : 4096;
+        while(capacity < reader->stitchSize + size){
+            capacity *= 2;
+        }
+        uint8_t *tmp = malloc(capacity);
+        if(!tmp){
+            return -1;
+        }
+        memcpy(tmp + capacity - reader->stitchSize, reader->stitch + reader->stitchCapacity - reader->stitchSize, reader->stitchSize);
+        free(reader->stitch);
+        reader->stitch = tmp;
+        reader->stitchCapacity = capacity;
+    }
+    reader->stitchSize += size;
+    memcpy(reader->stitch + reader->stitchCapacity - reader->stitchSize, data, size);
+    return 0;
+}
+
+int ZSTDSeek_readPreviousRecord(ZSTDSeek_ReverseReader *reader, uint8_t delimiter, const void **record, size_t *size, size_t *pos){
+    if(!reader || !record || !size){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    const void *data;
+    size_t dataSize;
+    int ret;
+    if(!reader->started){
+        reader->started = 1;
+        if((ret = ZSTDSeek_readPreviousFrame(reader, &data, &dataSize, &reader->dataPos)) != 1){
+            return ret;
+        }
+        reader->data = (const uint8_t *)data;
+        reader->end = dataSize;
+        reader->pending = 1;
+        if(reader->data[reader->end-1] == delimiter){ //it ends the last record, it doesn't begin an empty one
+            reader->end--;
+        }
+    }
+    if(!reader->pending){
+        return 0;
+    }
+
+    reader->stitchSize = 0;
+    while(1){
+        const uint8_t *d = ZSTDSeek_reverseFindByte(reader->data, reader->end, delimiter);
+        if(d){
+            size_t begin = (size_t)(d - reader->data) + 1;
+            if(reader->stitchSize == 0){
+                *record = reader->data + begin;
+                *size = reader->end - begin;
+            }else{
+                if(ZSTDSeek_reversePrepend(reader, reader->data + begin, reader->end - begin) != 0){
+                    return -1;
+                }
+                *record = reader->stitch + reader->stitchCapacity - reader->stitchSize;
+                *size = reader->stitchSize;
+            }
+            if(pos){
+                *pos = reader->dataPos + begin;
+            }
+            reader->end = begin - 1;
+            return 1;
+        }
+
+        //the record begins in a previous frame
+        if(ZSTDSeek_reversePrepend(reader, reader->data, reader->end) != 0){
+            return -1;
+        }
+        if((ret = ZSTDSeek_readPreviousFrame(reader, &data, &dataSize, &reader->dataPos)) < 0){
+            return -1;
+        }
+        if(ret == 0){ //it's the first record
+            *record = reader->stitchSize ? reader->stitch + reader->stitchCapacity - reader->stitchSize : reader->data;
+            *size = reader->stitchSize;
+            if(pos){
+                *pos = 0;
+            }
+            reader->pending = 0;
+            return 1;
+        }
+        reader->data = (const uint8_t *)data;
+        reader->end = dataSize;
+    }
+}
+
+void ZSTDSeek_freeReverseReader(ZSTDSeek_ReverseReader *reader){
+    if(!reader){
+        return;
+    }
+    if(reader->prefetching){
+        pthread_join(reader->thread, NULL);
+    }
+    for(int i = 0; i < 2; i++){
+        if(reader->buffs[i].dctx){
+            ZSTD_freeDCtx(reader->buffs[i].dctx);
+        }
+        free(reader->buffs[i].data);
+    }
+    free(reader->frames);
+    free(reader->stitch);
+    free(reader);
+}
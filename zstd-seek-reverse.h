@@ -0,0 +1,63 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_REVERSE_
+#define _ZSTD_SEEK_REVERSE_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Structs */
+
+typedef struct ZSTDSeek_ReverseReader_s ZSTDSeek_ReverseReader;
+
+/* Reverse API */
+
+/*
+ * Create a reader of sctx from the end to the beginning, eg to print the last lines of a log or to iterate records newest first.
+ * Every frame is decompressed once, in one call, while with ZSTDSeek_seek each step backwards decompresses again the frame from its beginning.
+ * If prefetch is not 0 a thread decompresses the previous frame while the current one is being used,
+ * so going backwards costs as much as going forward.
+ * To read backwards from somewhere else create the reader on a view.
+ * It uses its own decoders and doesn't change the position of sctx, sctx must outlive the reader.
+ * Returns 0 in case of failure.
+ */
+ZSTDSeek_ReverseReader* ZSTDSeek_createReverseReader(ZSTDSeek_Context *sctx, int prefetch);
+
+/*
+ * Get the data of the previous frame, starting from the last one, clipped to the context, and where it begins in the context.
+ * data is valid until the next call.
+ * Returns 1 on success, 0 at the beginning of the context, -1 in case of failure.
+ */
+int ZSTDSeek_readPreviousFrame(ZSTDSeek_ReverseReader *reader, const void **data, size_t *size, size_t *pos);
+
+/*
+ * Get the previous record, starting from the last one, without the delimiter, and where it begins in the context.
+ * Records end with the delimiter, the last one can end with the file instead.
+ * A record that spans more frames is copied in a buffer of the reader, the others point to the frame. record is valid until the next call.
+ * Don't mix it with ZSTDSeek_readPreviousFrame on the same reader.
+ * Returns 1 on success, 0 at the beginning of the context, -1 in case of failure.
+ */
+int ZSTDSeek_readPreviousRecord(ZSTDSeek_ReverseReader *reader, uint8_t delimiter, const void **record, size_t *size, size_t *pos);
+
+/*
+ * Free the reader, waiting for the prefetch to end.
+ */
+void ZSTDSeek_freeReverseReader(ZSTDSeek_ReverseReader *reader);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,283 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "zstd-seek-sample.h"
+#include "zstd-seek-records.h"
+#include "zstd-seek-internal.h"
+
+#define SAMPLE_READ_SIZE 1024 //the first read after the end of a frame, the following ones double
+
+typedef struct{
+    size_t pos;
+    uint8_t *data; //NULL if the frame has less records than draws
+    size_t size;
+} ZSTDSeek_Sample;
+
+typedef struct{
+    size_t start; //in the coordinates of the jump table, clipped to the context
+    size_t end;
+    size_t index; //the position of the frame in the context, to seed its generator
+    size_t draws;
+    size_t first; //the first sample of the frame
+    int decompressed;
+} ZSTDSeek_SampleFrame;
+
+typedef struct{
+    uint8_t delimiter;
+    uint64_t seed;
+    size_t viewStart;
+    size_t end;
+    ZSTDSeek_SampleFrame *frames; //the frames drawn, sorted
+    size_t length;
+    ZSTDSeek_Sample *samples; //the samples of the frames drawn
+} ZSTDSeek_SampleJob;
+
+typedef struct{
+    ZSTDSeek_SampleJob *job;
+    ZSTDSeek_Context *view; //the one of the thread
+    uint8_t *buff;
+    size_t buffSize;
+    size_t capacity;
+    int eof;
+} ZSTDSeek_SampleWorker;
+
+/*
+ * splitmix64
+ */
+uint64_t ZSTDSeek_sampleRandom(uint64_t *state){
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * A random number in [0, n).
+ */
+size_t ZSTDSeek_sampleUniform(uint64_t *state, size_t n){
+    size_t r = (size_t)((double)(ZSTDSeek_sampleRandom(state) >> 11) * 0x1.0p-53 * (double)n);
+    return r < n ? r : n - 1;
+}
+
+/*
+ * Read from the view until there are size bytes in the buffer or the view ends.
+ */
+int ZSTDSeek_sampleFill(ZSTDSeek_SampleWorker *worker, size_t size){
+    if(size > worker->capacity){
+        uint8_t *tmp = realloc(worker->buff, size);
+        if(!tmp){
+            return -1;
+        }
+        worker->buff = tmp;
+        worker->capacity = size;
+    }
+    while(worker->buffSize < size && !worker->eof){
+        size_t len = ZSTDSeek_read(worker->buff + worker->buffSize, size - worker->buffSize, worker->view);
+        if(len == (size_t)ZSTDSEEK_ERR_READ){
+            return -1;
+        }
+        worker->eof = len == 0;
+        worker->buffSize += len;
+    }
+    return 0;
+}
+
+/*
+ * Pick frame->draws distinct records among the ones that begin in the frame, with selection sampling so they come in order.
+ */
+int ZSTDSeek_sampleFrame(ZSTDSeek_SampleWorker *worker, ZSTDSeek_SampleFrame *frame){
+    ZSTDSeek_SampleJob *job = worker->job;
+    size_t frameSize = frame->end - frame->start;
+    worker->buffSize = 0;
+    worker->eof = 0;
+    if(ZSTDSeek_moveView(worker->view, frame->start, job->end - frame->start) != 0 || ZSTDSeek_sampleFill(worker, frameSize) != 0 || worker->buffSize != frameSize){
+        return -1;
+    }
+
+    //the records that begin after a delimiter of the frame, and the first one of the context, but not after the last delimiter of the context
+    size_t records = ZSTDSeek_countByte(worker->buff, frameSize, job->delimiter);
+    int first = frame->start == job->viewStart;
+    records += first;
+    if(frame->end == job->end && worker->buff[frameSize-1] == job->delimiter){
+        records--;
+    }
+    size_t wanted = frame->draws < records ? frame->draws : records;
+
+    uint64_t state = job->seed ^ (frame->index*0xD1B54A32D192ED03ULL);
+    size_t picked = 0;
+    size_t begin = 0;
+    for(size_t seen = 0; picked < wanted; seen++){
+        if(seen > 0 || !first){ //the record after the next delimiter, there is one as long as seen < records
+            begin = (size_t)((uint8_t *)memchr(worker->buff + begin, job->delimiter, frameSize - begin) - worker->buff) + 1;
+        }
+        if(ZSTDSeek_sampleUniform(&state, records - seen) < wanted - picked){
+            //find where the record ends, reading the following frames if it goes beyond this one
+            size_t readSize = SAMPLE_READ_SIZE;
+            uint8_t *d;
+            while(!(d = memchr(worker->buff + begin, job->delimiter, worker->buffSize - begin)) && !worker->eof){
+                if(ZSTDSeek_sampleFill(worker, worker->buffSize + readSize) != 0){
+                    return -1;
+                }
+                readSize *= 2;
+            }
+            size_t size = (d ? (size_t)(d - worker->buff) : worker->buffSize) - begin;
+            ZSTDSeek_Sample *sample = &job->samples[frame->first + picked];
+            sample->data = malloc(size ? size : 1);
+            if(!sample->data){
+                return -1;
+            }
+            memcpy(sample->data, worker->buff + begin, size);
+            sample->size = size;
+            sample->pos = frame->start + begin - job->viewStart;
+            picked++;
+        }
+    }
+    return 0;
+}
+
+int ZSTDSeek_sampleDrawn(size_t index, ZSTDSeek_ParallelSlot *slot, void *user){
+    ZSTDSeek_SampleJob *job = (ZSTDSeek_SampleJob *)user;
+    ZSTDSeek_SampleWorker *worker = (ZSTDSeek_SampleWorker *)slot->local;
+    if(!worker){
+        if(!(worker = slot->local = calloc(1, sizeof(ZSTDSeek_SampleWorker)))){
+            return -1;
+        }
+        worker->job = job;
+        worker->view = slot->view;
+    }
+    if(ZSTDSeek_sampleFrame(worker, &job->frames[index]) != 0){
+        DEBUG("Can't sample the frame at %zu\n", job->frames[index].start);
+        return -1;
+    }
+    return 0;
+}
+
+void ZSTDSeek_sampleFreeWorker(void *local){
+    ZSTDSeek_SampleWorker *worker = (ZSTDSeek_SampleWorker *)local;
+    if(worker){
+        free(worker->buff);
+        free(worker);
+    }
+}
+
+int ZSTDSeek_sampleCompare(const void *a, const void *b){
+    size_t x = ((const ZSTDSeek_Sample *)a)->pos;
+    size_t y = ((const ZSTDSeek_Sample *)b)->pos;
+    return x < y ? -1 : x > y;
+}
+
+int ZSTDSeek_sampleRecords(ZSTDSeek_Context *sctx, uint8_t delimiter, size_t k, uint64_t seed, ZSTDSeek_SampleCallback fn, void *user, int nthreads){
+    if(!sctx || !fn){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    ZSTDSeek_SampleJob job;
+    memset(&job, 0, sizeof(job));
+    job.delimiter = delimiter;
+    job.seed = seed;
+
+    size_t length = 0;
+    ZSTDSeek_FrameRange *ranges = ZSTDSeek_frameRanges(sctx, &length);
+    ZSTDSeek_SampleFrame *frames = ranges ? malloc((length > 0 ? length : 1)*sizeof(ZSTDSeek_SampleFrame)) : NULL;
+    if(!frames){
+        free(ranges);
+        return -1;
+    }
+    for(size_t i = 0; i < length; i++){
+        frames[i] = (ZSTDSeek_SampleFrame){ranges[i].start, ranges[i].end, i, 0, 0, 0};
+    }
+    free(ranges);
+    job.viewStart = ZSTDSeek_getViewStart(sctx);
+    job.end = job.viewStart + ZSTDSeek_uncompressedFileSize(sctx);
+    if(length == 0 || k == 0){
+        free(frames);
+        return 0;
+    }
+
+    size_t *weights = malloc(length*sizeof(size_t));
+    ZSTDSeek_SampleFrame *drawn = malloc(length*sizeof(ZSTDSeek_SampleFrame));
+    ZSTDSeek_Sample *samples = calloc(k, sizeof(ZSTDSeek_Sample));
+    int ret = weights && drawn && samples ? 0 : -1;
+
+    //the frames drawn are decompressed once, if some have not enough records the missing ones are drawn again among the others
+    size_t collected = 0;
+    uint64_t state = seed;
+    while(ret == 0 && collected < k){
+        //each frame not yet decompressed is drawn with a probability proportional to its size
+        size_t candidates = 0;
+        size_t total = 0;
+        for(size_t i = 0; i < length; i++){
+            if(!frames[i].decompressed){
+                total += frames[i].end - frames[i].start;
+                weights[candidates] = total;
+                drawn[candidates++] = frames[i];
+            }
+        }
+        if(candidates == 0){
+            break;
+        }
+        for(size_t i = collected; i < k; i++){
+            size_t r = ZSTDSeek_sampleUniform(&state, total);
+            size_t lo = 0;
+            size_t hi = candidates - 1;
+            while(lo < hi){
+                size_t m = lo + (hi-lo)/2;
+                if(weights[m] <= r){
+                    lo = m + 1;
+                }else{
+                    hi = m;
+                }
+            }
+            drawn[lo].draws++;
+        }
+
+        job.frames = drawn;
+        job.samples = samples + collected;
+        job.length = 0;
+        size_t first = 0;
+        for(size_t i = 0; i < candidates; i++){
+            if(drawn[i].draws > 0){
+                frames[drawn[i].index].decompressed = 1;
+                drawn[job.length] = drawn[i];
+                drawn[job.length++].first = first;
+                first += drawn[i].draws;
+            }
+        }
+        ret = ZSTDSeek_forEachIndexParallel(sctx, job.length, ZSTDSeek_sampleDrawn, ZSTDSeek_sampleFreeWorker, &job, nthreads) == 0 ? 0 : -1;
+
+        //keep the records found, the frames without enough records leave holes
+        size_t end = collected + first;
+        for(size_t i = collected; i < end; i++){
+            if(samples[i].data){
+                samples[collected++] = samples[i];
+            }
+        }
+        memset(samples + collected, 0, (end - collected)*sizeof(ZSTDSeek_Sample));
+    }
+
+    qsort(samples, collected, sizeof(ZSTDSeek_Sample), ZSTDSeek_sampleCompare);
+    for(size_t i = 0; ret == 0 && i < collected; i++){
+        ret = fn(samples[i].pos, samples[i].data, samples[i].size, user);
+    }
+
+    for(size_t i = 0; samples && i < k; i++){
+        free(samples[i].data);
+    }
+    free(samples);
+    free(drawn);
+    free(weights);
+    free(frames);
+    return ret;
+}
@@ -0,0 +1,50 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_SAMPLE_
+#define _ZSTD_SEEK_SAMPLE_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Callbacks */
+
+/*
+ * Called with a sampled record, without the delimiter, and where it begins in the context.
+ * Return 0 to continue, anything else to stop.
+ */
+typedef int (*ZSTDSeek_SampleCallback)(size_t pos, const void *record, size_t size, void *user);
+
+/* Sample API */
+
+/*
+ * Call fn with k random records of sctx, in the order of the file.
+ * Records end with the delimiter, the one that crosses the beginning of a frame belongs to the previous frame.
+ * Each draw picks a frame with a probability proportional to its uncompressed size, from the jump table,
+ * then only the frames drawn are decompressed on nthreads threads (<= 0 means one per CPU) and a record is picked uniformly in each of them,
+ * so the cost is about k frames and not the whole file.
+ * The records are distinct. When a frame has less records than the times it was drawn, the missing ones are drawn again
+ * among the frames not yet decompressed, so there are less than k records only when k is close to the number of records.
+ * The records are uniform when they are spread evenly among the frames, as in most logs, otherwise the ones in frames
+ * with fewer records are more likely.
+ * The same seed gives the same records.
+ * Returns 0 on success, the value returned by fn if it stopped or -1 in case of failure.
+ */
+int ZSTDSeek_sampleRecords(ZSTDSeek_Context *sctx, uint8_t delimiter, size_t k, uint64_t seed, ZSTDSeek_SampleCallback fn, void *user, int nthreads);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
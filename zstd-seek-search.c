@@ -0,0 +1,483 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "zstd-seek-search.h"
+#include "zstd-seek-internal.h"
+
+#ifndef _WIN32
+#include <regex.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define SEARCH_READ_SIZE 1024 //the first read past the end of the frame to complete the last record, it doubles each time
+
+struct ZSTDSeek_Pattern_s{
+    uint8_t *needle; //NULL for regular expressions
+    size_t size;
+    char *regex;
+    int cflags;
+};
+
+typedef struct{
+    size_t pos;    //in the coordinates of the context
+    size_t offset; //where the record is in the arena of the result
+    size_t size;
+} ZSTDSeek_SearchMatch;
+
+typedef struct{
+    ZSTDSeek_SearchMatch *matches;
+    size_t n;
+    size_t capacity;
+    uint8_t *arena;
+    size_t arenaSize;
+    size_t arenaCapacity;
+} ZSTDSeek_SearchResult;
+
+typedef struct{
+    ZSTDSeek_Context *sctx;
+    size_t viewStart;  //the context is [viewStart, end) in the coordinates of the jump table
+    size_t end;
+    ZSTDSeek_FrameRange *ranges; //the frames that cover the context
+    size_t length;
+
+    const uint8_t *needle;
+    size_t needleSize;
+    ZSTDSeek_Pattern *pattern; //NULL for ZSTDSeek_searchParallel
+    uint8_t delimiter;
+    ZSTDSeek_MatchCallback fn;
+    void *user;
+} ZSTDSeek_SearchJob;
+
+typedef struct{
+    ZSTDSeek_SearchJob *job;
+    ZSTDSeek_Context *view; //the one of the thread
+
+    uint8_t *buff;
+    size_t buffSize;
+    size_t capacity;
+    int eof;
+#ifndef _WIN32
+    regex_t regex;
+    int hasRegex;
+#endif
+} ZSTDSeek_SearchWorker;
+
+const void* ZSTDSeek_memmem(const void *haystack, size_t size, const void *needle, size_t needleSize){
+    const uint8_t *h = (const uint8_t *)haystack;
+    const uint8_t *n = (const uint8_t *)needle;
+    if(needleSize == 0){
+        return haystack;
+    }
+    if(needleSize > size){
+        return NULL;
+    }
+    if(needleSize == 1){
+        return memchr(haystack, n[0], size);
+    }
+
+    size_t last = needleSize - 1;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i first = _mm256_set1_epi8((char)n[0]);
+    const __m256i lastByte = _mm256_set1_epi8((char)n[last]);
+    for(; i + last + 32 <= size; i += 32){
+        __m256i a = _mm256_loadu_si256((const __m256i *)(h + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(h + i + last));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, lastByte)));
+        while(mask){
+            size_t bit = (size_t)__builtin_ctz(mask);
+            if(memcmp(h + i + bit + 1, n + 1, needleSize - 2) == 0){
+                return h + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8((char)n[0]);
+    const __m128i lastByte = _mm_set1_epi8((char)n[last]);
+    for(; i + last + 16 <= size; i += 16){
+        __m128i a = _mm_loadu_si128((const __m128i *)(h + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(h + i + last));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, lastByte)));
+        while(mask){
+            size_t bit = (size_t)__builtin_ctz(mask);
+            if(memcmp(h + i + bit + 1, n + 1, needleSize - 2) == 0){
+                return h + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for(; i + needleSize <= size; i++){
+        if(h[i] == n[0] && h[i + last] == n[last] && memcmp(h + i + 1, n + 1, needleSize - 2) == 0){
+            return h + i;
+        }
+    }
+    return NULL;
+}
+
+ZSTDSeek_Pattern* ZSTDSeek_createSubstringPattern(const void *needle, size_t size){
+    if(!needle || size == 0){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+    ZSTDSeek_Pattern *pattern = calloc(1, sizeof(ZSTDSeek_Pattern));
+    if(!pattern || !(pattern->needle = malloc(size))){
+        free(pattern);
+        return NULL;
+    }
+    memcpy(pattern->needle, needle, size);
+    pattern->size = size;
+    return pattern;
+}
+
+ZSTDSeek_Pattern* ZSTDSeek_createRegexPattern(const char *regex, int ignoreCase){
+#ifdef _WIN32
+    (void)regex;
+    (void)ignoreCase;
+    DEBUG("Regular expressions are not supported\n");
+    return NULL;
+#else
+    if(!regex){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+    ZSTDSeek_Pattern *pattern = calloc(1, sizeof(ZSTDSeek_Pattern));
+    if(!pattern || !(pattern->regex = malloc(strlen(regex) + 1))){
+        free(pattern);
+        return NULL;
+    }
+    strcpy(pattern->regex, regex);
+    pattern->cflags = REG_EXTENDED | REG_NEWLINE | (ignoreCase ? REG_ICASE : 0);
+
+    regex_t r; //only to check it
+    if(regcomp(&r, regex, pattern->cflags) != 0){
+        DEBUG("Invalid regular expression '%s'\n", regex);
+        ZSTDSeek_freePattern(pattern);
+        return NULL;
+    }
+    regfree(&r);
+    return pattern;
+#endif
+}
+
+void ZSTDSeek_freePattern(ZSTDSeek_Pattern *pattern){
+    if(!pattern){
+        DEBUG("Invalid argument\n");
+        return;
+    }
+    free(pattern->needle);
+    free(pattern->regex);
+    free(pattern);
+}
+
+int ZSTDSeek_searchAddMatch(ZSTDSeek_SearchResult *result, size_t pos, const uint8_t *data, size_t size){
+    if(result->n == result->capacity){
+        size_t capacity = result->capacity ? 2*result->capacity : 64;
+        ZSTDSeek_SearchMatch *tmp = realloc(result->matches, capacity*sizeof(ZSTDSeek_SearchMatch));
+        if(!tmp){
+            return -1;
+        }
+        result->matches = tmp;
+        result->capacity = capacity;
+    }
+    if(data){
+        if(result->arenaSize + size > result->arenaCapacity){
+            size_t capacity = (result->arenaSize + size)*2;
+            uint8_t *tmp = realloc(result->arena, capacity);
+            if(!tmp){
+                return -1;
+            }
+            result->arena = tmp;
+            result->arenaCapacity = capacity;
+        }
+        memcpy(result->arena + result->arenaSize, data, size);
+    }
+    result->matches[result->n++] = (ZSTDSeek_SearchMatch){pos, result->arenaSize, size};
+    result->arenaSize += data ? size : 0;
+    return 0;
+}
+
+/*
+ * Read up to size more bytes of the view of the worker at the end of its buffer. Returns the number of bytes read, 0 at the end, -1 on failure.
+ */
+long ZSTDSeek_searchFill(ZSTDSeek_SearchWorker *worker, size_t size){
+    if(worker->buffSize + size > worker->capacity){
+        size_t capacity = (worker->buffSize + size)*2;
+        uint8_t *tmp = realloc(worker->buff, capacity);
+        if(!tmp){
+            return -1;
+        }
+        worker->buff = tmp;
+        worker->capacity = capacity;
+    }
+    size_t done = 0;
+    while(done < size){
+        size_t len = ZSTDSeek_read(worker->buff + worker->buffSize + done, size - done, worker->view);
+        if(len == (size_t)ZSTDSEEK_ERR_READ){
+            return -1;
+        }
+        if(len == 0){
+            worker->eof = 1;
+            break;
+        }
+        done += len;
+    }
+    worker->buffSize += done;
+    return (long)done;
+}
+
+int ZSTDSeek_searchFrame(ZSTDSeek_SearchWorker *worker, size_t frame, ZSTDSeek_SearchResult *result){
+    ZSTDSeek_SearchJob *job = worker->job;
+    size_t start = job->ranges[frame].start;
+    size_t size = job->ranges[frame].end - start;
+    size_t pos = start - job->viewStart;
+
+    //the view goes on to the end of the context, so the matches that cross the end of the frame can be completed
+    worker->buffSize = 0;
+    worker->eof = 0;
+    if(ZSTDSeek_moveView(worker->view, start, job->end - start) != 0 || ZSTDSeek_searchFill(worker, size) != (long)size){
+        return -1;
+    }
+
+    if(!job->pattern){
+        if(ZSTDSeek_searchFill(worker, job->needleSize - 1) < 0){
+            return -1;
+        }
+        for(size_t o = 0; o < size;){
+            const uint8_t *p = ZSTDSeek_memmem(worker->buff + o, worker->buffSize - o, job->needle, job->needleSize);
+            if(!p || (size_t)(p - worker->buff) >= size){
+                break;
+            }
+            o = p - worker->buff;
+            if(ZSTDSeek_searchAddMatch(result, pos + o, NULL, job->needleSize) != 0){
+                return -1;
+            }
+            o++;
+        }
+        return 0;
+    }
+
+    //the records that begin after a delimiter in this frame, the first one crosses the beginning of the frame
+    const uint8_t delimiter = job->delimiter;
+    size_t begin = 0;
+    if(pos > 0){
+        const uint8_t *d = memchr(worker->buff, delimiter, size);
+        if(!d){
+            return 0;
+        }
+        begin = d - worker->buff + 1;
+    }
+    //complete the last record
+    size_t end = size;
+    size_t readSize = SEARCH_READ_SIZE;
+    while(1){
+        const uint8_t *d = memchr(worker->buff + end, delimiter, worker->buffSize - end);
+        if(d){
+            end = d - worker->buff;
+            break;
+        }
+        end = worker->buffSize;
+        long len = worker->eof ? 0 : ZSTDSeek_searchFill(worker, readSize);
+        readSize *= 2;
+        if(len < 0){
+            return -1;
+        }
+        if(len == 0){
+            break;
+        }
+    }
+
+    const uint8_t *buff = worker->buff;
+    ZSTDSeek_Pattern *pattern = job->pattern;
+    for(size_t cur = begin; cur <= end;){
+        if(cur == end && end == worker->buffSize){ //the file ends with a delimiter, there is no record after it
+            break;
+        }
+        size_t ls, le; //the record with the next match, if any
+        if(pattern->needle){
+            const uint8_t *p = ZSTDSeek_memmem(buff + cur, end - cur, pattern->needle, pattern->size);
+            if(!p){
+                break;
+            }
+            ls = p - buff;
+            while(ls > cur && buff[ls-1] != delimiter){
+                ls--;
+            }
+            const uint8_t *d = memchr(p, delimiter, buff + end - p);
+            le = d ? (size_t)(d - buff) : end;
+            if(le < (size_t)(p - buff) + pattern->size){ //the needle contains the delimiter
+                break;
+            }
+        }else{
+#ifdef _WIN32
+            return -1;
+#else
+            regmatch_t m[1];
+            if(delimiter == '\n'){
+                //REG_NEWLINE keeps the matches within a line, so the whole buffer is searched at once
+                m[0].rm_so = (regoff_t)cur;
+                m[0].rm_eo = (regoff_t)end;
+                if(regexec(&worker->regex, (const char *)buff, 1, m, REG_STARTEND) != 0){
+                    break;
+                }
+                ls = (size_t)m[0].rm_so;
+                while(ls > cur && buff[ls-1] != delimiter){
+                    ls--;
+                }
+                const uint8_t *d = memchr(buff + m[0].rm_so, delimiter, end - m[0].rm_so);
+                le = d ? (size_t)(d - buff) : end;
+            }else{
+                ls = cur;
+                const uint8_t *d = memchr(buff + cur, delimiter, end - cur);
+                le = d ? (size_t)(d - buff) : end;
+                m[0].rm_so = 0; //the record is the whole string, so ^ matches at its beginning
+                m[0].rm_eo = (regoff_t)(le - ls);
+                if(regexec(&worker->regex, (const char *)buff + ls, 1, m, REG_STARTEND) != 0){
+                    cur = le + 1;
+                    continue;
+                }
+            }
+#endif
+        }
+
+        if(ZSTDSeek_searchAddMatch(result, pos + ls, buff + ls, le - ls) != 0){
+            return -1;
+        }
+        cur = le + 1;
+    }
+    return 0;
+}
+
+void ZSTDSeek_searchFreeResult(void *data){
+    ZSTDSeek_SearchResult *result = (ZSTDSeek_SearchResult *)data;
+    if(result){
+        free(result->matches);
+        free(result->arena);
+        free(result);
+    }
+}
+
+void ZSTDSeek_searchFreeWorker(void *local){
+    ZSTDSeek_SearchWorker *worker = (ZSTDSeek_SearchWorker *)local;
+    if(!worker){
+        return;
+    }
+    free(worker->buff);
+#ifndef _WIN32
+    if(worker->hasRegex){
+        regfree(&worker->regex);
+    }
+#endif
+    free(worker);
+}
+
+int ZSTDSeek_searchMap(size_t frame, ZSTDSeek_ParallelSlot *slot, void **result, void *user){
+    ZSTDSeek_SearchJob *job = (ZSTDSeek_SearchJob *)user;
+    ZSTDSeek_SearchWorker *worker = (ZSTDSeek_SearchWorker *)slot->local;
+    if(!worker){
+        //the first frame of the thread, every thread compiles its own copy of the regular expression
+        if(!(worker = slot->local = calloc(1, sizeof(ZSTDSeek_SearchWorker)))){
+            return -1;
+        }
+        worker->job = job;
+        worker->view = slot->view;
+#ifndef _WIN32
+        if(job->pattern && job->pattern->regex){
+            if(regcomp(&worker->regex, job->pattern->regex, job->pattern->cflags) != 0){
+                return -1;
+            }
+            worker->hasRegex = 1;
+        }
+#endif
+    }
+
+    ZSTDSeek_SearchResult *r = calloc(1, sizeof(ZSTDSeek_SearchResult));
+    if(!r){
+        return -1;
+    }
+    *result = r;
+    return ZSTDSeek_searchFrame(worker, frame, r);
+}
+
+int ZSTDSeek_searchReport(void *data, size_t frame, void *user){
+    ZSTDSeek_SearchJob *job = (ZSTDSeek_SearchJob *)user;
+    ZSTDSeek_SearchResult *result = (ZSTDSeek_SearchResult *)data;
+    (void)frame;
+
+    int ret = 0;
+    for(size_t i = 0; i < result->n && ret == 0; i++){
+        ZSTDSeek_SearchMatch *m = &result->matches[i];
+        ret = job->fn(m->pos, job->pattern ? result->arena + m->offset : job->needle, m->size, job->user);
+    }
+    ZSTDSeek_searchFreeResult(result);
+    return ret;
+}
+
+int ZSTDSeek_searchRun(ZSTDSeek_SearchJob *job, int nthreads){
+    ZSTDSeek_Context *sctx = job->sctx;
+    job->ranges = ZSTDSeek_frameRanges(sctx, &job->length);
+    if(!job->ranges){
+        return -1;
+    }
+    job->viewStart = ZSTDSeek_getViewStart(sctx);
+    job->end = job->viewStart + ZSTDSeek_uncompressedFileSize(sctx);
+    if(job->length == 0){
+        free(job->ranges);
+        return 0;
+    }
+
+    //the frames are searched in parallel and the matches reported in order
+    int ret = ZSTDSeek_mapReduceIndexParallel(sctx, job->length, ZSTDSeek_searchMap, ZSTDSeek_searchReport, ZSTDSeek_searchFreeResult, ZSTDSeek_searchFreeWorker, job, nthreads);
+    free(job->ranges);
+    return ret;
+}
+
+int ZSTDSeek_searchParallel(ZSTDSeek_Context *sctx, const void *needle, size_t size, ZSTDSeek_MatchCallback fn, void *user, int nthreads){
+    if(!sctx || !needle || size == 0 || !fn){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    ZSTDSeek_SearchJob job;
+    memset(&job, 0, sizeof(job));
+    job.sctx = sctx;
+    job.needle = (const uint8_t *)needle;
+    job.needleSize = size;
+    job.fn = fn;
+    job.user = user;
+    return ZSTDSeek_searchRun(&job, nthreads);
+}
+
+int ZSTDSeek_grepParallel(ZSTDSeek_Context *sctx, ZSTDSeek_Pattern *pattern, uint8_t delimiter, ZSTDSeek_MatchCallback fn, void *user, int nthreads){
+    if(!sctx || !pattern || !fn){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    ZSTDSeek_SearchJob job;
+    memset(&job, 0, sizeof(job));
+    job.sctx = sctx;
+    job.pattern = pattern;
+    job.delimiter = delimiter;
+    job.fn = fn;
+    job.user = user;
+    return ZSTDSeek_searchRun(&job, nthreads);
+}
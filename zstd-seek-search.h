@@ -0,0 +1,78 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_SEARCH_
+#define _ZSTD_SEEK_SEARCH_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Structs */
+
+typedef struct ZSTDSeek_Pattern_s ZSTDSeek_Pattern;
+
+/*
+ * Called by the search functions for each match, in the order of the file.
+ * pos is the position in the uncompressed file of the match, or of the record with the match.
+ * data is the match or the record, without the delimiter, valid only until the callback returns.
+ * The calls never overlap but they can come from different threads.
+ * Return 0 to continue, anything else to stop.
+ */
+typedef int (*ZSTDSeek_MatchCallback)(size_t pos, const void *data, size_t size, void *user);
+
+/* Search API */
+
+/*
+ * A pattern that matches the bytes of needle.
+ * Returns 0 in case of failure.
+ */
+ZSTDSeek_Pattern* ZSTDSeek_createSubstringPattern(const void *needle, size_t size);
+
+/*
+ * A POSIX extended regular expression, case insensitive if ignoreCase is not 0.
+ * Every thread compiles its own copy, so the matching is never serialized.
+ * Returns 0 in case of failure, eg if regex is not valid or regular expressions are not supported on this platform.
+ */
+ZSTDSeek_Pattern* ZSTDSeek_createRegexPattern(const char *regex, int ignoreCase);
+
+/*
+ * Free the pattern.
+ */
+void ZSTDSeek_freePattern(ZSTDSeek_Pattern *pattern);
+
+/*
+ * Like memmem, it compares the first and the last byte of needle at many positions at once with SIMD instructions when available.
+ */
+const void* ZSTDSeek_memmem(const void *haystack, size_t size, const void *needle, size_t needleSize);
+
+/*
+ * Call fn for every occurrence of needle in sctx, even the ones that overlap or cross the end of a frame.
+ * The frames are decompressed and searched on nthreads threads, <= 0 means one per CPU, while fn is called in order.
+ * Returns 0 on success, -1 on failure or the value returned by fn if it stopped the search.
+ */
+int ZSTDSeek_searchParallel(ZSTDSeek_Context *sctx, const void *needle, size_t size, ZSTDSeek_MatchCallback fn, void *user, int nthreads);
+
+/*
+ * Call fn for every record of sctx, ended by delimiter, that matches pattern, like grep.
+ * The frames are decompressed and searched on nthreads threads, <= 0 means one per CPU, while fn is called in order.
+ * The records that cross the end of a frame are searched by the thread of the frame where they begin.
+ * Returns 0 on success, -1 on failure or the value returned by fn if it stopped the search.
+ */
+int ZSTDSeek_grepParallel(ZSTDSeek_Context *sctx, ZSTDSeek_Pattern *pattern, uint8_t delimiter, ZSTDSeek_MatchCallback fn, void *user, int nthreads);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,175 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "zstd-seek-shard.h"
+#include "zstd-seek-internal.h"
+
+#define SHARD_READ_SIZE 1024 //the first read after a boundary, the following ones double up to SHARD_MAX_READ_SIZE
+#define SHARD_MAX_READ_SIZE (128*1024)
+
+/*
+ * Find the first delimiter at or after from, reading as little as possible.
+ * Returns 1 and its position, 0 if there is none, -1 on failure.
+ */
+int ZSTDSeek_shardNextDelimiter(ZSTDSeek_Context *sctx, uint8_t delimiter, uint8_t *buff, size_t from, size_t *pos){
+    if(ZSTDSeek_seek(sctx, (long)from, SEEK_SET) != 0){
+        return -1;
+    }
+
+    size_t readSize = SHARD_READ_SIZE;
+    while(1){
+        size_t len = ZSTDSeek_read(buff, readSize, sctx);
+        if(len == (size_t)ZSTDSEEK_ERR_READ){
+            return -1;
+        }
+        if(len == 0){
+            return 0;
+        }
+        uint8_t *d = memchr(buff, delimiter, len);
+        if(d){
+            *pos = from + (size_t)(d - buff);
+            return 1;
+        }
+        from += len;
+        if(readSize < SHARD_MAX_READ_SIZE){
+            readSize *= 2;
+        }
+    }
+}
+
+ZSTDSeek_Shard* ZSTDSeek_planShards(ZSTDSeek_Context *sctx, uint8_t delimiter, size_t n, size_t *length){
+    if(!sctx || !length || n == 0){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+
+    size_t frames = 0;
+    ZSTDSeek_FrameRange *ranges = ZSTDSeek_frameRanges(sctx, &frames);
+    size_t viewStart = ZSTDSeek_getViewStart(sctx);
+    size_t size = ZSTDSeek_uncompressedFileSize(sctx);
+    size_t *boundaries = malloc((n+1)*sizeof(size_t));
+    uint8_t *buff = malloc(SHARD_MAX_READ_SIZE);
+    ZSTDSeek_Shard *shards = NULL;
+    if(!ranges || !boundaries || !buff){
+        goto cleanup;
+    }
+
+    //for each ideal boundary take the nearest frame start, then move it after the next delimiter
+    size_t count = 0;
+    boundaries[count++] = 0;
+    size_t frame = 0;
+    for(size_t k = 1; k < n && frames > 0; k++){
+        size_t target = (size_t)((double)size*k/n);
+        while(frame + 1 < frames && ranges[frame + 1].start - viewStart <= target){
+            frame++;
+        }
+        size_t cut = ranges[frame].start - viewStart;
+        if(frame + 1 < frames && ranges[frame + 1].start - viewStart - target < target - cut){
+            cut = ranges[frame + 1].start - viewStart;
+        }
+        if(cut == 0 || cut < boundaries[count-1]){ //the record after the previous boundary goes beyond this frame start
+            continue;
+        }
+
+        size_t pos;
+        int found = ZSTDSeek_shardNextDelimiter(sctx, delimiter, buff, cut, &pos);
+        if(found < 0){
+            DEBUG("Can't read the frame at %zu\n", cut);
+            goto cleanup;
+        }
+        if(found == 0 || pos + 1 >= size){ //the last record takes the rest of the file
+            break;
+        }
+        if(pos + 1 > boundaries[count-1]){
+            boundaries[count++] = pos + 1;
+        }
+    }
+    boundaries[count] = size;
+
+    shards = malloc(count*sizeof(ZSTDSeek_Shard));
+    if(!shards){
+        goto cleanup;
+    }
+    *length = 0;
+    for(size_t i = 0; i < count; i++){
+        ZSTDSeek_Shard *shard = &shards[(*length)++];
+        memset(shard, 0, sizeof(ZSTDSeek_Shard));
+        shard->offset = boundaries[i];
+        shard->length = boundaries[i+1] - boundaries[i];
+        ZSTDSeek_CompressedExtent extent;
+        if(shard->length == 0){ //an empty context
+            continue;
+        }
+        if(ZSTDSeek_getCompressedExtent(sctx, shard->offset, shard->length, &extent) != 0){
+            DEBUG("Can't find the frames of the shard at %zu\n", boundaries[i]);
+            free(shards);
+            shards = NULL;
+            goto cleanup;
+        }
+        shard->firstFrame = extent.firstFrame;
+        shard->compressedPos = extent.compressedPos;
+        shard->compressedSize = extent.compressedSize;
+        shard->skip = extent.skip;
+    }
+
+cleanup:
+    free(ranges);
+    free(boundaries);
+    free(buff);
+    return shards;
+}
+
+void ZSTDSeek_encodeShard(const ZSTDSeek_Shard *shard, uint8_t *buff){
+    const uint64_t values[ZSTDSEEK_SHARD_ENCODED_SIZE/8] = {
+        ZSTDSEEK_SHARD_MAGICNUMBER,
+        ZSTDSEEK_SHARD_VERSION,
+        shard->offset,
+        shard->length,
+        shard->firstFrame,
+        shard->compressedPos,
+        shard->compressedSize,
+        shard->skip
+    };
+    for(size_t i = 0; i < ZSTDSEEK_SHARD_ENCODED_SIZE/8; i++){
+        ZSTDSeek_putLE(buff + 8*i, values[i], 8);
+    }
+}
+
+int ZSTDSeek_decodeShard(const uint8_t *buff, size_t size, ZSTDSeek_Shard *shard){
+    if(!buff || !shard || size < ZSTDSEEK_SHARD_ENCODED_SIZE){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    uint64_t values[ZSTDSEEK_SHARD_ENCODED_SIZE/8];
+    for(size_t i = 0; i < ZSTDSEEK_SHARD_ENCODED_SIZE/8; i++){
+        values[i] = ZSTDSeek_getLE(buff + 8*i, 8);
+    }
+    if(values[0] != ZSTDSEEK_SHARD_MAGICNUMBER || values[1] != ZSTDSEEK_SHARD_VERSION){
+        DEBUG("Not a shard descriptor\n");
+        return -1;
+    }
+
+    *shard = (ZSTDSeek_Shard){values[2], values[3], values[4], values[5], values[6], values[7]};
+    return 0;
+}
+
+ZSTDSeek_Context* ZSTDSeek_createShardView(ZSTDSeek_Context *sctx, const ZSTDSeek_Shard *shard){
+    if(!sctx || !shard){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+
+    return ZSTDSeek_createView(sctx, shard->offset, shard->length);
+}
@@ -0,0 +1,72 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_SHARD_
+#define _ZSTD_SEEK_SHARD_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Shard constants */
+#define ZSTDSEEK_SHARD_MAGICNUMBER 0x4453535A //"ZSSD"
+#define ZSTDSEEK_SHARD_VERSION 1
+#define ZSTDSEEK_SHARD_ENCODED_SIZE 64 //the size of an encoded shard descriptor
+
+/* Structs */
+
+typedef struct{
+    uint64_t offset;         //where the shard begins in the uncompressed data of the context
+    uint64_t length;         //the uncompressed length of the shard
+    uint64_t firstFrame;     //the frame with the first byte of the shard, as numbered in the jump table
+    uint64_t compressedPos;  //where firstFrame begins in the compressed file
+    uint64_t compressedSize; //the length of the frames covering the shard
+    uint64_t skip;           //how many uncompressed bytes of firstFrame come before the shard
+} ZSTDSeek_Shard;
+
+/* Shard API */
+
+/*
+ * Split the records of sctx in at most n shards of about the same uncompressed size, eg to process them on different machines.
+ * Records end with the delimiter, every one of them belongs to exactly one shard.
+ * The shards are planned on the frame boundaries of the jump table, then each boundary is moved after the first delimiter
+ * that follows it, decompressing only the beginning of the frame up until the delimiter.
+ * Records longer than a shard make some boundaries collapse, so there can be less than n shards.
+ * The position of sctx is changed.
+ * Returns an array to free with free and sets length to the number of shards, 0 in case of failure.
+ */
+ZSTDSeek_Shard* ZSTDSeek_planShards(ZSTDSeek_Context *sctx, uint8_t delimiter, size_t n, size_t *length);
+
+/*
+ * Encode shard in ZSTDSEEK_SHARD_ENCODED_SIZE bytes, independent of the platform, to send it to a worker.
+ */
+void ZSTDSeek_encodeShard(const ZSTDSeek_Shard *shard, uint8_t *buff);
+
+/*
+ * Decode a shard encoded with ZSTDSeek_encodeShard. Returns 0 on success.
+ */
+int ZSTDSeek_decodeShard(const uint8_t *buff, size_t size, ZSTDSeek_Shard *shard);
+
+/*
+ * Create a view of the shard on a context of the whole file, see ZSTDSeek_createView.
+ * A worker without the whole file can instead create a context with ZSTDSeek_create on the compressedSize bytes at compressedPos,
+ * seek to skip and read length bytes: the shard begins at a frame so no jump table of the whole file is needed.
+ * Returns 0 in case of failure.
+ */
+ZSTDSeek_Context* ZSTDSeek_createShardView(ZSTDSeek_Context *sctx, const ZSTDSeek_Shard *shard);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
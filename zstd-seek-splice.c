@@ -0,0 +1,362 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifdef __linux__
+#define _GNU_SOURCE //vmsplice, splice and F_SETPIPE_SZ
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "zstd-seek-splice.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <poll.h>
+#endif
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+
+#define SPLICE_BUFFERS (ZSTDSEEK_SPLICE_DEPTH + 1)
+
+#define SPLICE_TO_PIPE 0      //vmsplice to fd
+#define SPLICE_THROUGH_PIPE 1 //vmsplice to a pipe, then splice to fd
+#define SPLICE_WRITE 2        //write to fd
+
+typedef struct{
+    uint8_t *data; //NULL until the decoder allocates it, and again after its pages are given to the kernel
+    size_t size;
+} ZSTDSeek_SpliceBuffer;
+
+typedef struct{
+    ZSTDSeek_Context *view; //used only by the decoder
+    size_t length;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    ZSTDSeek_SpliceBuffer buffs[SPLICE_BUFFERS];
+    size_t decoded;     //the buffers decoded so far, the i-th is in buffs[i % SPLICE_BUFFERS]
+    size_t transferred; //the buffers transferred so far
+    int failed;         //the decoder failed
+    int stop;           //the transfer failed
+} ZSTDSeek_SpliceJob;
+
+typedef struct{
+    int fd;
+    int mode;
+    int pipe[2]; //for SPLICE_THROUGH_PIPE
+    size_t written;
+} ZSTDSeek_SpliceOutput;
+
+uint8_t* ZSTDSeek_spliceAlloc(){
+#ifdef __linux__
+    //the pages are given to the kernel, so every buffer is mapped on its own
+    void *data = mmap(NULL, ZSTDSEEK_SPLICE_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return data == MAP_FAILED ? NULL : (uint8_t *)data;
+#else
+    return malloc(ZSTDSEEK_SPLICE_CHUNK_SIZE);
+#endif
+}
+
+void ZSTDSeek_spliceFree(uint8_t *data){
+    if(!data){
+        return;
+    }
+#ifdef __linux__
+    munmap(data, ZSTDSEEK_SPLICE_CHUNK_SIZE);
+#else
+    free(data);
+#endif
+}
+
+void* ZSTDSeek_spliceDecoder(void *arg){
+    ZSTDSeek_SpliceJob *job = (ZSTDSeek_SpliceJob *)arg;
+    size_t done = 0;
+
+    pthread_mutex_lock(&job->mutex);
+    while(done < job->length){
+        while(job->decoded - job->transferred == SPLICE_BUFFERS && !job->stop){
+            pthread_cond_wait(&job->cond, &job->mutex);
+        }
+        if(job->stop){
+            break;
+        }
+        ZSTDSeek_SpliceBuffer *buff = &job->buffs[job->decoded % SPLICE_BUFFERS];
+        pthread_mutex_unlock(&job->mutex);
+
+        size_t size = job->length - done < ZSTDSEEK_SPLICE_CHUNK_SIZE ? job->length - done : ZSTDSEEK_SPLICE_CHUNK_SIZE;
+        size_t len = 0;
+        if(!buff->data){
+            buff->data = ZSTDSeek_spliceAlloc();
+        }
+        while(buff->data && len < size){
+            size_t ret = ZSTDSeek_read(buff->data + len, size - len, job->view);
+            if(ret == 0 || ret == (size_t)ZSTDSEEK_ERR_READ){
+                break;
+            }
+            len += ret;
+        }
+
+        pthread_mutex_lock(&job->mutex);
+        if(len < size){
+            DEBUG("Can't decompress the range\n");
+            job->failed = 1;
+            pthread_cond_broadcast(&job->cond);
+            break;
+        }
+        buff->size = size;
+        done += size;
+        job->decoded++;
+        pthread_cond_broadcast(&job->cond);
+    }
+    pthread_mutex_unlock(&job->mutex);
+    return NULL;
+}
+
+/*
+ * Wait for a non-blocking fd to be writable. Returns 0 when it is.
+ */
+int ZSTDSeek_spliceWait(int fd){
+#ifndef _WIN32
+    struct pollfd pfd = {fd, POLLOUT, 0};
+    while(poll(&pfd, 1, -1) < 0){
+        if(errno != EINTR){
+            return -1;
+        }
+    }
+    return 0;
+#else
+    (void)fd;
+    return -1;
+#endif
+}
+
+/*
+ * Write size bytes to fd. Returns the bytes written, less than size in case of failure.
+ */
+size_t ZSTDSeek_spliceWrite(int fd, const uint8_t *data, size_t size){
+    size_t done = 0;
+    while(done < size){
+        ssize_t ret = write(fd, data + done, size - done);
+        if(ret < 0){
+            if(errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) && ZSTDSeek_spliceWait(fd) == 0)){
+                continue;
+            }
+            break;
+        }
+        done += (size_t)ret;
+    }
+    return done;
+}
+
+#ifdef __linux__
+/*
+ * Move size bytes from the pipe to fd. If fd doesn't support splice they are read back and written.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_spliceFromPipe(ZSTDSeek_SpliceOutput *out, size_t size){
+    while(size > 0){
+        ssize_t ret = splice(out->pipe[0], NULL, out->fd, NULL, size, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if(ret < 0){
+            if(errno == EINTR || (errno == EAGAIN && ZSTDSeek_spliceWait(out->fd) == 0)){
+                continue;
+            }
+            if(errno != EINVAL){
+                return -1;
+            }
+            //fd doesn't support splice, from now on write is used
+            DEBUG("splice is not supported, falling back to write\n");
+            out->mode = SPLICE_WRITE;
+            uint8_t tmp[64*1024];
+            while(size > 0){
+                ssize_t len = read(out->pipe[0], tmp, size < sizeof(tmp) ? size : sizeof(tmp));
+                if(len <= 0){
+                    if(len < 0 && errno == EINTR){
+                        continue;
+                    }
+                    return -1;
+                }
+                size_t written = ZSTDSeek_spliceWrite(out->fd, tmp, (size_t)len);
+                out->written += written;
+                if(written < (size_t)len){
+                    return -1;
+                }
+                size -= (size_t)len;
+            }
+            return 0;
+        }
+        size -= (size_t)ret;
+        out->written += (size_t)ret;
+    }
+    return 0;
+}
+#endif
+
+/*
+ * Transfer the data of buff to fd. Returns 0 on success.
+ */
+int ZSTDSeek_spliceTransfer(ZSTDSeek_SpliceOutput *out, ZSTDSeek_SpliceBuffer *buff){
+    const uint8_t *data = buff->data;
+    size_t size = buff->size;
+
+#ifdef __linux__
+    if(out->mode != SPLICE_WRITE){
+        struct iovec iov = {buff->data, buff->size};
+        int dst = out->mode == SPLICE_TO_PIPE ? out->fd : out->pipe[1];
+        int ret = 0;
+        while(iov.iov_len > 0 && out->mode != SPLICE_WRITE){
+            ssize_t len = vmsplice(dst, &iov, 1, SPLICE_F_GIFT);
+            if(len < 0){
+                if(errno == EINTR || (errno == EAGAIN && ZSTDSeek_spliceWait(dst) == 0)){
+                    continue;
+                }
+                if(errno != EINVAL && errno != ENOSYS){
+                    ret = -1;
+                    break;
+                }
+                DEBUG("vmsplice is not supported, falling back to write\n");
+                out->mode = SPLICE_WRITE;
+                break;
+            }
+            iov.iov_base = (uint8_t *)iov.iov_base + len;
+            iov.iov_len -= (size_t)len;
+            if(out->mode == SPLICE_TO_PIPE){
+                out->written += (size_t)len;
+            }else if(ZSTDSeek_spliceFromPipe(out, (size_t)len) != 0){
+                ret = -1;
+                break;
+            }
+        }
+        data = (const uint8_t *)iov.iov_base;
+        size = iov.iov_len;
+        if(ret == 0 && size > 0){ //the rest is written
+            size_t written = ZSTDSeek_spliceWrite(out->fd, data, size);
+            out->written += written;
+            ret = written == size ? 0 : -1;
+        }
+
+        //the pages may still be referenced by the pipe, they can't be written again
+        int err = errno;
+        ZSTDSeek_spliceFree(buff->data);
+        buff->data = NULL;
+        errno = err;
+        return ret;
+    }
+#endif
+
+    size_t written = ZSTDSeek_spliceWrite(out->fd, data, size);
+    out->written += written;
+    return written == size ? 0 : -1;
+}
+
+int ZSTDSeek_spliceRange(ZSTDSeek_Context *sctx, size_t offset, size_t length, int fd, size_t *written){
+    if(written){
+        *written = 0;
+    }
+    if(!sctx || fd < 0){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    if(length == 0){
+        return 0;
+    }
+
+    ZSTDSeek_CompressedExtent extent; //check the range and initialize the jump table up until its end
+    int ret = ZSTDSeek_getCompressedExtent(sctx, offset, length, &extent);
+    if(ret != 0){
+        return ret;
+    }
+
+    ZSTDSeek_SpliceJob job;
+    memset(&job, 0, sizeof(job));
+    job.length = length;
+    job.view = ZSTDSeek_createView(sctx, offset, length);
+    if(!job.view){
+        return -1;
+    }
+
+    ZSTDSeek_SpliceOutput out = {fd, SPLICE_WRITE, {-1, -1}, 0};
+#ifdef __linux__
+    struct stat st;
+    if(fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode)){
+        out.mode = SPLICE_TO_PIPE;
+    }else if(pipe2(out.pipe, O_CLOEXEC) == 0){
+        out.mode = SPLICE_THROUGH_PIPE;
+        fcntl(out.pipe[1], F_SETPIPE_SZ, ZSTDSEEK_SPLICE_CHUNK_SIZE); //fewer calls, it's fine if it fails
+    }
+#endif
+
+    pthread_mutex_init(&job.mutex, NULL);
+    pthread_cond_init(&job.cond, NULL);
+    pthread_t thread;
+    int err = 0;
+    ret = -1;
+    if(pthread_create(&thread, NULL, ZSTDSeek_spliceDecoder, &job) == 0){
+        //transfer the buffers in order while the next ones are decoded
+        size_t chunks = (length + ZSTDSEEK_SPLICE_CHUNK_SIZE - 1) / ZSTDSEEK_SPLICE_CHUNK_SIZE;
+        pthread_mutex_lock(&job.mutex);
+        while(job.transferred < chunks){
+            while(job.transferred == job.decoded && !job.failed){
+                pthread_cond_wait(&job.cond, &job.mutex);
+            }
+            if(job.transferred == job.decoded){
+                break;
+            }
+            ZSTDSeek_SpliceBuffer *buff = &job.buffs[job.transferred % SPLICE_BUFFERS];
+            pthread_mutex_unlock(&job.mutex);
+
+            int failed = ZSTDSeek_spliceTransfer(&out, buff) != 0;
+            err = errno;
+
+            pthread_mutex_lock(&job.mutex);
+            if(failed){
+                DEBUG("Can't write to the file descriptor\n");
+                job.stop = 1;
+                pthread_cond_broadcast(&job.cond);
+                break;
+            }
+            job.transferred++;
+            pthread_cond_broadcast(&job.cond);
+        }
+        ret = job.transferred == chunks ? 0 : -1;
+        pthread_mutex_unlock(&job.mutex);
+        pthread_join(thread, NULL);
+    }
+
+    for(int i = 0; i < SPLICE_BUFFERS; i++){
+        ZSTDSeek_spliceFree(job.buffs[i].data);
+    }
+#ifdef __linux__
+    if(out.pipe[0] >= 0){
+        close(out.pipe[0]);
+        close(out.pipe[1]);
+    }
+#endif
+    pthread_cond_destroy(&job.cond);
+    pthread_mutex_destroy(&job.mutex);
+    ZSTDSeek_free(job.view);
+
+    if(written){
+        *written = out.written;
+    }
+    if(ret != 0 && job.stop){
+        errno = err;
+    }
+    return ret;
+}
@@ -0,0 +1,43 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_SPLICE_
+#define _ZSTD_SEEK_SPLICE_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Splice constants */
+#define ZSTDSEEK_SPLICE_CHUNK_SIZE (1024*1024) //the uncompressed bytes decoded in a buffer and transferred at once
+#define ZSTDSEEK_SPLICE_DEPTH 3 //the buffers decoded ahead of the one being transferred
+
+/* Splice API */
+
+/*
+ * Write length bytes of the uncompressed data of sctx from offset to the file descriptor fd, eg a socket or a pipe.
+ * A thread decodes the data in page aligned buffers while the calling thread transfers the ones already decoded.
+ * On Linux the buffers are given to the kernel with vmsplice, directly if fd is a pipe, through a pipe and splice otherwise,
+ * so the data is never copied again in user space. Elsewhere, or if fd doesn't support splice, write is used instead.
+ * fd can be non-blocking, the call waits for it to be writable. The position of sctx doesn't change.
+ * written, if not NULL, is set to the bytes written to fd, also in case of failure.
+ * Returns 0 on success, ZSTDSEEK_ERR_BEYOND_END_SEEK if the range goes beyond the end of the data,
+ * -1 in case of failure, with errno set if fd couldn't be written.
+ */
+int ZSTDSeek_spliceRange(ZSTDSeek_Context *sctx, size_t offset, size_t length, int fd, size_t *written);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
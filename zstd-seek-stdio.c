@@ -0,0 +1,110 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#define _GNU_SOURCE //fopencookie
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include "zstd-seek-stdio.h"
+
+#if defined(__GLIBC__)
+
+typedef struct{
+    ZSTDSeek_Context *sctx;
+    char *buff; //the buffer of the stream, freed on close
+} ZSTDSeek_StdioCookie;
+
+ssize_t ZSTDSeek_stdioRead(void *cookie, char *buff, size_t size){
+    ZSTDSeek_StdioCookie *c = (ZSTDSeek_StdioCookie *)cookie;
+    size_t len = ZSTDSeek_read(buff, size, c->sctx);
+    if(len == (size_t)ZSTDSEEK_ERR_READ){
+        errno = EIO;
+        return -1;
+    }
+    return (ssize_t)len;
+}
+
+int ZSTDSeek_stdioSeek(void *cookie, off64_t *offset, int whence){
+    ZSTDSeek_StdioCookie *c = (ZSTDSeek_StdioCookie *)cookie;
+    if(ZSTDSeek_seek(c->sctx, (long)*offset, whence) != 0){
+        errno = EINVAL;
+        return -1;
+    }
+    *offset = ZSTDSeek_tell(c->sctx);
+    return 0;
+}
+
+int ZSTDSeek_stdioClose(void *cookie){
+    ZSTDSeek_StdioCookie *c = (ZSTDSeek_StdioCookie *)cookie;
+    free(c->buff);
+    free(c);
+    return 0;
+}
+
+/*
+ * The uncompressed size of the biggest frame in the jump table, clamped to the limits of the stream buffer.
+ */
+size_t ZSTDSeek_stdioBuffSize(ZSTDSeek_Context *sctx){
+    ZSTDSeek_CompressedExtent extent;
+    ZSTDSeek_getCompressedExtent(sctx, (size_t)ZSTDSeek_tell(sctx), 1, &extent); //the frame of the current position is parsed, at least
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+    size_t size = ZSTDSEEK_STDIO_MIN_BUFFSIZE;
+    for(size_t i = 0; i + 1 < jt->length; i++){
+        size_t frameSize = jt->records[i+1].uncompressedPos - jt->records[i].uncompressedPos;
+        if(frameSize > size){
+            size = frameSize;
+        }
+    }
+    return size < ZSTDSEEK_STDIO_MAX_BUFFSIZE ? size : ZSTDSEEK_STDIO_MAX_BUFFSIZE;
+}
+
+FILE* ZSTDSeek_fopen(ZSTDSeek_Context *sctx){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t size = ZSTDSeek_stdioBuffSize(sctx);
+    ZSTDSeek_StdioCookie *cookie = malloc(sizeof(ZSTDSeek_StdioCookie));
+    char *buff = malloc(size);
+    if(!cookie || !buff){
+        free(cookie);
+        free(buff);
+        errno = ENOMEM;
+        return NULL;
+    }
+    cookie->sctx = sctx;
+    cookie->buff = buff;
+
+    cookie_io_functions_t functions = {ZSTDSeek_stdioRead, NULL, ZSTDSeek_stdioSeek, ZSTDSeek_stdioClose};
+    FILE *f = fopencookie(cookie, "r", functions);
+    if(!f){
+        free(cookie);
+        free(buff);
+        return NULL;
+    }
+    setvbuf(f, buff, _IOFBF, size);
+    return f;
+}
+
+#else
+
+FILE* ZSTDSeek_fopen(ZSTDSeek_Context *sctx){
+    (void)sctx;
+    DEBUG("fopencookie is not available\n");
+    errno = ENOSYS;
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,42 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_STDIO_
+#define _ZSTD_SEEK_STDIO_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Stdio constants */
+#define ZSTDSEEK_STDIO_MIN_BUFFSIZE (64*1024)
+#define ZSTDSEEK_STDIO_MAX_BUFFSIZE (8*1024*1024)
+
+/* Stdio API */
+
+/*
+ * Open the uncompressed data of sctx as a read only, seekable FILE, eg for code that reads files with fread, fgets or fseek.
+ * Nothing is written to disk, the data is decompressed as the stream is read starting from the current position of sctx.
+ * The stream buffer is as big as the biggest frame in the jump table so far, between ZSTDSEEK_STDIO_MIN_BUFFSIZE
+ * and ZSTDSEEK_STDIO_MAX_BUFFSIZE, so a frame is usually decompressed with a single read.
+ * Don't use sctx while the FILE is open, and close the FILE with fclose before freeing sctx.
+ * It requires fopencookie of glibc.
+ * Returns 0 in case of failure, with errno set to ENOSYS if fopencookie is not available.
+ */
+FILE* ZSTDSeek_fopen(ZSTDSeek_Context *sctx);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,581 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "zstd-seek-tar.h"
+#include "zstd-seek-internal.h"
+
+#define TAR_NAME_OFFSET 0
+#define TAR_NAME_SIZE 100
+#define TAR_MODE_OFFSET 100
+#define TAR_MODE_SIZE 8
+#define TAR_SIZE_OFFSET 124
+#define TAR_SIZE_SIZE 12
+#define TAR_CHKSUM_OFFSET 148
+#define TAR_CHKSUM_SIZE 8
+#define TAR_TYPEFLAG_OFFSET 156
+#define TAR_MAGIC_OFFSET 257
+#define TAR_PREFIX_OFFSET 345
+#define TAR_PREFIX_SIZE 155
+
+typedef struct {
+    ZSTDSeek_TarMember *members;
+    size_t length;
+    size_t capacity;
+} ZSTDSeek_TarMemberList;
+
+struct ZSTDSeek_TarIndex_s{
+    ZSTDSeek_TarMemberList list;
+    size_t *slots; //open addressing hash table of member indexes by path, SIZE_MAX when empty
+    size_t mask;
+    size_t compressedSize; //the size of the archive the index was built for
+    uint64_t fileHash;     //and its fingerprint
+};
+
+typedef struct {
+    ZSTDSeek_TarMemberList *frames; //the headers found in each frame, indexed by frame
+    int failed;
+} ZSTDSeek_TarScan;
+
+int ZSTDSeek_tarAppend(ZSTDSeek_TarMemberList *list, ZSTDSeek_TarMember m){
+    if(list->length == list->capacity){
+        size_t capacity = list->capacity ? list->capacity*2 : 16;
+        ZSTDSeek_TarMember *members = realloc(list->members, capacity*sizeof(ZSTDSeek_TarMember));
+        if(!members){
+            return -1;
+        }
+        list->members = members;
+        list->capacity = capacity;
+    }
+    list->members[list->length++] = m;
+    return 0;
+}
+
+void ZSTDSeek_tarFreeList(ZSTDSeek_TarMemberList *list){
+    for(size_t i = 0; i < list->length; i++){
+        free(list->members[i].path);
+    }
+    free(list->members);
+    list->members = NULL;
+    list->length = list->capacity = 0;
+}
+
+uint64_t ZSTDSeek_tarNumber(const uint8_t *field, size_t size, int *ok){
+    uint64_t value = 0;
+    if(field[0] & 0x80){ //GNU base-256 encoding for big numbers
+        for(size_t i = 1; i < size; i++){
+            value = (value << 8) | field[i];
+        }
+        *ok = 1;
+        return value;
+    }
+
+    size_t i = 0;
+    while(i < size && field[i] == ' '){
+        i++;
+    }
+    *ok = i < size && field[i] >= '0' && field[i] <= '7';
+    for(; i < size && field[i] >= '0' && field[i] <= '7'; i++){
+        value = (value << 3) | (uint64_t)(field[i] - '0');
+    }
+    for(; i < size; i++){ //only terminators are allowed after the digits
+        if(field[i] != ' ' && field[i] != 0){
+            *ok = 0;
+        }
+    }
+    return value;
+}
+
+/*
+ * Returns 1 if block is a valid tar header and fills m, 0 if it's a zero block, -1 otherwise.
+ */
+int ZSTDSeek_parseTarHeader(const uint8_t *block, size_t offset, ZSTDSeek_TarMember *m){
+    int ok;
+    uint64_t stored = ZSTDSeek_tarNumber(block + TAR_CHKSUM_OFFSET, TAR_CHKSUM_SIZE, &ok);
+    if(!ok){
+        for(size_t i = 0; i < ZSTDSEEK_TAR_BLOCK_SIZE; i++){
+            if(block[i]){
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    //the checksum is computed with the checksum field filled with spaces, some old implementations used signed bytes
+    uint64_t sum = 0;
+    int64_t signedSum = 0;
+    for(size_t i = 0; i < ZSTDSEEK_TAR_BLOCK_SIZE; i++){
+        uint8_t b = (i >= TAR_CHKSUM_OFFSET && i < TAR_CHKSUM_OFFSET + TAR_CHKSUM_SIZE) ? ' ' : block[i];
+        sum += b;
+        signedSum += (int8_t)b;
+    }
+    if(stored != sum && (int64_t)stored != signedSum){
+        return -1;
+    }
+
+    uint64_t size = ZSTDSeek_tarNumber(block + TAR_SIZE_OFFSET, TAR_SIZE_SIZE, &ok);
+    if(!ok){
+        return -1;
+    }
+    uint64_t mode = ZSTDSeek_tarNumber(block + TAR_MODE_OFFSET, TAR_MODE_SIZE, &ok);
+
+    size_t nameLength = strnlen((const char *)block + TAR_NAME_OFFSET, TAR_NAME_SIZE);
+    size_t prefixLength = 0;
+    if(memcmp(block + TAR_MAGIC_OFFSET, "ustar\0", 6) == 0){ //the prefix is only in POSIX ustar headers
+        prefixLength = strnlen((const char *)block + TAR_PREFIX_OFFSET, TAR_PREFIX_SIZE);
+    }
+
+    char *path = malloc(prefixLength + nameLength + 2);
+    if(!path){
+        return -1;
+    }
+    size_t pos = 0;
+    if(prefixLength){
+        memcpy(path, block + TAR_PREFIX_OFFSET, prefixLength);
+        path[prefixLength] = '/';
+        pos = prefixLength + 1;
+    }
+    memcpy(path + pos, block + TAR_NAME_OFFSET, nameLength);
+    path[pos + nameLength] = 0;
+
+    *m = (ZSTDSeek_TarMember){
+        path,
+        offset + ZSTDSEEK_TAR_BLOCK_SIZE,
+        (size_t)size,
+        (uint32_t)mode,
+        block[TAR_TYPEFLAG_OFFSET] ? (char)block[TAR_TYPEFLAG_OFFSET] : '0'
+    };
+    return 1;
+}
+
+int ZSTDSeek_tarScanFrame(const void *data, size_t size, size_t uncompressedPos, size_t frame, void *user){
+    ZSTDSeek_TarScan *scan = (ZSTDSeek_TarScan *)user;
+    ZSTDSeek_TarMemberList *list = &scan->frames[frame];
+
+    //headers are aligned to the tar blocks, the ones split between two frames are left to the chaining
+    size_t first = (uncompressedPos + ZSTDSEEK_TAR_BLOCK_SIZE - 1) / ZSTDSEEK_TAR_BLOCK_SIZE * ZSTDSEEK_TAR_BLOCK_SIZE;
+    for(size_t pos = first; pos + ZSTDSEEK_TAR_BLOCK_SIZE <= uncompressedPos + size; pos += ZSTDSEEK_TAR_BLOCK_SIZE){
+        ZSTDSeek_TarMember m;
+        if(ZSTDSeek_parseTarHeader((const uint8_t *)data + (pos - uncompressedPos), pos, &m) == 1){
+            if(ZSTDSeek_tarAppend(list, m) != 0){
+                free(m.path);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+char* ZSTDSeek_tarReadString(ZSTDSeek_Context *reader, size_t offset, size_t size){
+    char *s = malloc(size + 1);
+    if(!s){
+        return NULL;
+    }
+    if(ZSTDSeek_seek(reader, (long)offset, SEEK_SET) != 0 || ZSTDSeek_read(s, size, reader) != size){
+        free(s);
+        return NULL;
+    }
+    s[size] = 0;
+    return s;
+}
+
+//parse the records of a pax extended header, "<length> <key>=<value>\n", looking for path and size
+void ZSTDSeek_tarParsePax(const char *pax, size_t size, char **path, int64_t *paxSize){
+    size_t pos = 0;
+    while(pos < size){
+        char *end;
+        unsigned long long length = strtoull(pax + pos, &end, 10);
+        if(length == 0 || pos + length > size || *end != ' '){
+            return;
+        }
+        const char *key = end + 1;
+        const char *record = pax + pos;
+        const char *eq = memchr(key, '=', record + length - key);
+        if(eq){
+            size_t valueLength = record + length - (eq + 1) - 1; //without the newline
+            if(eq - key == 4 && memcmp(key, "path", 4) == 0){
+                free(*path);
+                *path = malloc(valueLength + 1);
+                if(*path){
+                    memcpy(*path, eq + 1, valueLength);
+                    (*path)[valueLength] = 0;
+                }
+            }else if(eq - key == 4 && memcmp(key, "size", 4) == 0){
+                *paxSize = (int64_t)strtoll(eq + 1, NULL, 10);
+            }
+        }
+        pos += length;
+    }
+}
+
+size_t ZSTDSeek_tarHash(const char *path){
+    return (size_t)ZSTDSeek_fnv1a(ZSTDSEEK_FNV_OFFSET_BASIS, path, strlen(path));
+}
+
+int ZSTDSeek_tarBuildHashTable(ZSTDSeek_TarIndex *index){
+    size_t capacity = 16;
+    while(capacity < index->list.length*2){
+        capacity <<= 1;
+    }
+    index->slots = malloc(capacity*sizeof(size_t));
+    if(!index->slots){
+        return -1;
+    }
+    memset(index->slots, 0xff, capacity*sizeof(size_t));
+    index->mask = capacity - 1;
+
+    for(size_t i = 0; i < index->list.length; i++){
+        size_t slot = ZSTDSeek_tarHash(index->list.members[i].path) & index->mask;
+        while(index->slots[slot] != SIZE_MAX && strcmp(index->list.members[index->slots[slot]].path, index->list.members[i].path) != 0){
+            slot = (slot + 1) & index->mask;
+        }
+        index->slots[slot] = i; //a later member with the same path replaces the previous one
+    }
+    return 0;
+}
+
+ZSTDSeek_TarIndex* ZSTDSeek_newTarIndex(ZSTDSeek_Context *sctx){
+    ZSTDSeek_TarIndex *index = calloc(1, sizeof(ZSTDSeek_TarIndex));
+    if(index){
+        ZSTDSeek_getCompressedBuffer(sctx, &index->compressedSize);
+        index->fileHash = ZSTDSeek_fileHash(sctx);
+    }
+    return index;
+}
+
+ZSTDSeek_TarIndex* ZSTDSeek_buildTarIndex(ZSTDSeek_Context *sctx, int nthreads){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return NULL;
+    }
+
+    if(ZSTDSeek_initializeJumpTable(sctx) != 0){
+        DEBUG("Can't initialize the jump table\n");
+        return NULL;
+    }
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+
+    ZSTDSeek_TarScan scan;
+    scan.frames = calloc(jt->length, sizeof(ZSTDSeek_TarMemberList));
+    scan.failed = 0;
+    if(!scan.frames){
+        return NULL;
+    }
+
+    ZSTDSeek_TarIndex *index = NULL;
+    ZSTDSeek_Context *reader = NULL;
+
+    //find all the blocks that look like a tar header, in parallel
+    if(ZSTDSeek_forEachFrameParallel(sctx, ZSTDSeek_tarScanFrame, &scan, nthreads) != 0){
+        DEBUG("Can't scan the frames\n");
+        goto cleanup;
+    }
+
+    size_t dataSize = ZSTDSeek_uncompressedFileSize(sctx);
+    index = ZSTDSeek_newTarIndex(sctx);
+    reader = ZSTDSeek_createView(sctx, 0, dataSize); //for the headers split between frames
+    if(!index || !reader){
+        goto fail;
+    }
+
+    //then follow the chain of headers from the beginning, as tar does, picking the ones found by the scan
+    size_t frame = 0;
+    size_t candidate = 0;
+    size_t pos = 0;
+    char *longName = NULL;
+    char *paxPath = NULL;
+    int64_t paxSize = -1;
+    int failed = 0;
+    uint8_t block[ZSTDSEEK_TAR_BLOCK_SIZE];
+    while(1){
+        //skip the candidates before pos, they are sorted as the frames are
+        while(frame < jt->length){
+            if(candidate >= scan.frames[frame].length){
+                frame++;
+                candidate = 0;
+            }else if(scan.frames[frame].members[candidate].offset < pos + ZSTDSEEK_TAR_BLOCK_SIZE){
+                candidate++;
+            }else{
+                break;
+            }
+        }
+
+        ZSTDSeek_TarMember m;
+        if(frame < jt->length && scan.frames[frame].members[candidate].offset == pos + ZSTDSEEK_TAR_BLOCK_SIZE){
+            m = scan.frames[frame].members[candidate];
+            scan.frames[frame].members[candidate].path = NULL; //the index owns it now
+        }else{
+            if(ZSTDSeek_seek(reader, (long)pos, SEEK_SET) != 0 || ZSTDSeek_read(block, ZSTDSEEK_TAR_BLOCK_SIZE, reader) != ZSTDSEEK_TAR_BLOCK_SIZE){
+                DEBUG("Unexpected end of archive at %zu\n", pos);
+                failed = 1;
+                break;
+            }
+            int ret = ZSTDSeek_parseTarHeader(block, pos, &m);
+            if(ret == 0){ //end of archive
+                break;
+            }else if(ret < 0){
+                DEBUG("Invalid tar header at %zu\n", pos);
+                failed = 1;
+                break;
+            }
+        }
+        if(m.size > dataSize || m.offset > dataSize - m.size){
+            DEBUG("The data of the member at %zu is beyond the end of the archive\n", pos);
+            free(m.path);
+            failed = 1;
+            break;
+        }
+
+        if(m.type == 'x' || m.type == 'L'){ //the name, or more, of the next member is in the content of this one
+            char *content = ZSTDSeek_tarReadString(reader, m.offset, m.size);
+            if(content && m.type == 'L'){
+                free(longName);
+                longName = content;
+                content = NULL;
+            }else if(content){
+                ZSTDSeek_tarParsePax(content, m.size, &paxPath, &paxSize);
+            }
+            free(content);
+        }
+
+        pos = m.offset + (m.size + ZSTDSEEK_TAR_BLOCK_SIZE - 1) / ZSTDSEEK_TAR_BLOCK_SIZE * ZSTDSEEK_TAR_BLOCK_SIZE;
+
+        if(m.type == 'x' || m.type == 'L' || m.type == 'K' || m.type == 'g'){
+            free(m.path);
+            continue;
+        }
+
+        if(paxPath || longName){
+            free(m.path);
+            m.path = paxPath ? paxPath : longName;
+            if(paxPath){
+                free(longName);
+            }
+            paxPath = longName = NULL;
+        }
+        if(paxSize >= 0){
+            m.size = (size_t)paxSize;
+            pos = m.offset + (m.size + ZSTDSEEK_TAR_BLOCK_SIZE - 1) / ZSTDSEEK_TAR_BLOCK_SIZE * ZSTDSEEK_TAR_BLOCK_SIZE;
+            paxSize = -1;
+            if(m.size > dataSize || m.offset > dataSize - m.size){
+                DEBUG("The data of the member at %zu is beyond the end of the archive\n", m.offset);
+                free(m.path);
+                failed = 1;
+                break;
+            }
+        }
+
+        if(ZSTDSeek_tarAppend(&index->list, m) != 0){
+            free(m.path);
+            failed = 1;
+            break;
+        }
+    }
+    free(longName);
+    free(paxPath);
+    if(failed){
+        goto fail;
+    }
+
+    if(ZSTDSeek_tarBuildHashTable(index) != 0){
+        goto fail;
+    }
+    goto cleanup;
+
+fail:
+    ZSTDSeek_freeTarIndex(index);
+    index = NULL;
+
+cleanup:
+    if(reader){
+        ZSTDSeek_free(reader);
+    }
+    for(size_t i = 0; i < jt->length; i++){
+        ZSTDSeek_tarFreeList(&scan.frames[i]);
+    }
+    free(scan.frames);
+    return index;
+}
+
+int ZSTDSeek_saveTarIndex(ZSTDSeek_TarIndex *index, const char *file){
+    if(!index || !file){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    FILE *f = fopen(file, "wb");
+    if(!f){
+        DEBUG("Unable to open '%s'\n", file);
+        return -1;
+    }
+
+    int ret = ZSTDSeek_writeLE(f, ZSTDSEEK_TAR_INDEX_MAGICNUMBER, 4) |
+              ZSTDSeek_writeLE(f, ZSTDSEEK_TAR_INDEX_VERSION, 4) |
+              ZSTDSeek_writeLE(f, index->compressedSize, 8) |
+              ZSTDSeek_writeLE(f, index->fileHash, 8) |
+              ZSTDSeek_writeLE(f, index->list.length, 8);
+    for(size_t i = 0; i < index->list.length && ret == 0; i++){
+        ZSTDSeek_TarMember *m = &index->list.members[i];
+        size_t pathLength = strlen(m->path);
+        ret = ZSTDSeek_writeLE(f, m->offset, 8) |
+              ZSTDSeek_writeLE(f, m->size, 8) |
+              ZSTDSeek_writeLE(f, m->mode, 4) |
+              ZSTDSeek_writeLE(f, (uint8_t)m->type, 1) |
+              ZSTDSeek_writeLE(f, pathLength, 4);
+        if(ret == 0 && fwrite(m->path, 1, pathLength, f) != pathLength){
+            ret = -1;
+        }
+    }
+
+    if(fclose(f) != 0){
+        ret = -1;
+    }
+    return ret;
+}
+
+ZSTDSeek_TarIndex* ZSTDSeek_loadTarIndex(ZSTDSeek_Context *sctx, const char *file){
+    if(!sctx || !file){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+
+    FILE *f = fopen(file, "rb");
+    if(!f){
+        DEBUG("Unable to open '%s'\n", file);
+        return NULL;
+    }
+
+    ZSTDSeek_TarIndex *index = ZSTDSeek_newTarIndex(sctx);
+    uint64_t magic, version, compressedSize, fileHash, length;
+    if(!index || ZSTDSeek_readLE(f, &magic, 4) || ZSTDSeek_readLE(f, &version, 4) || ZSTDSeek_readLE(f, &compressedSize, 8) ||
+       ZSTDSeek_readLE(f, &fileHash, 8) || ZSTDSeek_readLE(f, &length, 8) ||
+       magic != ZSTDSEEK_TAR_INDEX_MAGICNUMBER || version != ZSTDSEEK_TAR_INDEX_VERSION || compressedSize != index->compressedSize ||
+       fileHash != index->fileHash){
+        DEBUG("'%s' is not an index of this archive\n", file);
+        goto fail;
+    }
+
+    for(uint64_t i = 0; i < length; i++){
+        uint64_t offset, size, mode, type, pathLength;
+        if(ZSTDSeek_readLE(f, &offset, 8) || ZSTDSeek_readLE(f, &size, 8) || ZSTDSeek_readLE(f, &mode, 4) ||
+           ZSTDSeek_readLE(f, &type, 1) || ZSTDSeek_readLE(f, &pathLength, 4)){
+            goto fail;
+        }
+        char *path = malloc(pathLength + 1);
+        if(!path || fread(path, 1, pathLength, f) != pathLength){
+            free(path);
+            goto fail;
+        }
+        path[pathLength] = 0;
+        if(ZSTDSeek_tarAppend(&index->list, (ZSTDSeek_TarMember){path, offset, size, (uint32_t)mode, (char)type}) != 0){
+            free(path);
+            goto fail;
+        }
+    }
+
+    if(ZSTDSeek_tarBuildHashTable(index) != 0){
+        goto fail;
+    }
+
+    fclose(f);
+    return index;
+
+fail:
+    fclose(f);
+    ZSTDSeek_freeTarIndex(index);
+    return NULL;
+}
+
+size_t ZSTDSeek_tarIndexLength(ZSTDSeek_TarIndex *index){
+    return index ? index->list.length : 0;
+}
+
+const ZSTDSeek_TarMember* ZSTDSeek_getTarMember(ZSTDSeek_TarIndex *index, size_t i){
+    if(!index || i >= index->list.length){
+        return NULL;
+    }
+    return &index->list.members[i];
+}
+
+const ZSTDSeek_TarMember* ZSTDSeek_findTarMember(ZSTDSeek_TarIndex *index, const char *path){
+    if(!index || !path || !index->slots){
+        return NULL;
+    }
+    size_t slot = ZSTDSeek_tarHash(path) & index->mask;
+    while(index->slots[slot] != SIZE_MAX){
+        ZSTDSeek_TarMember *m = &index->list.members[index->slots[slot]];
+        if(strcmp(m->path, path) == 0){
+            return m;
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    return NULL;
+}
+
+typedef struct {
+    ZSTDSeek_Context *sctx;
+    const ZSTDSeek_TarMember **members; //sorted by offset
+    ZSTDSeek_TarMemberCallback fn;
+    void *user;
+} ZSTDSeek_TarJob;
+
+int ZSTDSeek_compareTarMembers(const void *a, const void *b){
+    size_t x = (*(const ZSTDSeek_TarMember **)a)->offset;
+    size_t y = (*(const ZSTDSeek_TarMember **)b)->offset;
+    return x < y ? -1 : x > y;
+}
+
+int ZSTDSeek_tarMember(size_t index, ZSTDSeek_ParallelSlot *slot, void *user){
+    ZSTDSeek_TarJob *job = (ZSTDSeek_TarJob *)user;
+    const ZSTDSeek_TarMember *m = job->members[index];
+    if(ZSTDSeek_moveView(slot->view, ZSTDSeek_getViewStart(job->sctx) + m->offset, m->size) != 0){
+        return -1;
+    }
+    return job->fn(m, slot->view, job->user);
+}
+
+int ZSTDSeek_forEachTarMemberParallel(ZSTDSeek_Context *sctx, const ZSTDSeek_TarMember **members, size_t n, ZSTDSeek_TarMemberCallback fn, void *user, int nthreads){
+    if(!sctx || (!members && n) || !fn){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    if(n == 0){
+        return 0;
+    }
+
+    ZSTDSeek_TarJob job;
+    job.sctx = sctx;
+    job.fn = fn;
+    job.user = user;
+    job.members = malloc(n*sizeof(ZSTDSeek_TarMember *));
+    if(!job.members){
+        return -1;
+    }
+    memcpy(job.members, members, n*sizeof(ZSTDSeek_TarMember *));
+    //every thread takes a range of consecutive members, so the ones in the same frame reuse the state of its decoder
+    qsort(job.members, n, sizeof(ZSTDSeek_TarMember *), ZSTDSeek_compareTarMembers);
+
+    int ret = ZSTDSeek_forEachIndexParallel(sctx, n, ZSTDSeek_tarMember, NULL, &job, nthreads);
+    free(job.members);
+    return ret;
+}
+
+void ZSTDSeek_freeTarIndex(ZSTDSeek_TarIndex *index){
+    if(!index){
+        DEBUG("Invalid argument\n");
+        return;
+    }
+    ZSTDSeek_tarFreeList(&index->list);
+    free(index->slots);
+    free(index);
+}
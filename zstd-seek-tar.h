@@ -0,0 +1,98 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_TAR_
+#define _ZSTD_SEEK_TAR_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Tar constants */
+#define ZSTDSEEK_TAR_BLOCK_SIZE 512
+#define ZSTDSEEK_TAR_INDEX_MAGICNUMBER 0x4954535A //"ZSTI"
+#define ZSTDSEEK_TAR_INDEX_VERSION 2
+
+/* Structs */
+
+typedef struct{
+    char *path;    //the full path, including the ustar prefix, GNU long names and pax paths
+    size_t offset; //where the content of the member begins in the uncompressed stream
+    size_t size;   //the size of the content
+    uint32_t mode;
+    char type;     //the tar typeflag, eg '0' for a regular file, '5' for a directory
+} ZSTDSeek_TarMember;
+
+typedef struct ZSTDSeek_TarIndex_s ZSTDSeek_TarIndex;
+
+/*
+ * Called by ZSTDSeek_forEachTarMemberParallel for each member.
+ * view is a view of the content of the member, see ZSTDSeek_createView. It's valid only until the callback returns.
+ * Return 0 to continue, anything else to stop.
+ */
+typedef int (*ZSTDSeek_TarMemberCallback)(const ZSTDSeek_TarMember *member, ZSTDSeek_Context *view, void *user);
+
+/* Tar Index API */
+
+/*
+ * Build the index of the members of a .tar.zst.
+ * The frames are decompressed once, on nthreads threads (<= 0 means one per CPU), looking for tar headers,
+ * then the headers are chained from the beginning of the archive. Headers split across two frames are read with seek and read.
+ * Returns 0 in case of failure, also if the archive is truncated or has an invalid header.
+ */
+ZSTDSeek_TarIndex* ZSTDSeek_buildTarIndex(ZSTDSeek_Context *sctx, int nthreads);
+
+/*
+ * Save the index to file. Returns 0 on success.
+ */
+int ZSTDSeek_saveTarIndex(ZSTDSeek_TarIndex *index, const char *file);
+
+/*
+ * Load an index saved with ZSTDSeek_saveTarIndex for the archive of sctx.
+ * Returns 0 in case of failure or if the index was built for a different archive.
+ */
+ZSTDSeek_TarIndex* ZSTDSeek_loadTarIndex(ZSTDSeek_Context *sctx, const char *file);
+
+/*
+ * Returns the number of members in the index.
+ */
+size_t ZSTDSeek_tarIndexLength(ZSTDSeek_TarIndex *index);
+
+/*
+ * Returns the i-th member, in archive order, 0 if i is out of range.
+ */
+const ZSTDSeek_TarMember* ZSTDSeek_getTarMember(ZSTDSeek_TarIndex *index, size_t i);
+
+/*
+ * Returns the member with the given path in constant time, 0 if not found.
+ * If the path is in the archive more than once the last one is returned, like tar does.
+ */
+const ZSTDSeek_TarMember* ZSTDSeek_findTarMember(ZSTDSeek_TarIndex *index, const char *path);
+
+/*
+ * Call fn with a view of each of the n members, on nthreads threads (<= 0 means one per CPU).
+ * Each thread has its own decoder and visits its members in archive order.
+ * Returns 0 on success, the value returned by fn if it stopped the processing or -1 in case of failure.
+ */
+int ZSTDSeek_forEachTarMemberParallel(ZSTDSeek_Context *sctx, const ZSTDSeek_TarMember **members, size_t n, ZSTDSeek_TarMemberCallback fn, void *user, int nthreads);
+
+/*
+ * Free the index.
+ */
+void ZSTDSeek_freeTarIndex(ZSTDSeek_TarIndex *index);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
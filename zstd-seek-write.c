@@ -0,0 +1,343 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "zstd-seek-write.h"
+#include "zstd-seek-internal.h"
+
+#define ZSTD_FRAME_HEADER_DESCRIPTOR_OFFSET 4
+#define ZSTD_FRAME_CHECKSUM_SIZE 4
+
+typedef struct {
+    uint32_t compressedSize;
+    uint32_t uncompressedSize;
+    uint8_t checksum[ZSTD_FRAME_CHECKSUM_SIZE]; //the last 4 bytes of the frame, already in little endian
+    int hasChecksum;
+} ZSTDSeek_WriterFrame;
+
+struct ZSTDSeek_Writer_s{
+    FILE *out;
+    ZSTD_CCtx *cctx;
+
+    void *cBuff; //where frames are compressed before being written
+    size_t cBuffSize;
+
+    ZSTDSeek_WriterFrame *frames;
+    size_t length;
+    size_t capacity;
+};
+
+int ZSTDSeek_writerAddRecord(ZSTDSeek_Writer *w, const uint8_t *frame, size_t compressedSize, size_t uncompressedSize){
+    if(compressedSize > UINT32_MAX || uncompressedSize > UINT32_MAX){
+        DEBUG("Frame too big for the seek table\n");
+        return -1;
+    }
+
+    if(w->length == w->capacity){
+        size_t capacity = w->capacity ? w->capacity*2 : 64;
+        ZSTDSeek_WriterFrame *frames = realloc(w->frames, capacity*sizeof(ZSTDSeek_WriterFrame));
+        if(!frames){
+            DEBUG("Can't grow the frame list\n");
+            return -1;
+        }
+        w->frames = frames;
+        w->capacity = capacity;
+    }
+
+    ZSTDSeek_WriterFrame *f = &w->frames[w->length++];
+    f->compressedSize = (uint32_t)compressedSize;
+    f->uncompressedSize = (uint32_t)uncompressedSize;
+    //the content checksum flag is the bit 2 of the frame header descriptor, if set the frame ends with the checksum
+    f->hasChecksum = compressedSize > ZSTD_FRAME_HEADER_DESCRIPTOR_OFFSET + ZSTD_FRAME_CHECKSUM_SIZE &&
+                     ZSTD_findFrameCompressedSize(frame, compressedSize) == compressedSize && //not followed by other frames
+                     (frame[ZSTD_FRAME_HEADER_DESCRIPTOR_OFFSET] >> 2) & 1;
+    if(f->hasChecksum){
+        memcpy(f->checksum, frame + compressedSize - ZSTD_FRAME_CHECKSUM_SIZE, ZSTD_FRAME_CHECKSUM_SIZE);
+    }
+    return 0;
+}
+
+ZSTDSeek_Writer* ZSTDSeek_createWriter(FILE *out, int compressionLevel){
+    if(!out){
+        DEBUG("Invalid argument\n");
+        return NULL;
+    }
+
+    ZSTDSeek_Writer *w = calloc(1, sizeof(ZSTDSeek_Writer));
+    if(!w){
+        return NULL;
+    }
+
+    w->out = out;
+    w->cctx = ZSTD_createCCtx();
+    if(!w->cctx){
+        free(w);
+        return NULL;
+    }
+    ZSTD_CCtx_setParameter(w->cctx, ZSTD_c_compressionLevel, compressionLevel);
+    ZSTD_CCtx_setParameter(w->cctx, ZSTD_c_checksumFlag, 1); //the frame checksum is reused in the seek table
+
+    return w;
+}
+
+int ZSTDSeek_writerAddFrame(ZSTDSeek_Writer *w, const void *src, size_t srcSize){
+    if(!w || (!src && srcSize)){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    size_t bound = ZSTD_compressBound(srcSize);
+    if(bound > w->cBuffSize){
+        void *cBuff = realloc(w->cBuff, bound);
+        if(!cBuff){
+            DEBUG("Can't allocate the compression buffer\n");
+            return -1;
+        }
+        w->cBuff = cBuff;
+        w->cBuffSize = bound;
+    }
+
+    size_t compressedSize = ZSTD_compress2(w->cctx, w->cBuff, w->cBuffSize, src, srcSize);
+    if(ZSTD_isError(compressedSize)){
+        DEBUG("Error compressing: %s\n", ZSTD_getErrorName(compressedSize));
+        return -1;
+    }
+
+    return ZSTDSeek_writerAddCompressedFrame(w, w->cBuff, compressedSize, srcSize);
+}
+
+int ZSTDSeek_writerAddCompressedFrame(ZSTDSeek_Writer *w, const void *frame, size_t compressedSize, size_t uncompressedSize){
+    if(!w || !frame){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    if(ZSTDSeek_writerAddRecord(w, (const uint8_t *)frame, compressedSize, uncompressedSize) != 0){
+        return -1;
+    }
+
+    if(fwrite(frame, 1, compressedSize, w->out) != compressedSize){
+        DEBUG("Write error\n");
+        w->length--;
+        return -1;
+    }
+
+    return 0;
+}
+
+int ZSTDSeek_writerRecompress(ZSTDSeek_Writer *w, ZSTDSeek_Context *sctx, size_t offset, size_t length){
+    //offset is in the coordinates of the jump table, a view seeks relative to its start
+    offset -= ZSTDSeek_getViewStart(sctx);
+
+    if(length == 0){
+        return 0;
+    }
+
+    void *buff = malloc(length);
+    if(!buff){
+        DEBUG("Can't allocate %zu bytes\n", length);
+        return -1;
+    }
+
+    int ret = -1;
+    if(ZSTDSeek_seek(sctx, (long)offset, SEEK_SET) == 0 && ZSTDSeek_read(buff, length, sctx) == length){
+        ret = ZSTDSeek_writerAddFrame(w, buff, length);
+    }else{
+        DEBUG("Can't read %zu bytes at %zu\n", length, offset);
+    }
+
+    free(buff);
+    return ret;
+}
+
+int ZSTDSeek_writerCopyFrame(ZSTDSeek_Writer *w, ZSTDSeek_Context *sctx, size_t frame){
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+    ZSTDSeek_JumpTableRecord r = jt->records[frame];
+    ZSTDSeek_JumpTableRecord next = jt->records[frame+1];
+    const uint8_t *buff = (const uint8_t *)ZSTDSeek_getCompressedBuffer(sctx, NULL) + r.compressedPos;
+    size_t spanSize = next.compressedPos - r.compressedPos;
+    size_t uncompressedSize = next.uncompressedPos - r.uncompressedPos;
+
+    //a jump table record can span more than one frame, eg skippable frames or empty frames, copy only the data frame
+    size_t frameSize = 0;
+    size_t dataFrames = 0;
+    size_t pos = 0;
+    while(pos < spanSize){
+        size_t size = ZSTD_findFrameCompressedSize(buff + pos, spanSize - pos);
+        if(ZSTD_isError(size) || size == 0){
+            DEBUG("Invalid frame at %zu\n", r.compressedPos + pos);
+            return -1;
+        }
+        uint32_t magic = (uint32_t)ZSTDSeek_getLE(buff + pos, 4);
+        if((magic & ZSTD_MAGIC_SKIPPABLE_MASK) != ZSTD_MAGIC_SKIPPABLE_START){
+            if(dataFrames++ == 0 && pos == 0){
+                frameSize = size;
+            }
+        }
+        pos += size;
+    }
+
+    if(dataFrames != 1 || frameSize == 0){
+        return ZSTDSeek_writerRecompress(w, sctx, r.uncompressedPos, uncompressedSize);
+    }
+    return ZSTDSeek_writerAddCompressedFrame(w, buff, frameSize, uncompressedSize);
+}
+
+int ZSTDSeek_writerAddRange(ZSTDSeek_Writer *w, ZSTDSeek_Context *sctx, size_t offset, size_t length){
+    if(!w || !sctx){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    if(length == 0){
+        return 0;
+    }
+
+    ZSTDSeek_CompressedExtent extent;
+    if(ZSTDSeek_getCompressedExtent(sctx, offset, length, &extent) != 0){
+        return -1;
+    }
+
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+    offset += ZSTDSeek_getViewStart(sctx);
+    size_t firstCopy = extent.firstFrame;
+    size_t lastCopy = extent.lastFrame + 1; //exclusive
+
+    if(extent.skip > 0){ //the first frame is partially covered
+        size_t firstFrameEnd = jt->records[extent.firstFrame+1].uncompressedPos;
+        size_t end = offset + length < firstFrameEnd ? offset + length : firstFrameEnd;
+        if(ZSTDSeek_writerRecompress(w, sctx, offset, end - offset) != 0){
+            return -1;
+        }
+        firstCopy++;
+    }
+    int trimLast = extent.trim > 0 && lastCopy > firstCopy; //the last frame is partially covered
+    if(trimLast){
+        lastCopy--;
+    }
+
+    for(size_t i = firstCopy; i < lastCopy; i++){
+        if(ZSTDSeek_writerCopyFrame(w, sctx, i) != 0){
+            return -1;
+        }
+    }
+
+    if(trimLast){
+        size_t start = jt->records[extent.lastFrame].uncompressedPos;
+        if(ZSTDSeek_writerRecompress(w, sctx, start, offset + length - start) != 0){
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int ZSTDSeek_writerAddFrames(ZSTDSeek_Writer *w, ZSTDSeek_Context *sctx, size_t firstFrame, size_t numberOfFrames){
+    if(!w || !sctx){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    if(ZSTDSeek_initializeJumpTable(sctx) != 0){
+        return -1;
+    }
+
+    ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+    if(firstFrame > jt->length - 1 || numberOfFrames > jt->length - 1 - firstFrame){
+        DEBUG("Frames %zu-%zu are beyond the end of the file\n", firstFrame, firstFrame + numberOfFrames);
+        return -1;
+    }
+
+    for(size_t i = firstFrame; i < firstFrame + numberOfFrames; i++){
+        if(ZSTDSeek_writerCopyFrame(w, sctx, i) != 0){
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+size_t ZSTDSeek_writerNumberOfFrames(ZSTDSeek_Writer *w){
+    if(!w){
+        DEBUG("Invalid argument\n");
+        return 0;
+    }
+    return w->length;
+}
+
+int ZSTDSeek_writerClose(ZSTDSeek_Writer *w){
+    if(!w){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    int checksumFlag = 1;
+    for(size_t i = 0; i < w->length; i++){
+        checksumFlag &= w->frames[i].hasChecksum;
+    }
+
+    int ret = 0;
+    size_t const sizePerEntry = 8 + (checksumFlag ? 4 : 0);
+    size_t const frameSize = sizePerEntry * w->length + ZSTD_SEEK_TABLE_FOOTER_SIZE;
+    if(w->length > UINT32_MAX || frameSize > UINT32_MAX){
+        DEBUG("Too many frames for the seek table\n");
+        ret = -1;
+    }else{
+        uint8_t entry[12];
+
+        ZSTDSeek_putLE(entry, ZSTD_MAGIC_SKIPPABLE_START|0xE, 4);
+        ZSTDSeek_putLE(entry + 4, (uint32_t)frameSize, 4);
+        if(fwrite(entry, 1, ZSTD_SKIPPABLE_HEADER_SIZE, w->out) != ZSTD_SKIPPABLE_HEADER_SIZE){
+            ret = -1;
+        }
+
+        for(size_t i = 0; i < w->length && ret == 0; i++){
+            ZSTDSeek_putLE(entry, w->frames[i].compressedSize, 4);
+            ZSTDSeek_putLE(entry + 4, w->frames[i].uncompressedSize, 4);
+            memcpy(entry + 8, w->frames[i].checksum, ZSTD_FRAME_CHECKSUM_SIZE);
+            if(fwrite(entry, 1, sizePerEntry, w->out) != sizePerEntry){
+                ret = -1;
+            }
+        }
+
+        ZSTDSeek_putLE(entry, (uint32_t)w->length, 4);
+        entry[4] = checksumFlag ? 0x80 : 0;
+        ZSTDSeek_putLE(entry + 5, ZSTD_SEEKABLE_MAGICNUMBER, 4);
+        if(ret == 0 && fwrite(entry, 1, ZSTD_SEEK_TABLE_FOOTER_SIZE, w->out) != ZSTD_SEEK_TABLE_FOOTER_SIZE){
+            ret = -1;
+        }
+        if(ret != 0){
+            DEBUG("Write error\n");
+        }
+    }
+
+    ZSTD_freeCCtx(w->cctx);
+    free(w->cBuff);
+    free(w->frames);
+    free(w);
+
+    return ret;
+}
+
+/* Extract API */
+
+int ZSTDSeek_extractRange(ZSTDSeek_Context *sctx, size_t offset, size_t length, FILE *out, int compressionLevel){
+    ZSTDSeek_Writer *w = ZSTDSeek_createWriter(out, compressionLevel);
+    if(!w){
+        return -1;
+    }
+    int ret = ZSTDSeek_writerAddRange(w, sctx, offset, length);
+    if(ZSTDSeek_writerClose(w) != 0){
+        ret = -1;
+    }
+    return ret;
+}
@@ -0,0 +1,87 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_WRITE_
+#define _ZSTD_SEEK_WRITE_
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+#include "zstd-seek.h"
+
+/* Structs */
+
+typedef struct ZSTDSeek_Writer_s ZSTDSeek_Writer;
+
+/* Writer API */
+
+/*
+ * Create a ZSTDSeek_Writer that writes a multiframe zstd file in the seekable format to out.
+ * compressionLevel is used for the frames compressed by ZSTDSeek_writerAddFrame.
+ * Returns 0 in case of failure.
+ */
+ZSTDSeek_Writer* ZSTDSeek_createWriter(FILE *out, int compressionLevel);
+
+/*
+ * Compress src as a new frame and append it to the file.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_writerAddFrame(ZSTDSeek_Writer *w, const void *src, size_t srcSize);
+
+/*
+ * Append an already compressed frame as it is, without decompressing it.
+ * frame must point to exactly one zstd frame of compressedSize bytes that decompresses to uncompressedSize bytes.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_writerAddCompressedFrame(ZSTDSeek_Writer *w, const void *frame, size_t compressedSize, size_t uncompressedSize);
+
+/*
+ * Append length bytes of the uncompressed data of sctx starting at offset.
+ * The frames fully covered by the range are copied as they are, only the frames at the edges are decompressed and compressed again.
+ * The range must be readable from sctx, eg not before the frame it was resumed from.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_writerAddRange(ZSTDSeek_Writer *w, ZSTDSeek_Context *sctx, size_t offset, size_t length);
+
+/*
+ * Append numberOfFrames frames of sctx starting at firstFrame, as numbered in its jump table.
+ * The frames are copied as they are, without decompressing them.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_writerAddFrames(ZSTDSeek_Writer *w, ZSTDSeek_Context *sctx, size_t firstFrame, size_t numberOfFrames);
+
+/*
+ * Returns the number of frames written so far.
+ */
+size_t ZSTDSeek_writerNumberOfFrames(ZSTDSeek_Writer *w);
+
+/*
+ * Append the seek table and free the writer. The FILE is not closed.
+ * The seek table includes the checksums only if every frame carries a content checksum.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_writerClose(ZSTDSeek_Writer *w);
+
+/* Extract API */
+
+/*
+ * Write length bytes of the uncompressed data of sctx starting at offset to out, as a new file in the seekable format.
+ * See ZSTDSeek_writerAddRange.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_extractRange(ZSTDSeek_Context *sctx, size_t offset, size_t length, FILE *out, int compressionLevel);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif
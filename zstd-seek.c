@@ -15,7 +15,41 @@
 #include <stdbool.h>
 #include <sys/stat.h>
 #include <string.h>
+#include <time.h>
 #include "zstd-seek.h"
+#include "zstd-seek-internal.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#define ZSTDSeek_pthread_t pthread_t
+#define ZSTDSeek_pthread_mutex_t pthread_mutex_t
+#define ZSTDSeek_pthread_cond_t pthread_cond_t
+#define ZSTDSeek_pthread_create pthread_create
+#define ZSTDSeek_pthread_join pthread_join
+#define ZSTDSeek_pthread_mutex_init pthread_mutex_init
+#define ZSTDSeek_pthread_mutex_destroy pthread_mutex_destroy
+#define ZSTDSeek_pthread_mutex_lock pthread_mutex_lock
+#define ZSTDSeek_pthread_mutex_unlock pthread_mutex_unlock
+#define ZSTDSeek_pthread_cond_init pthread_cond_init
+#define ZSTDSeek_pthread_cond_destroy pthread_cond_destroy
+#define ZSTDSeek_pthread_cond_wait pthread_cond_wait
+#define ZSTDSeek_pthread_cond_broadcast pthread_cond_broadcast
+#else
+//without POSIX threads the parallel engine runs on the calling thread only, the locks do nothing and the frame cache can't be enabled
+typedef int ZSTDSeek_pthread_t;
+typedef int ZSTDSeek_pthread_mutex_t;
+typedef int ZSTDSeek_pthread_cond_t;
+#define ZSTDSeek_pthread_create(thread, attr, fn, arg) (-1)
+#define ZSTDSeek_pthread_join(thread, ret) ((void)0)
+#define ZSTDSeek_pthread_mutex_init(mutex, attr) ((void)(mutex))
+#define ZSTDSeek_pthread_mutex_destroy(mutex) ((void)(mutex))
+#define ZSTDSeek_pthread_mutex_lock(mutex) ((void)(mutex))
+#define ZSTDSeek_pthread_mutex_unlock(mutex) ((void)(mutex))
+#define ZSTDSeek_pthread_cond_init(cond, attr) ((void)(cond))
+#define ZSTDSeek_pthread_cond_destroy(cond) ((void)(cond))
+#define ZSTDSeek_pthread_cond_wait(cond, mutex) ((void)(cond))
+#define ZSTDSeek_pthread_cond_broadcast(cond) ((void)(cond))
+#endif
 
 #ifdef _WIN32
 #include "windows-mmap.h"
@@ -24,6 +58,47 @@
 #include <sys/mman.h>
 #endif
 
+#define ZSTDSEEK_INVALID_OFFSET SIZE_MAX //the compressed offset of the jump coordinate of a position before the jump table
+
+#define CACHE_QUEUED 0  //waiting for a thread of the cache
+#define CACHE_LOADING 1 //being decompressed
+#define CACHE_READY 2
+
+typedef struct ZSTDSeek_CacheEntry_s{
+    size_t frame;          //as numbered in the jump table
+    size_t uncompressedPos;
+    size_t size;           //uncompressed
+    size_t compressedPos;
+    size_t compressedSize;
+    uint8_t *data;
+    int state;
+    int failed;
+    int pins;              //the threads using data, the entry can't be evicted
+    struct ZSTDSeek_CacheEntry_s *prev; //in the queue if queued, in the LRU list if ready and not pinned
+    struct ZSTDSeek_CacheEntry_s *next;
+} ZSTDSeek_CacheEntry;
+
+typedef struct{
+    ZSTDSeek_CacheEntry *head;
+    ZSTDSeek_CacheEntry *tail;
+} ZSTDSeek_CacheList;
+
+typedef struct{
+    ZSTDSeek_pthread_mutex_t mutex;
+    ZSTDSeek_pthread_cond_t queued; //wakes up the threads of the cache
+    ZSTDSeek_pthread_cond_t loaded; //wakes up the reads waiting for a frame
+    ZSTDSeek_CacheEntry **entries; //indexed by frame
+    size_t capacity;       //the length of entries
+    ZSTDSeek_CacheList queue; //the frames to decompress, in the order they were queued
+    ZSTDSeek_CacheList lru;   //the frames that can be evicted, the least recently used first
+    size_t used;           //the size of all the entries, queued ones included
+    size_t budget;
+    int stop;
+    const uint8_t *buff;
+    ZSTDSeek_pthread_t *threads;
+    int nthreads;
+} ZSTDSeek_FrameCache;
+
 typedef struct {
     size_t compressedOffset; //how may bytes to skip from the beginning of the compressed stream (skip to target frame)
     size_t uncompressedOffset; //how many bytes skip from the beginning of the uncompressed frame (move inside target frame)
@@ -43,6 +118,7 @@ struct ZSTDSeek_Context_s{
 
     ZSTDSeek_JumpTable* jt;
     int jumpTableFullyInitialized;
+    size_t jumpTableFirstFrame; //the frame of the first record of jt in the whole file, not 0 if the context was resumed from a token
 
     ZSTDSeek_JumpCoordinate jc;
 
@@ -56,6 +132,26 @@ struct ZSTDSeek_Context_s{
     uint8_t* inBuff; //it's a pointer to something inside buff
     ZSTD_inBuffer input;
     ZSTD_outBuffer output;
+
+    uint8_t *seekTableChecksums; //the first entry of the seek table if it has checksums, 0 otherwise
+    uint32_t seekTableEntrySize;
+    uint32_t seekTableLength;
+
+    ZSTDSeek_Context *parent; //the context that owns buff and jt if this is a view, 0 otherwise
+    size_t viewStart; //where the view begins in the uncompressed file, 0 if this is not a view
+    size_t viewLength; //the length of the view
+
+    int statsEnabled; //1 if we are recording per frame access statistics
+    int statsSkipping; //1 while seek is decoding data that will not be returned to the caller
+    size_t statsFrame; //the index of the frame being decoded by read
+    ZSTDSeek_FrameAccessStats *stats;
+    size_t statsLength;
+
+    ZSTDSeek_FrameCache *cache; //the decompressed frames, shared with the views, always NULL in a view
+    int decoderStale; //1 if read copied data from the cache, the decoder must be moved to the current position
+
+    ZSTDSeek_CacheEntry *peekEntry; //the frame in the cache returned by peek, pinned until the next call
+    size_t peekSize; //the size returned by peek, 0 if the data can't be consumed
 };
 
 /* Jump Table API */
@@ -131,19 +227,70 @@ uint32_t ZSTDSeek_fromLE32(uint32_t data){
     }
 }
 
+void ZSTDSeek_putLE(uint8_t *p, uint64_t value, size_t bytes){
+    for(size_t i = 0; i < bytes; i++){
+        p[i] = (uint8_t)(value >> (8*i));
+    }
+}
+
+uint64_t ZSTDSeek_getLE(const uint8_t *p, size_t bytes){
+    uint64_t value = 0;
+    for(size_t i = 0; i < bytes; i++){
+        value |= (uint64_t)p[i] << (8*i);
+    }
+    return value;
+}
+
+uint64_t ZSTDSeek_fnv1a(uint64_t hash, const void *data, size_t size){
+    const uint8_t *p = (const uint8_t *)data;
+    for(size_t i = 0; i < size; i++){
+        hash = (hash ^ p[i]) * ZSTDSEEK_FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t ZSTDSeek_mixedHash(const void *data, size_t size){
+    uint64_t h = ZSTDSeek_fnv1a(ZSTDSEEK_FNV_OFFSET_BASIS, data, size);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb93fe53a87b9ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+int ZSTDSeek_writeLE(FILE *f, uint64_t value, size_t bytes){
+    uint8_t buff[8];
+    ZSTDSeek_putLE(buff, value, bytes);
+    return fwrite(buff, 1, bytes, f) == bytes ? 0 : -1;
+}
+
+int ZSTDSeek_readLE(FILE *f, uint64_t *value, size_t bytes){
+    uint8_t buff[8];
+    if(fread(buff, 1, bytes, f) != bytes){
+        return -1;
+    }
+    *value = ZSTDSeek_getLE(buff, bytes);
+    return 0;
+}
+
 int ZSTDSeek_initializeJumpTableUpUntilPos(ZSTDSeek_Context *sctx, size_t upUntilPos){
     if(!sctx){
         DEBUG("ZSTDSeek_Context is NULL\n");
         return -1;
     }
 
+    if(sctx->jumpTableFullyInitialized){ //nothing left to discover, parsing again would add duplicated records
+        return 0;
+    }
+
     void *buff = sctx->buff;
     size_t size = sctx->size;
 
     uint8_t *footer = (uint8_t *)buff + (size - ZSTD_SEEK_TABLE_FOOTER_SIZE);
     uint32_t magicnumber = ZSTDSeek_fromLE32(*((uint32_t *)(footer + 5)));
 
-    if(magicnumber == ZSTD_SEEKABLE_MAGICNUMBER){
+    if(magicnumber == ZSTD_SEEKABLE_MAGICNUMBER && sctx->jt->length == 0){ //a jump table resumed from a token is extended parsing the frames
         DEBUG("Seektable detected\n");
         uint8_t sfd = *((uint8_t*)(footer + 4));
         uint8_t checksumFlag = sfd >> 7;
@@ -176,6 +323,12 @@ int ZSTDSeek_initializeJumpTableUpUntilPos(ZSTDSeek_Context *sctx, size_t upUnti
                     }
                     ZSTDSeek_addJumpTableRecord(sctx->jt, cOffset, dOffset);
 
+                    if(checksumFlag){
+                        sctx->seekTableChecksums = table;
+                        sctx->seekTableEntrySize = sizePerEntry;
+                        sctx->seekTableLength = numFrames;
+                    }
+
                     sctx->jumpTableFullyInitialized = 1;
                     return 0;
                 }
@@ -263,257 +416,1920 @@ int ZSTDSeek_jumpTableIsInitialized(ZSTDSeek_Context *sctx){
     return sctx->jumpTableFullyInitialized;
 }
 
-ZSTDSeek_JumpCoordinate ZSTDSeek_getJumpCoordinate(ZSTDSeek_Context *sctx, size_t uncompressedPos) {
-    if(!sctx->jumpTableFullyInitialized && (sctx->jt->length == 0 || sctx->jt->records[sctx->jt->length-1].uncompressedPos <= uncompressedPos)){
-        ZSTDSeek_initializeJumpTableUpUntilPos(sctx, uncompressedPos);
+size_t ZSTDSeek_frameIndexOfCompressedPos(ZSTDSeek_Context *sctx, size_t compressedPos){
+    //search for the greater value of m where sctx->jt->records[m].compressedPos <= compressedPos
+    size_t l = 0;
+    size_t r = sctx->jt->length;
+    while(r - l > 1){
+        size_t m = l + (r-l)/2;
+        if(sctx->jt->records[m].compressedPos > compressedPos){
+            r = m;
+        }else{
+            l = m;
+        }
     }
+    return l;
+}
 
+size_t ZSTDSeek_frameIndexOfUncompressedPos(ZSTDSeek_Context *sctx, size_t uncompressedPos){
     //search for the greater value of m where sctx->jt->records[m].uncompressedPos <= uncompressedPos
-    uint64_t l = 0;
-    uint64_t r = sctx->jt->length - 1;
-    while(l <= r){
-        uint64_t m = (l+r)/2;
+    size_t l = 0;
+    size_t r = sctx->jt->length;
+    while(r - l > 1){
+        size_t m = l + (r-l)/2;
         if(sctx->jt->records[m].uncompressedPos > uncompressedPos){
-            r = m-1;
-        }else if((m+1) < sctx->jt->length && sctx->jt->records[m+1].uncompressedPos <= uncompressedPos){
-            l = m+1;
+            r = m;
         }else{
-            return (ZSTDSeek_JumpCoordinate){sctx->jt->records[m].compressedPos, uncompressedPos - sctx->jt->records[m].uncompressedPos, sctx->jt->records[m]};
-        }
-    }
-/*
-    //old linear search
-    for(uint64_t i = sctx->jt->length - 1; i >= 0; i--){
-        if(sctx->jt->records[i].uncompressedPos <= uncompressedPos){
-            return (ZSTDSeek_JumpCoordinate){sctx->jt->records[i].compressedPos, uncompressedPos - sctx->jt->records[i].uncompressedPos, sctx->jt->records[i]};
+            l = m;
         }
     }
-*/
-    return (ZSTDSeek_JumpCoordinate){0, uncompressedPos, (ZSTDSeek_JumpTableRecord){0, 0}};
+    return l;
 }
 
-/* Seek API */
-
-ZSTDSeek_Context* ZSTDSeek_createFromFileWithoutJumpTable(const char* file){
-    struct stat st;
-    stat(file, &st);
-
-    int fd = open(file, O_RDONLY, 0);
-    if(fd < 0){
-        DEBUG("Unable to open '%s'\n", file);
-        return NULL;
+size_t ZSTDSeek_startOfData(ZSTDSeek_Context *sctx){
+    //the position where the data readable from this context begins, in the coordinates of the jump table
+    if(sctx->parent){
+        return sctx->viewStart;
     }
+    return sctx->jt->length > 0 ? sctx->jt->records[0].uncompressedPos : 0;
+}
 
-    void* const buff = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if(buff == MAP_FAILED){
-        DEBUG("Unable to mmap '%s'\n",  file);
-        return NULL;
+size_t ZSTDSeek_endOfData(ZSTDSeek_Context *sctx){
+    //the position where the data readable from this context ends, in the coordinates of the jump table
+    if(sctx->parent){
+        return sctx->viewStart + sctx->viewLength;
     }
+    return sctx->jt->length > 0 ? sctx->jt->records[sctx->jt->length-1].uncompressedPos : 0;
+}
 
-    ZSTDSeek_Context *sctx = ZSTDSeek_createWithoutJumpTable(buff, st.st_size);
-    if(sctx){
-        sctx->mmap_fd = fd;
-        sctx->close_fd = 1;
-        return sctx;
-    }else{
-        munmap(buff, st.st_size);
-        close(fd);
+ZSTDSeek_FrameRange* ZSTDSeek_frameRanges(ZSTDSeek_Context *sctx, size_t *length){
+    if(!sctx || !length){
+        DEBUG("Invalid argument\n");
         return NULL;
     }
-}
-
-ZSTDSeek_Context* ZSTDSeek_createFromFile(const char* file){
-    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFileWithoutJumpTable(file);
-    if(sctx && ZSTDSeek_initializeJumpTable(sctx)!=0){
+    if(ZSTDSeek_initializeJumpTable(sctx) != 0){
         DEBUG("Can't initialize the jump table\n");
-        ZSTDSeek_free(sctx);
         return NULL;
     }
-    return sctx;
-}
-
-ZSTDSeek_Context* ZSTDSeek_createFromFileDescriptorWithoutJumpTable(int fd){
-    size_t size = lseek(fd,0L,SEEK_END);
 
-    void* const buff = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if(buff == MAP_FAILED){
-        DEBUG("Unable to mmap file descriptor %d\n",  fd);
+    ZSTDSeek_JumpTable *jt = sctx->jt;
+    size_t start = ZSTDSeek_getViewStart(sctx);
+    size_t end = start + ZSTDSeek_uncompressedFileSize(sctx);
+    ZSTDSeek_FrameRange *ranges = malloc((jt->length > 0 ? jt->length : 1)*sizeof(ZSTDSeek_FrameRange));
+    if(!ranges){
         return NULL;
     }
 
-    ZSTDSeek_Context *sctx = ZSTDSeek_createWithoutJumpTable(buff, size);
-    if(sctx){
-        sctx->mmap_fd = fd;
-        sctx->close_fd = 0;
-        return sctx;
-    }else{
-        munmap(buff, size);
-        close(fd);
-        return NULL;
+    *length = 0;
+    for(size_t i = 0; i + 1 < jt->length; i++){
+        size_t from = jt->records[i].uncompressedPos;
+        size_t to = jt->records[i+1].uncompressedPos;
+        if(to > start && from < end && from < to){ //empty frames are skipped
+            ranges[(*length)++] = (ZSTDSeek_FrameRange){i, from > start ? from : start, to < end ? to : end};
+        }
     }
+    return ranges;
 }
 
-ZSTDSeek_Context* ZSTDSeek_createFromFileDescriptor(int fd){
-    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFileDescriptorWithoutJumpTable(fd);
-    if(sctx && ZSTDSeek_initializeJumpTable(sctx)!=0){
-        DEBUG("Can't initialize the jump table\n");
-        ZSTDSeek_free(sctx);
-        return NULL;
+ZSTDSeek_JumpCoordinate ZSTDSeek_getJumpCoordinate(ZSTDSeek_Context *sctx, size_t uncompressedPos) {
+    if(!sctx->jumpTableFullyInitialized && (sctx->jt->length == 0 || sctx->jt->records[sctx->jt->length-1].uncompressedPos <= uncompressedPos)){
+        ZSTDSeek_initializeJumpTableUpUntilPos(sctx, uncompressedPos);
     }
-    return sctx;
-}
-
-ZSTDSeek_Context* ZSTDSeek_createWithoutJumpTable(void *buff, size_t size){
-    ZSTD_DCtx *dctx = ZSTD_createDCtx();
-
-    ZSTDSeek_Context* sctx = malloc(sizeof(ZSTDSeek_Context));
 
-    sctx->dctx = dctx;
+    if(sctx->jt->length > 0){
+        if(uncompressedPos < sctx->jt->records[0].uncompressedPos){
+            //before the frame the jump table was resumed from, there is nothing to decompress
+            DEBUG("Position %zu is before the jump table\n", uncompressedPos);
+            return (ZSTDSeek_JumpCoordinate){ZSTDSEEK_INVALID_OFFSET, 0, (ZSTDSeek_JumpTableRecord){ZSTDSEEK_INVALID_OFFSET, 0}};
+        }
+        size_t m = ZSTDSeek_frameIndexOfUncompressedPos(sctx, uncompressedPos);
+        return (ZSTDSeek_JumpCoordinate){sctx->jt->records[m].compressedPos, uncompressedPos - sctx->jt->records[m].uncompressedPos, sctx->jt->records[m]};
+    }
+/*
+    //old linear search
+    for(uint64_t i = sctx->jt->length - 1; i >= 0; i--){
+        if(sctx->jt->records[i].uncompressedPos <= uncompressedPos){
+            return (ZSTDSeek_JumpCoordinate){sctx->jt->records[i].compressedPos, uncompressedPos - sctx->jt->records[i].uncompressedPos, sctx->jt->records[i]};
+        }
+    }
+*/
+    return (ZSTDSeek_JumpCoordinate){0, uncompressedPos, (ZSTDSeek_JumpTableRecord){0, 0}};
+}
 
-    sctx->buff = buff;
-    sctx->size = size;
+/* Parallel API */
 
-    sctx->inBuff = (uint8_t*)buff;
+size_t ZSTDSeek_decompressFrame(ZSTDSeek_Context *sctx, ZSTD_DCtx *dctx, size_t frame, void *outBuff, size_t outBuffSize){
+    if(!sctx || !dctx || frame + 1 >= sctx->jt->length){
+        DEBUG("Invalid argument\n");
+        return ZSTDSEEK_ERR_READ;
+    }
 
-    sctx->currentUncompressedPos = 0;
-    sctx->currentCompressedPos = 0;
+    ZSTDSeek_JumpTableRecord r = sctx->jt->records[frame];
+    ZSTDSeek_JumpTableRecord next = sctx->jt->records[frame+1];
+    if(outBuffSize < next.uncompressedPos - r.uncompressedPos){
+        DEBUG("Buffer too small for frame %zu\n", frame);
+        return ZSTDSEEK_ERR_READ;
+    }
 
-    sctx->lastFrameCompressedSize = 0;
+    //the record can span more than one frame, eg a trailing skippable frame, ZSTD_decompressDCtx handles them all
+    size_t ret = ZSTD_decompressDCtx(dctx, outBuff, outBuffSize, (uint8_t *)sctx->buff + r.compressedPos, next.compressedPos - r.compressedPos);
+    if(ZSTD_isError(ret)){
+        DEBUG("Error decompressing frame %zu: %s\n", frame, ZSTD_getErrorName(ret));
+        return ZSTDSEEK_ERR_READ;
+    }
+    return ret;
+}
 
-    sctx->jc = (ZSTDSeek_JumpCoordinate){0,0};
+int ZSTDSeek_defaultNumberOfThreads(){
+#ifdef _WIN32
+    return 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
 
-    sctx->tmpOutBuffSize = ZSTD_DStreamOutSize();
-    sctx->tmpOutBuff = (uint8_t*)malloc(sctx->tmpOutBuffSize);
-    sctx->tmpOutBuffPos = 0;
+typedef struct {
+    ZSTDSeek_pthread_mutex_t mutex;
+    size_t next;
+    size_t end; //exclusive
+} ZSTDSeek_ParallelRange;
 
-    sctx->mmap_fd = -1;
-    sctx->close_fd = 0;
+typedef struct {
+    ZSTDSeek_Context *sctx;
+    ZSTDSeek_FrameCallback fn;
+    ZSTDSeek_MapCallback map;
+    ZSTDSeek_ReduceCallback reduce;
+    //ZSTDSeek_forEachIndexParallel and ZSTDSeek_mapReduceIndexParallel: nothing is decompressed, the callbacks get an index and the slot of their thread
+    ZSTDSeek_IndexCallback indexFn;
+    ZSTDSeek_IndexMapCallback indexMap;
+    ZSTDSeek_IndexReduceCallback indexReduce;
+    ZSTDSeek_FreeCallback freeResult;
+    ZSTDSeek_FreeCallback freeLocal;
+    void *user;
+    size_t n; //the number of indexes
+    int indexed;
+    int ordered; //the results are reduced in order
+
+    size_t firstFrame; //or the first index
+    size_t lastFrame; //exclusive
+    size_t start; //the range to process, in the coordinates of the jump table
+    size_t end;
+
+    ZSTDSeek_pthread_mutex_t mutex;
+    ZSTDSeek_pthread_cond_t cond;
+    int ret;
+
+    //not ordered: every thread begins with a range of frames and steals half of the biggest range left when done
+    ZSTDSeek_ParallelRange *ranges;
+    int nthreads;
+
+    //ordered: frames are taken in order, at most window ahead of the first one not reduced yet
+    size_t nextFrame;
+    size_t reduced;
+    size_t window;
+    void **results; //a ring, the result of frame i is in i % window
+    uint8_t *mapped;
+    int reducing;
+} ZSTDSeek_ParallelJob;
 
-    sctx->input = (ZSTD_inBuffer){sctx->inBuff, 0, 0};
-    sctx->output = (ZSTD_outBuffer){sctx->tmpOutBuff, 0, 0};
+typedef struct {
+    ZSTDSeek_ParallelJob *job;
+    int id;
+    ZSTDSeek_ParallelSlot slot; //only for the indexes
+} ZSTDSeek_ParallelWorker;
+
+void ZSTDSeek_parallelSetFailure(ZSTDSeek_ParallelJob *job, int ret){
+    //called with the mutex locked, record the first failure
+    if(ret != 0 && job->ret == 0){
+        job->ret = ret;
+        ZSTDSeek_pthread_cond_broadcast(&job->cond);
+    }
+}
 
-    sctx->jt = ZSTDSeek_newJumpTable();
-    sctx->jumpTableFullyInitialized = 0;
+int ZSTDSeek_parallelFailed(ZSTDSeek_ParallelJob *job, int ret){
+    //record the first failure, returns the current state
+    ZSTDSeek_pthread_mutex_lock(&job->mutex);
+    ZSTDSeek_parallelSetFailure(job, ret);
+    ret = job->ret;
+    ZSTDSeek_pthread_mutex_unlock(&job->mutex);
+    return ret;
+}
 
-    //test if the buffer starts with a valid frame
-    if(ZSTD_isError(ZSTD_findFrameCompressedSize(sctx->buff, sctx->size))){
-        DEBUG("Invalid format\n");
-        ZSTDSeek_free(sctx);
-        return NULL;
+int ZSTDSeek_parallelSteal(ZSTDSeek_ParallelJob *job, int id, size_t *frame){
+    ZSTDSeek_ParallelRange *own = &job->ranges[id];
+    ZSTDSeek_pthread_mutex_lock(&own->mutex);
+    if(own->next < own->end){
+        *frame = own->next++;
+        ZSTDSeek_pthread_mutex_unlock(&own->mutex);
+        return 1;
     }
+    ZSTDSeek_pthread_mutex_unlock(&own->mutex);
+
+    while(1){
+        int victim = -1;
+        size_t most = 0;
+        for(int i = 0; i < job->nthreads; i++){
+            ZSTDSeek_pthread_mutex_lock(&job->ranges[i].mutex);
+            size_t left = job->ranges[i].end - job->ranges[i].next;
+            ZSTDSeek_pthread_mutex_unlock(&job->ranges[i].mutex);
+            if(left > most){
+                most = left;
+                victim = i;
+            }
+        }
+        if(victim < 0){
+            return 0;
+        }
 
-    return sctx;
+        //take the second half, the victim keeps going on the frames near the ones it has just decoded
+        ZSTDSeek_ParallelRange *r = &job->ranges[victim];
+        ZSTDSeek_pthread_mutex_lock(&r->mutex);
+        size_t left = r->end - r->next;
+        if(left == 0){
+            ZSTDSeek_pthread_mutex_unlock(&r->mutex);
+            continue;
+        }
+        size_t take = (left + 1)/2;
+        size_t first = r->end - take;
+        r->end = first;
+        ZSTDSeek_pthread_mutex_unlock(&r->mutex);
+
+        ZSTDSeek_pthread_mutex_lock(&own->mutex);
+        own->next = first + 1;
+        own->end = first + take;
+        ZSTDSeek_pthread_mutex_unlock(&own->mutex);
+        *frame = first;
+        return 1;
+    }
 }
 
-ZSTDSeek_Context* ZSTDSeek_create(void *buff, size_t size){
-    ZSTDSeek_Context* sctx = ZSTDSeek_createWithoutJumpTable(buff, size);
-    if(sctx && ZSTDSeek_initializeJumpTable(sctx)!=0){
-        DEBUG("Can't initialize the jump table\n");
-        ZSTDSeek_free(sctx);
-        return NULL;
+/*
+ * Decompress frame and returns the part of it in the range of the job, -1 on failure.
+ */
+int ZSTDSeek_parallelDecode(ZSTDSeek_ParallelJob *job, ZSTD_DCtx *dctx, uint8_t **buff, size_t *buffSize, size_t frame, const uint8_t **data, size_t *size, size_t *pos){
+    ZSTDSeek_JumpTable *jt = job->sctx->jt;
+    ZSTDSeek_JumpTableRecord r = jt->records[frame];
+    size_t frameSize = jt->records[frame+1].uncompressedPos - r.uncompressedPos;
+    if(frameSize > *buffSize){
+        uint8_t *tmp = realloc(*buff, frameSize);
+        if(!tmp){
+            return -1;
+        }
+        *buff = tmp;
+        *buffSize = frameSize;
     }
-    return sctx;
-}
 
-size_t ZSTDSeek_read(void *outBuff, size_t outBuffSize, ZSTDSeek_Context *sctx){
-    if(!sctx){
-        DEBUG("ZSTDSeek_Context is NULL\n");
-        return 0;
+    if(ZSTDSeek_decompressFrame(job->sctx, dctx, frame, *buff, *buffSize) != frameSize){
+        return -1;
     }
-    
-    ZSTDSeek_JumpCoordinate localJc = ZSTDSeek_getJumpCoordinate(sctx, sctx->currentUncompressedPos); //trigger the generation of a jump table record, if needed
-    sctx->currentCompressedPos = localJc.jtr.compressedPos;
 
-    size_t maxReadable = ZSTDSeek_lastKnownUncompressedFileSize(sctx) - sctx->currentUncompressedPos;
-    size_t toRead = maxReadable < outBuffSize ? maxReadable : outBuffSize;
-    size_t shouldRead = toRead;
+    //views only see their part of the frames at the edges
+    size_t from = job->start > r.uncompressedPos ? job->start - r.uncompressedPos : 0;
+    size_t to = job->end < r.uncompressedPos + frameSize ? job->end - r.uncompressedPos : frameSize;
+    *data = *buff + from;
+    *size = to - from;
+    *pos = r.uncompressedPos + from - job->sctx->viewStart;
+    return 0;
+}
 
-    if(sctx->tmpOutBuffPos < sctx->output.pos){
-        if(sctx->jc.uncompressedOffset > sctx->output.pos){
-            sctx->jc.uncompressedOffset -= sctx->output.pos;
+void ZSTDSeek_parallelReduce(ZSTDSeek_ParallelJob *job){
+    //called with the mutex locked, the results are reduced in order by one thread at a time
+    if(job->reducing){
+        return;
+    }
+    job->reducing = 1;
+    while(job->ret == 0 && job->reduced < job->lastFrame && job->mapped[job->reduced % job->window]){
+        size_t frame = job->reduced;
+        void *result = job->results[frame % job->window];
+        ZSTDSeek_pthread_mutex_unlock(&job->mutex);
+
+        int ret;
+        if(job->indexed){
+            ret = job->indexReduce(result, frame, job->user);
         }else{
-            size_t maxCopy = (sctx->output.pos - sctx->tmpOutBuffPos) - sctx->jc.uncompressedOffset;
-            size_t toCopy = maxCopy < toRead ? maxCopy : toRead;
-
-            memcpy(outBuff, sctx->tmpOutBuff+sctx->tmpOutBuffPos+sctx->jc.uncompressedOffset, toCopy);
-            toRead -= toCopy;
-            outBuff = (uint8_t *)outBuff + toCopy;
-            sctx->currentUncompressedPos += toCopy;
-            sctx->tmpOutBuffPos += toCopy + sctx->jc.uncompressedOffset;
-            sctx->jc.uncompressedOffset = 0;
+            size_t pos = job->sctx->jt->records[frame].uncompressedPos;
+            pos = (pos > job->start ? pos : job->start) - job->sctx->viewStart;
+            ret = job->reduce(result, pos, frame, job->user);
         }
+
+        ZSTDSeek_pthread_mutex_lock(&job->mutex);
+        ZSTDSeek_parallelSetFailure(job, ret);
+        job->mapped[frame % job->window] = 0;
+        job->reduced++;
+        ZSTDSeek_pthread_cond_broadcast(&job->cond);
     }
+    job->reducing = 0;
+}
 
-    while (toRead > 0 && ((sctx->input.pos < sctx->input.size) || (sctx->lastFrameCompressedSize = ZSTD_findFrameCompressedSize(sctx->inBuff, sctx->size)) > 0)){
-        if(sctx->input.pos == sctx->input.size){
-            sctx->input = (ZSTD_inBuffer){sctx->inBuff, sctx->lastFrameCompressedSize, 0};
-        }
+void* ZSTDSeek_parallelWorker(void *arg){
+    ZSTDSeek_ParallelWorker *worker = (ZSTDSeek_ParallelWorker *)arg;
+    ZSTDSeek_ParallelJob *job = worker->job;
 
-        while (sctx->input.pos < sctx->input.size) {
-            sctx->output = (ZSTD_outBuffer){ sctx->tmpOutBuff, sctx->tmpOutBuffSize, 0 };
-            sctx->tmpOutBuffPos = 0;
-            size_t const ret = ZSTD_decompressStream(sctx->dctx, &sctx->output , &sctx->input);
+    //every thread reuses its own decoder and output buffer for all its frames
+    ZSTD_DCtx *dctx = job->indexed ? NULL : ZSTD_createDCtx();
+    uint8_t *buff = NULL;
+    size_t buffSize = 0;
 
-            if(ZSTD_isError(ret)){
-                DEBUG("Error decompressing: %s\n", ZSTD_getErrorName(ret));
-                return ZSTDSEEK_ERR_READ;
+    int ret = dctx || job->indexed ? 0 : -1;
+    while(ret == 0 && ZSTDSeek_parallelFailed(job, 0) == 0){
+        size_t frame;
+        if(!job->ordered){
+            if(!ZSTDSeek_parallelSteal(job, worker->id, &frame)){
+                break;
             }
-
-            sctx->currentCompressedPos += sctx->input.pos;
-
-            if(sctx->jc.uncompressedOffset > sctx->output.pos){
-                sctx->jc.uncompressedOffset -= sctx->output.pos;
-            }else{
-                size_t maxCopy = (sctx->output.pos - sctx->tmpOutBuffPos) - sctx->jc.uncompressedOffset;
-                size_t toCopy = maxCopy < toRead ? maxCopy : toRead;
-
-                memcpy(outBuff, sctx->tmpOutBuff+sctx->tmpOutBuffPos+sctx->jc.uncompressedOffset, toCopy);
-                toRead -= toCopy;
-                outBuff = (uint8_t *)outBuff + toCopy;
-                sctx->currentUncompressedPos += toCopy;
-                sctx->tmpOutBuffPos += toCopy + sctx->jc.uncompressedOffset;
-                sctx->jc.uncompressedOffset = 0;
+        }else{
+            ZSTDSeek_pthread_mutex_lock(&job->mutex);
+            while(job->ret == 0 && job->nextFrame < job->lastFrame && job->nextFrame >= job->reduced + job->window){ //don't get too far ahead of the reduction
+                ZSTDSeek_pthread_cond_wait(&job->cond, &job->mutex);
             }
-
-            if(toRead == 0){
+            frame = job->nextFrame;
+            if(job->ret != 0 || frame >= job->lastFrame){
+                ZSTDSeek_pthread_mutex_unlock(&job->mutex);
                 break;
             }
+            job->nextFrame++;
+            ZSTDSeek_pthread_mutex_unlock(&job->mutex);
         }
 
-        if(sctx->input.pos == sctx->input.size){ //end of frame
-            sctx->inBuff+=sctx->lastFrameCompressedSize;
+        const uint8_t *data;
+        size_t size;
+        size_t pos;
+        void *result = NULL;
+        if(job->indexFn){
+            ret = job->indexFn(frame, &worker->slot, job->user);
+        }else if(job->indexMap){
+            ret = job->indexMap(frame, &worker->slot, &result, job->user);
+        }else if(ZSTDSeek_parallelDecode(job, dctx, &buff, &buffSize, frame, &data, &size, &pos) != 0){
+            ret = -1;
+        }else if(job->fn){
+            ret = job->fn(data, size, pos, frame, job->user);
+        }else{
+            ret = job->map(data, size, pos, frame, &result, job->user);
         }
-
-        if(toRead == 0){
-            break;
+        if(job->ordered){
+            ZSTDSeek_pthread_mutex_lock(&job->mutex);
+            ZSTDSeek_parallelSetFailure(job, ret);
+            job->results[frame % job->window] = result;
+            job->mapped[frame % job->window] = 1;
+            ZSTDSeek_parallelReduce(job);
+            ZSTDSeek_pthread_mutex_unlock(&job->mutex);
         }
     }
+    ZSTDSeek_parallelFailed(job, ret);
 
-    return shouldRead - toRead;
+    ZSTD_freeDCtx(dctx);
+    free(buff);
+    return NULL;
 }
 
-int ZSTDSeek_seek(ZSTDSeek_Context *sctx, long offset, int origin){
-    if(!sctx){
-        DEBUG("ZSTDSeek_Context is NULL\n");
+int ZSTDSeek_parallelRun(ZSTDSeek_ParallelJob *job, int nthreads){
+    ZSTDSeek_Context *sctx = job->sctx;
+    if(!sctx->parent && ZSTDSeek_initializeJumpTable(sctx) != 0){ //the jump table must not change while the threads read it
+        DEBUG("Can't initialize the jump table\n");
         return -1;
     }
-    if(origin == SEEK_CUR){
-        if(offset==0){
-            return 0;
-        }
-        offset = (long)sctx->currentUncompressedPos + offset;
-        origin = SEEK_SET;
-    }else if(origin == SEEK_END){
-        offset = (long)ZSTDSeek_uncompressedFileSize(sctx) + offset;
-        origin = SEEK_SET;
+
+    job->start = sctx->viewStart;
+    job->end = ZSTDSeek_endOfData(sctx);
+    if(job->indexed){
+        job->firstFrame = 0;
+        job->lastFrame = job->n;
+    }else if(job->end > job->start){
+        job->firstFrame = ZSTDSeek_frameIndexOfUncompressedPos(sctx, job->start);
+        job->lastFrame = ZSTDSeek_frameIndexOfUncompressedPos(sctx, job->end - 1) + 1;
     }
-    if(origin == SEEK_SET){
+    if(job->lastFrame == job->firstFrame){
+        return 0;
+    }
+    job->ret = 0;
+
+    if(nthreads <= 0){
+        nthreads = ZSTDSeek_defaultNumberOfThreads();
+    }
+    if((size_t)nthreads > job->lastFrame - job->firstFrame){
+        nthreads = (int)(job->lastFrame - job->firstFrame);
+    }
+    job->nthreads = nthreads;
+
+    ZSTDSeek_ParallelWorker *workers = calloc(nthreads, sizeof(ZSTDSeek_ParallelWorker));
+    ZSTDSeek_pthread_t *threads = malloc(nthreads*sizeof(ZSTDSeek_pthread_t));
+    if(!job->ordered){
+        job->ranges = malloc(nthreads*sizeof(ZSTDSeek_ParallelRange));
+    }else{
+        job->nextFrame = job->firstFrame;
+        job->reduced = job->firstFrame;
+        job->reducing = 0;
+        job->window = (size_t)nthreads*4;
+        job->results = calloc(job->window, sizeof(void *));
+        job->mapped = calloc(job->window, 1);
+    }
+    int ready = workers && threads && (job->ordered ? job->results && job->mapped : job->ranges != NULL);
+    for(int i = 0; job->indexed && ready && i < nthreads; i++){
+        //every thread reads through its own view of the context
+        workers[i].slot.view = ZSTDSeek_createView(sctx, 0, ZSTDSeek_uncompressedFileSize(sctx));
+        ready = workers[i].slot.view != NULL;
+    }
+    if(!ready){
+        for(int i = 0; workers && i < nthreads; i++){
+            if(workers[i].slot.view){
+                ZSTDSeek_free(workers[i].slot.view);
+            }
+        }
+        free(workers);
+        free(threads);
+        free(job->ranges);
+        free(job->results);
+        free(job->mapped);
+        return -1;
+    }
+
+    size_t frames = job->lastFrame - job->firstFrame;
+    for(int i = 0; job->ranges && i < nthreads; i++){
+        ZSTDSeek_pthread_mutex_init(&job->ranges[i].mutex, NULL);
+        job->ranges[i].next = job->firstFrame + frames*i/nthreads;
+        job->ranges[i].end = job->firstFrame + frames*(i+1)/nthreads;
+    }
+    ZSTDSeek_pthread_mutex_init(&job->mutex, NULL);
+    ZSTDSeek_pthread_cond_init(&job->cond, NULL);
+
+    int started = 1;
+    for(int i = 0; i < nthreads; i++){
+        workers[i].job = job;
+        workers[i].id = i;
+    }
+    for(; started < nthreads; started++){ //the calling thread is a worker too
+        if(ZSTDSeek_pthread_create(&threads[started], NULL, ZSTDSeek_parallelWorker, &workers[started]) != 0){
+            break;
+        }
+    }
+    ZSTDSeek_parallelWorker(&workers[0]);
+    for(int i = 1; i < started; i++){
+        ZSTDSeek_pthread_join(threads[i], NULL);
+    }
+
+    for(size_t i = 0; job->mapped && i < job->window; i++){ //mapped but not reduced because the processing stopped
+        if(job->mapped[i]){
+            if(job->freeResult){
+                job->freeResult(job->results[i]);
+            }else{
+                free(job->results[i]);
+            }
+        }
+    }
+    for(int i = 0; job->indexed && i < nthreads; i++){
+        ZSTDSeek_free(workers[i].slot.view);
+        if(job->freeLocal){
+            job->freeLocal(workers[i].slot.local);
+        }else{
+            free(workers[i].slot.local);
+        }
+    }
+    for(int i = 0; job->ranges && i < nthreads; i++){
+        ZSTDSeek_pthread_mutex_destroy(&job->ranges[i].mutex);
+    }
+    ZSTDSeek_pthread_cond_destroy(&job->cond);
+    ZSTDSeek_pthread_mutex_destroy(&job->mutex);
+    free(workers);
+    free(threads);
+    free(job->ranges);
+    free(job->results);
+    free(job->mapped);
+    return job->ret;
+}
+
+int ZSTDSeek_forEachFrameParallel(ZSTDSeek_Context *sctx, ZSTDSeek_FrameCallback fn, void *user, int nthreads){
+    if(!sctx || !fn){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    ZSTDSeek_ParallelJob job;
+    memset(&job, 0, sizeof(job));
+    job.sctx = sctx;
+    job.fn = fn;
+    job.user = user;
+    return ZSTDSeek_parallelRun(&job, nthreads);
+}
+
+int ZSTDSeek_mapReduceFramesParallel(ZSTDSeek_Context *sctx, ZSTDSeek_MapCallback map, ZSTDSeek_ReduceCallback reduce, void *user, int nthreads){
+    if(!sctx || !map || !reduce){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    ZSTDSeek_ParallelJob job;
+    memset(&job, 0, sizeof(job));
+    job.sctx = sctx;
+    job.map = map;
+    job.reduce = reduce;
+    job.user = user;
+    job.ordered = 1;
+    return ZSTDSeek_parallelRun(&job, nthreads);
+}
+
+int ZSTDSeek_forEachIndexParallel(ZSTDSeek_Context *sctx, size_t n, ZSTDSeek_IndexCallback fn, ZSTDSeek_FreeCallback freeLocal, void *user, int nthreads){
+    if(!sctx || !fn){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    ZSTDSeek_ParallelJob job;
+    memset(&job, 0, sizeof(job));
+    job.sctx = sctx;
+    job.n = n;
+    job.indexFn = fn;
+    job.freeLocal = freeLocal;
+    job.user = user;
+    job.indexed = 1;
+    return ZSTDSeek_parallelRun(&job, nthreads);
+}
+
+int ZSTDSeek_mapReduceIndexParallel(ZSTDSeek_Context *sctx, size_t n, ZSTDSeek_IndexMapCallback map, ZSTDSeek_IndexReduceCallback reduce,
+                                    ZSTDSeek_FreeCallback freeResult, ZSTDSeek_FreeCallback freeLocal, void *user, int nthreads){
+    if(!sctx || !map || !reduce){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    ZSTDSeek_ParallelJob job;
+    memset(&job, 0, sizeof(job));
+    job.sctx = sctx;
+    job.n = n;
+    job.indexMap = map;
+    job.indexReduce = reduce;
+    job.freeResult = freeResult;
+    job.freeLocal = freeLocal;
+    job.user = user;
+    job.indexed = 1;
+    job.ordered = 1;
+    return ZSTDSeek_parallelRun(&job, nthreads);
+}
+
+/* Passthrough API */
+
+const void* ZSTDSeek_getCompressedBuffer(ZSTDSeek_Context *sctx, size_t *size){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return NULL;
+    }
+    if(size){
+        *size = sctx->size;
+    }
+    return sctx->buff;
+}
+
+int ZSTDSeek_getCompressedExtent(ZSTDSeek_Context *sctx, size_t offset, size_t length, ZSTDSeek_CompressedExtent *extent){
+    if(!sctx || !extent || length == 0){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    offset += sctx->viewStart;
+    size_t end = offset + length;
+    if(end < offset){
+        DEBUG("Range overflow\n");
+        return ZSTDSEEK_ERR_BEYOND_END_SEEK;
+    }
+    if(!sctx->jumpTableFullyInitialized && ZSTDSeek_endOfData(sctx) < end){
+        ZSTDSeek_initializeJumpTableUpUntilPos(sctx, end);
+    }
+    if(ZSTDSeek_endOfData(sctx) < end){
+        DEBUG("Range beyond the end of the file\n");
+        return ZSTDSEEK_ERR_BEYOND_END_SEEK;
+    }
+    if(offset < ZSTDSeek_startOfData(sctx)){
+        DEBUG("Range before the frame the context was resumed from\n");
+        return ZSTDSEEK_ERR_NEGATIVE_SEEK;
+    }
+
+    size_t firstFrame = ZSTDSeek_frameIndexOfUncompressedPos(sctx, offset);
+    size_t lastFrame = ZSTDSeek_frameIndexOfUncompressedPos(sctx, end - 1);
+    ZSTDSeek_JumpTableRecord first = sctx->jt->records[firstFrame];
+    ZSTDSeek_JumpTableRecord next = sctx->jt->records[lastFrame + 1];
+
+    *extent = (ZSTDSeek_CompressedExtent){
+        first.compressedPos,
+        next.compressedPos - first.compressedPos,
+        firstFrame,
+        lastFrame,
+        offset - first.uncompressedPos,
+        next.uncompressedPos - end
+    };
+    return 0;
+}
+
+int ZSTDSeek_getFrameChecksum(ZSTDSeek_Context *sctx, size_t frame, uint32_t *checksum){
+    if(!sctx || !checksum){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    if(sctx->seekTableChecksums && frame < sctx->seekTableLength && sctx->jt->length == sctx->seekTableLength + 1){
+        *checksum = ZSTDSeek_fromLE32(*((uint32_t *)(sctx->seekTableChecksums + (frame * sctx->seekTableEntrySize) + 8)));
+        return 0;
+    }
+
+    if(frame + 1 >= sctx->jt->length){
+        DEBUG("Frame %zu is not in the jump table\n", frame);
+        return -1;
+    }
+
+    //no seek table, look for the checksum at the end of the frame
+    uint8_t *buff = (uint8_t *)sctx->buff + sctx->jt->records[frame].compressedPos;
+    size_t spanSize = sctx->jt->records[frame+1].compressedPos - sctx->jt->records[frame].compressedPos;
+    uint32_t const magic = ZSTDSeek_fromLE32(*((uint32_t *)buff));
+    size_t frameCompressedSize = ZSTD_findFrameCompressedSize(buff, spanSize);
+    if(magic != ZSTD_MAGICNUMBER || ZSTD_isError(frameCompressedSize) || frameCompressedSize < 9){
+        DEBUG("Frame %zu is not a valid zstd frame\n", frame);
+        return -1;
+    }
+    if(!((buff[4] >> 2) & 1)){ //Content_Checksum_flag of the frame header descriptor
+        return -1;
+    }
+    *checksum = ZSTDSeek_fromLE32(*((uint32_t *)(buff + frameCompressedSize - 4)));
+    return 0;
+}
+
+/* Access Statistics API */
+
+ZSTDSeek_FrameAccessStats* ZSTDSeek_getFrameAccessStats(ZSTDSeek_Context *sctx, size_t frame){
+    if(frame >= sctx->statsLength){
+        size_t newLength = sctx->jt->length > frame+1 ? sctx->jt->length : frame+1;
+        ZSTDSeek_FrameAccessStats *stats = realloc(sctx->stats, newLength*sizeof(ZSTDSeek_FrameAccessStats));
+        if(!stats){
+            DEBUG("Can't allocate the access statistics\n");
+            return NULL;
+        }
+        memset(stats + sctx->statsLength, 0, (newLength - sctx->statsLength)*sizeof(ZSTDSeek_FrameAccessStats));
+        sctx->stats = stats;
+        sctx->statsLength = newLength;
+    }
+    return &sctx->stats[frame];
+}
+
+void ZSTDSeek_recordReturnedBytes(ZSTDSeek_Context *sctx, size_t returned, size_t *lastAccessedFrame){
+    if(sctx->statsSkipping || returned == 0){
+        return;
+    }
+    ZSTDSeek_FrameAccessStats *fas = ZSTDSeek_getFrameAccessStats(sctx, sctx->statsFrame);
+    if(!fas){
+        return;
+    }
+    if(*lastAccessedFrame != sctx->statsFrame){
+        fas->accesses++;
+        *lastAccessedFrame = sctx->statsFrame;
+    }
+    fas->returnedBytes += returned;
+}
+
+void ZSTDSeek_enableAccessStats(ZSTDSeek_Context *sctx, int enable){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return;
+    }
+    if(enable && !sctx->statsEnabled && sctx->input.pos < sctx->input.size){ //we are in the middle of a frame, find out which one
+        sctx->statsFrame = ZSTDSeek_frameIndexOfCompressedPos(sctx, sctx->inBuff - (uint8_t *)sctx->buff);
+    }
+    sctx->statsEnabled = enable ? 1 : 0;
+}
+
+const ZSTDSeek_FrameAccessStats* ZSTDSeek_getAccessStats(ZSTDSeek_Context *sctx, size_t *length){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return NULL;
+    }
+    if(length){
+        *length = sctx->statsLength;
+    }
+    return sctx->stats;
+}
+
+void ZSTDSeek_resetAccessStats(ZSTDSeek_Context *sctx){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return;
+    }
+    if(sctx->stats){
+        memset(sctx->stats, 0, sctx->statsLength*sizeof(ZSTDSeek_FrameAccessStats));
+    }
+}
+
+int ZSTDSeek_writeAccessStats(ZSTDSeek_Context *sctx, FILE *f){
+    if(!sctx || !f){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    fprintf(f, "#frame\tcompressedPos\tuncompressedPos\tuncompressedSize\taccesses\tdecodedBytes\treturnedBytes\n");
+    for(size_t i = 0; i+1 < sctx->jt->length; i++){
+        ZSTDSeek_JumpTableRecord r = sctx->jt->records[i];
+        size_t uncompressedSize = sctx->jt->records[i+1].uncompressedPos - r.uncompressedPos;
+        ZSTDSeek_FrameAccessStats fas = i < sctx->statsLength ? sctx->stats[i] : (ZSTDSeek_FrameAccessStats){0, 0, 0};
+        fprintf(f, "%zu\t%zu\t%zu\t%zu\t%llu\t%llu\t%llu\n", i, r.compressedPos, r.uncompressedPos, uncompressedSize,
+                (unsigned long long)fas.accesses, (unsigned long long)fas.decodedBytes, (unsigned long long)fas.returnedBytes);
+    }
+    return ferror(f) ? -1 : 0;
+}
+
+/* Seek API */
+
+ZSTDSeek_Context* ZSTDSeek_createFromFileWithoutJumpTable(const char* file){
+    struct stat st;
+    stat(file, &st);
+
+    int fd = open(file, O_RDONLY, 0);
+    if(fd < 0){
+        DEBUG("Unable to open '%s'\n", file);
+        return NULL;
+    }
+
+    void* const buff = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(buff == MAP_FAILED){
+        DEBUG("Unable to mmap '%s'\n",  file);
+        return NULL;
+    }
+
+    ZSTDSeek_Context *sctx = ZSTDSeek_createWithoutJumpTable(buff, st.st_size);
+    if(sctx){
+        sctx->mmap_fd = fd;
+        sctx->close_fd = 1;
+        return sctx;
+    }else{
+        munmap(buff, st.st_size);
+        close(fd);
+        return NULL;
+    }
+}
+
+ZSTDSeek_Context* ZSTDSeek_createFromFile(const char* file){
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFileWithoutJumpTable(file);
+    if(sctx && ZSTDSeek_initializeJumpTable(sctx)!=0){
+        DEBUG("Can't initialize the jump table\n");
+        ZSTDSeek_free(sctx);
+        return NULL;
+    }
+    return sctx;
+}
+
+ZSTDSeek_Context* ZSTDSeek_createFromFileDescriptorWithoutJumpTable(int fd){
+    size_t size = lseek(fd,0L,SEEK_END);
+
+    void* const buff = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(buff == MAP_FAILED){
+        DEBUG("Unable to mmap file descriptor %d\n",  fd);
+        return NULL;
+    }
+
+    ZSTDSeek_Context *sctx = ZSTDSeek_createWithoutJumpTable(buff, size);
+    if(sctx){
+        sctx->mmap_fd = fd;
+        sctx->close_fd = 0;
+        return sctx;
+    }else{
+        munmap(buff, size);
+        close(fd);
+        return NULL;
+    }
+}
+
+ZSTDSeek_Context* ZSTDSeek_createFromFileDescriptor(int fd){
+    ZSTDSeek_Context* sctx = ZSTDSeek_createFromFileDescriptorWithoutJumpTable(fd);
+    if(sctx && ZSTDSeek_initializeJumpTable(sctx)!=0){
+        DEBUG("Can't initialize the jump table\n");
+        ZSTDSeek_free(sctx);
+        return NULL;
+    }
+    return sctx;
+}
+
+ZSTDSeek_Context* ZSTDSeek_createWithoutJumpTable(void *buff, size_t size){
+    ZSTD_DCtx *dctx = ZSTD_createDCtx();
+
+    ZSTDSeek_Context* sctx = malloc(sizeof(ZSTDSeek_Context));
+
+    sctx->dctx = dctx;
+
+    sctx->buff = buff;
+    sctx->size = size;
+
+    sctx->inBuff = (uint8_t*)buff;
+
+    sctx->currentUncompressedPos = 0;
+    sctx->currentCompressedPos = 0;
+
+    sctx->lastFrameCompressedSize = 0;
+
+    sctx->jc = (ZSTDSeek_JumpCoordinate){0,0};
+
+    sctx->tmpOutBuffSize = ZSTD_DStreamOutSize();
+    sctx->tmpOutBuff = (uint8_t*)malloc(sctx->tmpOutBuffSize);
+    sctx->tmpOutBuffPos = 0;
+
+    sctx->mmap_fd = -1;
+    sctx->close_fd = 0;
+
+    sctx->input = (ZSTD_inBuffer){sctx->inBuff, 0, 0};
+    sctx->output = (ZSTD_outBuffer){sctx->tmpOutBuff, 0, 0};
+
+    sctx->jt = ZSTDSeek_newJumpTable();
+    sctx->jumpTableFullyInitialized = 0;
+    sctx->jumpTableFirstFrame = 0;
+
+    sctx->seekTableChecksums = NULL;
+    sctx->seekTableEntrySize = 0;
+    sctx->seekTableLength = 0;
+
+    sctx->parent = NULL;
+    sctx->viewStart = 0;
+    sctx->viewLength = 0;
+
+    sctx->statsEnabled = 0;
+    sctx->statsSkipping = 0;
+    sctx->statsFrame = 0;
+    sctx->stats = NULL;
+    sctx->statsLength = 0;
+
+    sctx->cache = NULL;
+    sctx->decoderStale = 0;
+
+    sctx->peekEntry = NULL;
+    sctx->peekSize = 0;
+
+    //test if the buffer starts with a valid frame
+    if(ZSTD_isError(ZSTD_findFrameCompressedSize(sctx->buff, sctx->size))){
+        DEBUG("Invalid format\n");
+        ZSTDSeek_free(sctx);
+        return NULL;
+    }
+
+    return sctx;
+}
+
+ZSTDSeek_Context* ZSTDSeek_create(void *buff, size_t size){
+    ZSTDSeek_Context* sctx = ZSTDSeek_createWithoutJumpTable(buff, size);
+    if(sctx && ZSTDSeek_initializeJumpTable(sctx)!=0){
+        DEBUG("Can't initialize the jump table\n");
+        ZSTDSeek_free(sctx);
+        return NULL;
+    }
+    return sctx;
+}
+
+ZSTDSeek_Context* ZSTDSeek_createView(ZSTDSeek_Context *sctx, size_t start, size_t length){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return NULL;
+    }
+
+    if(sctx->parent){ //a view of a view is a view of the same parent
+        if(start > sctx->viewLength || length > sctx->viewLength - start){
+            DEBUG("View beyond the end of the parent view\n");
+            return NULL;
+        }
+        start += sctx->viewStart;
+        sctx = sctx->parent;
+    }
+
+    size_t end = start + length;
+    if(end < start){
+        DEBUG("View overflow\n");
+        return NULL;
+    }
+    if(start < ZSTDSeek_startOfData(sctx)){
+        DEBUG("View before the frame the context was resumed from\n");
+        return NULL;
+    }
+    if(!sctx->jumpTableFullyInitialized && ZSTDSeek_lastKnownUncompressedFileSize(sctx) <= end){
+        ZSTDSeek_initializeJumpTableUpUntilPos(sctx, end);
+    }
+    if(ZSTDSeek_lastKnownUncompressedFileSize(sctx) < end){
+        DEBUG("View beyond the end of the file\n");
+        return NULL;
+    }
+
+    ZSTDSeek_Context *view = malloc(sizeof(ZSTDSeek_Context));
+    if(!view){
+        return NULL;
+    }
+
+    *view = *sctx; //share buff, jt and the file descriptor..
+
+    view->dctx = ZSTD_createDCtx(); //..but not the decoding state
+    view->tmpOutBuff = (uint8_t*)malloc(view->tmpOutBuffSize);
+    view->tmpOutBuffPos = 0;
+    view->close_fd = 0;
+
+    view->inBuff = (uint8_t*)view->buff;
+    view->currentUncompressedPos = 0;
+    view->currentCompressedPos = 0;
+    view->lastFrameCompressedSize = 0;
+    view->jc = (ZSTDSeek_JumpCoordinate){0, 0, (ZSTDSeek_JumpTableRecord){0, 0}};
+    view->input = (ZSTD_inBuffer){view->inBuff, 0, 0};
+    view->output = (ZSTD_outBuffer){view->tmpOutBuff, 0, 0};
+
+    view->jumpTableFullyInitialized = 1; //the jump table covers the whole view, it must never be extended by the view
+
+    view->statsEnabled = 0;
+    view->statsSkipping = 0;
+    view->statsFrame = 0;
+    view->stats = NULL;
+    view->statsLength = 0;
+
+    view->cache = NULL; //the one of the parent is used
+    view->decoderStale = 0;
+
+    view->peekEntry = NULL;
+    view->peekSize = 0;
+
+    view->parent = sctx;
+    view->viewStart = 0;
+    view->viewLength = 0;
+
+    if(ZSTDSeek_moveView(view, start, length) != 0){
+        ZSTDSeek_free(view);
+        return NULL;
+    }
+
+    return view;
+}
+
+int ZSTDSeek_moveView(ZSTDSeek_Context *view, size_t start, size_t length){
+    if(!view || !view->parent){
+        DEBUG("Not a view\n");
+        return -1;
+    }
+
+    size_t end = start + length;
+    if(end < start || ZSTDSeek_lastKnownUncompressedFileSize(view->parent) < end){
+        DEBUG("View beyond the end of the file\n");
+        return -1;
+    }
+    if(start < ZSTDSeek_startOfData(view->parent)){
+        DEBUG("View before the frame the context was resumed from\n");
+        return -1;
+    }
+
+    size_t oldStart = view->viewStart;
+    size_t oldLength = view->viewLength;
+
+    //move to the beginning of the new slice while the view spans the file, if it's ahead in the same frame the decoder state is reused
+    view->viewStart = 0;
+    view->viewLength = end;
+    if(ZSTDSeek_seek(view, (long)start, SEEK_SET) != 0){
+        DEBUG("Can't seek to the beginning of the view\n");
+        view->viewStart = oldStart;
+        view->viewLength = oldLength;
+        return -1;
+    }
+    view->viewStart = start;
+    view->viewLength = length;
+
+    return 0;
+}
+
+size_t ZSTDSeek_getViewStart(ZSTDSeek_Context *sctx){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return 0;
+    }
+    return sctx->viewStart;
+}
+
+/*
+ * Move the decoder to the beginning of the frame of jc, the data up until offset is skipped by the next read.
+ */
+void ZSTDSeek_resetDecoder(ZSTDSeek_Context *sctx, ZSTDSeek_JumpCoordinate jc, size_t offset){
+    ZSTD_DCtx_reset(sctx->dctx, ZSTD_reset_session_only);
+
+    sctx->jc = jc;
+
+    sctx->inBuff = (uint8_t *)sctx->buff + sctx->jc.compressedOffset; //jump to the beginning of the frame..
+    sctx->currentUncompressedPos = offset; //..and adjust the uncompressed position..
+    sctx->currentCompressedPos = sctx->jc.compressedOffset;
+    sctx->tmpOutBuffPos = 0; //..and reset the position in the tmp buffer
+    sctx->input = (ZSTD_inBuffer){sctx->inBuff, 0, 0};
+    sctx->output = (ZSTD_outBuffer){sctx->tmpOutBuff, 0, 0};
+    sctx->decoderStale = 0;
+}
+
+/* Resume API */
+
+uint64_t ZSTDSeek_fileHash(ZSTDSeek_Context *sctx){
+    //FNV-1a of the first and the last 4 KiB, with the size in the token it tells apart a different or rewritten file without reading all of it
+    const uint8_t *buff = (const uint8_t *)sctx->buff;
+    size_t n = sctx->size < 4096 ? sctx->size : 4096;
+    uint64_t hash = ZSTDSeek_fnv1a(ZSTDSEEK_FNV_OFFSET_BASIS, buff, n);
+    return ZSTDSeek_fnv1a(hash, buff + sctx->size - n, n);
+}
+
+int ZSTDSeek_getResumeToken(ZSTDSeek_Context *sctx, ZSTDSeek_ResumeToken *token){
+    if(!sctx || !token){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    size_t pos = sctx->currentUncompressedPos;
+    ZSTDSeek_getJumpCoordinate(sctx, pos); //make sure the frame of the position is in the jump table
+    if(sctx->jt->length == 0){
+        return -1;
+    }
+    size_t frame = ZSTDSeek_frameIndexOfUncompressedPos(sctx, pos);
+    ZSTDSeek_JumpTableRecord r = sctx->jt->records[frame];
+    uint32_t checksum;
+
+    *token = (ZSTDSeek_ResumeToken){
+        sctx->size,
+        ZSTDSeek_fileHash(sctx),
+        sctx->jumpTableFirstFrame + frame,
+        r.compressedPos,
+        r.uncompressedPos,
+        pos - r.uncompressedPos,
+        ZSTDSeek_getFrameChecksum(sctx, frame, &checksum) == 0 ? checksum : UINT64_MAX
+    };
+    return 0;
+}
+
+void ZSTDSeek_encodeResumeToken(const ZSTDSeek_ResumeToken *token, uint8_t *buff){
+    const uint64_t values[ZSTDSEEK_RESUME_TOKEN_ENCODED_SIZE/8] = {
+        ZSTDSEEK_RESUME_TOKEN_MAGICNUMBER,
+        ZSTDSEEK_RESUME_TOKEN_VERSION,
+        token->fileSize,
+        token->fileHash,
+        token->frame,
+        token->compressedPos,
+        token->uncompressedPos,
+        token->offset,
+        token->checksum
+    };
+    for(size_t i = 0; i < ZSTDSEEK_RESUME_TOKEN_ENCODED_SIZE/8; i++){
+        ZSTDSeek_putLE(buff + 8*i, values[i], 8);
+    }
+}
+
+int ZSTDSeek_decodeResumeToken(const uint8_t *buff, size_t size, ZSTDSeek_ResumeToken *token){
+    if(!buff || !token || size < ZSTDSEEK_RESUME_TOKEN_ENCODED_SIZE){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    uint64_t values[ZSTDSEEK_RESUME_TOKEN_ENCODED_SIZE/8];
+    for(size_t i = 0; i < ZSTDSEEK_RESUME_TOKEN_ENCODED_SIZE/8; i++){
+        values[i] = ZSTDSeek_getLE(buff + 8*i, 8);
+    }
+    if(values[0] != ZSTDSEEK_RESUME_TOKEN_MAGICNUMBER || values[1] != ZSTDSEEK_RESUME_TOKEN_VERSION){
+        DEBUG("Not a resume token\n");
+        return -1;
+    }
+
+    *token = (ZSTDSeek_ResumeToken){values[2], values[3], values[4], values[5], values[6], values[7], values[8]};
+    return 0;
+}
+
+int ZSTDSeek_seekToResumeToken(ZSTDSeek_Context *sctx, const ZSTDSeek_ResumeToken *token){
+    if(!sctx || !token){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    ZSTDSeek_Context *root = sctx->parent ? sctx->parent : sctx;
+    if(token->fileSize != root->size || token->compressedPos > root->size || token->fileHash != ZSTDSeek_fileHash(root)){
+        DEBUG("The token doesn't match the file\n");
+        return -1;
+    }
+
+    size_t pos = token->uncompressedPos + token->offset;
+    //the jump table seeded from the token is dropped if the token turns out not to match, as if it was never used
+    int seeded = 0;
+    size_t firstFrame = root->jumpTableFirstFrame;
+    int fullyInitialized = root->jumpTableFullyInitialized;
+    if(root->jt->length == 0){
+        //nothing parsed yet, the jump table starts from the frame of the token
+        if(token->compressedPos < root->size && ZSTD_isError(ZSTD_findFrameCompressedSize((uint8_t *)root->buff + token->compressedPos, root->size - token->compressedPos))){
+            DEBUG("The token doesn't match the file\n");
+            return -1;
+        }
+        ZSTDSeek_addJumpTableRecord(root->jt, token->compressedPos, token->uncompressedPos);
+        root->jumpTableFirstFrame = token->frame;
+        root->jumpTableFullyInitialized = 0;
+        seeded = 1;
+    }
+
+    ZSTDSeek_getJumpCoordinate(root, pos);
+    size_t frame = ZSTDSeek_frameIndexOfUncompressedPos(root, pos);
+    ZSTDSeek_JumpTableRecord r = root->jt->records[frame];
+    uint32_t checksum;
+    if(root->jumpTableFirstFrame + frame != token->frame || r.compressedPos != token->compressedPos || r.uncompressedPos != token->uncompressedPos || pos > ZSTDSeek_endOfData(root)){
+        DEBUG("The token doesn't match the file\n");
+        goto mismatch;
+    }
+    if(token->checksum != UINT64_MAX && ZSTDSeek_getFrameChecksum(root, frame, &checksum) == 0 && checksum != token->checksum){
+        DEBUG("The checksum of frame %zu doesn't match the token\n", (size_t)token->frame);
+        goto mismatch;
+    }
+
+    if(pos < ZSTDSeek_startOfData(sctx) || pos > ZSTDSeek_endOfData(sctx)){
+        DEBUG("The position of the token is outside the view\n");
+        goto mismatch;
+    }
+    return ZSTDSeek_seek(sctx, (long)(pos - sctx->viewStart), SEEK_SET);
+
+mismatch:
+    if(seeded){
+        root->jt->length = 0;
+        root->jumpTableFirstFrame = firstFrame;
+        root->jumpTableFullyInitialized = fullyInitialized;
+    }
+    return -1;
+}
+
+/* Cache API */
+
+ZSTDSeek_FrameCache* ZSTDSeek_getCache(ZSTDSeek_Context *sctx){
+    return sctx->parent ? sctx->parent->cache : sctx->cache;
+}
+
+/*
+ * The functions of the cache below are called with the mutex held, unless stated otherwise.
+ */
+ZSTDSeek_CacheEntry* ZSTDSeek_cacheLookup(ZSTDSeek_FrameCache *cache, size_t frame){
+    return frame < cache->capacity ? cache->entries[frame] : NULL;
+}
+
+void ZSTDSeek_cacheAppend(ZSTDSeek_CacheList *list, ZSTDSeek_CacheEntry *entry){
+    entry->prev = list->tail;
+    entry->next = NULL;
+    if(list->tail){
+        list->tail->next = entry;
+    }else{
+        list->head = entry;
+    }
+    list->tail = entry;
+}
+
+void ZSTDSeek_cacheUnlink(ZSTDSeek_CacheList *list, ZSTDSeek_CacheEntry *entry){
+    if(entry->prev){
+        entry->prev->next = entry->next;
+    }else{
+        list->head = entry->next;
+    }
+    if(entry->next){
+        entry->next->prev = entry->prev;
+    }else{
+        list->tail = entry->prev;
+    }
+    entry->prev = entry->next = NULL;
+}
+
+/*
+ * The list that contains entry, NULL if it's being decompressed or used.
+ */
+ZSTDSeek_CacheList* ZSTDSeek_cacheListOf(ZSTDSeek_FrameCache *cache, ZSTDSeek_CacheEntry *entry){
+    if(entry->state == CACHE_QUEUED){
+        return &cache->queue;
+    }
+    if(entry->state == CACHE_READY && entry->pins == 0){
+        return &cache->lru;
+    }
+    return NULL;
+}
+
+/*
+ * Mark entry as used, so it can't be evicted, removing it from its list.
+ */
+void ZSTDSeek_cachePin(ZSTDSeek_FrameCache *cache, ZSTDSeek_CacheEntry *entry){
+    ZSTDSeek_CacheList *list = ZSTDSeek_cacheListOf(cache, entry);
+    if(list){
+        ZSTDSeek_cacheUnlink(list, entry);
+    }
+    entry->pins++;
+}
+
+/*
+ * The opposite of ZSTDSeek_cachePin, the entry becomes the most recently used.
+ */
+void ZSTDSeek_cacheUnpin(ZSTDSeek_FrameCache *cache, ZSTDSeek_CacheEntry *entry){
+    entry->pins--;
+    if(entry->pins == 0 && entry->state == CACHE_READY){
+        ZSTDSeek_cacheAppend(&cache->lru, entry);
+    }
+}
+
+void ZSTDSeek_peekRelease(ZSTDSeek_Context *sctx){
+    if(sctx->peekEntry){
+        ZSTDSeek_FrameCache *cache = ZSTDSeek_getCache(sctx);
+        ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+        ZSTDSeek_cacheUnpin(cache, sctx->peekEntry);
+        ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+        sctx->peekEntry = NULL;
+    }
+    sctx->peekSize = 0;
+}
+
+/*
+ * Add a queued entry for frame. Returns 0 on success.
+ */
+int ZSTDSeek_cacheInsert(ZSTDSeek_FrameCache *cache, size_t frame, ZSTDSeek_JumpTableRecord r, ZSTDSeek_JumpTableRecord next){
+    if(frame >= cache->capacity){
+        size_t capacity = cache->capacity ? cache->capacity : 64;
+        while(capacity <= frame){
+            capacity *= 2;
+        }
+        ZSTDSeek_CacheEntry **entries = realloc(cache->entries, capacity * sizeof(ZSTDSeek_CacheEntry *));
+        if(!entries){
+            return -1;
+        }
+        memset(entries + cache->capacity, 0, (capacity - cache->capacity) * sizeof(ZSTDSeek_CacheEntry *));
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+    ZSTDSeek_CacheEntry *entry = calloc(1, sizeof(ZSTDSeek_CacheEntry));
+    if(!entry){
+        return -1;
+    }
+    *entry = (ZSTDSeek_CacheEntry){frame, r.uncompressedPos, next.uncompressedPos - r.uncompressedPos, r.compressedPos,
+                                   next.compressedPos - r.compressedPos, NULL, CACHE_QUEUED, 0, 0, NULL, NULL};
+    cache->entries[frame] = entry;
+    cache->used += entry->size;
+    ZSTDSeek_cacheAppend(&cache->queue, entry);
+    return 0;
+}
+
+void ZSTDSeek_cacheRemove(ZSTDSeek_FrameCache *cache, ZSTDSeek_CacheEntry *entry){
+    ZSTDSeek_CacheList *list = ZSTDSeek_cacheListOf(cache, entry);
+    if(list){
+        ZSTDSeek_cacheUnlink(list, entry);
+    }
+    cache->entries[entry->frame] = NULL;
+    cache->used -= entry->size;
+    free(entry->data);
+    free(entry);
+}
+
+/*
+ * Evict the least recently used frames until size bytes fit in the budget.
+ * The frames queued, being decompressed or read are never evicted. Returns 0 if there is room.
+ */
+int ZSTDSeek_cacheReserve(ZSTDSeek_FrameCache *cache, size_t size){
+    while(cache->used + size > cache->budget){
+        if(!cache->lru.head){
+            return -1;
+        }
+        ZSTDSeek_cacheRemove(cache, cache->lru.head);
+    }
+    return 0;
+}
+
+/*
+ * Decompress entry, without the mutex held. The caller set its state to CACHE_LOADING and pinned it.
+ */
+void ZSTDSeek_cacheLoad(ZSTDSeek_FrameCache *cache, ZSTDSeek_CacheEntry *entry, ZSTD_DCtx *dctx){
+    uint8_t *data = malloc(entry->size);
+    size_t ret = data ? ZSTD_decompressDCtx(dctx, data, entry->size, cache->buff + entry->compressedPos, entry->compressedSize) : 0;
+    int failed = !data || ZSTD_isError(ret) || ret != entry->size;
+    if(failed){
+        DEBUG("Can't decompress frame %zu in the cache\n", entry->frame);
+        free(data);
+        data = NULL;
+    }
+
+    ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+    entry->data = data;
+    entry->failed = failed;
+    entry->state = CACHE_READY;
+    ZSTDSeek_pthread_cond_broadcast(&cache->loaded);
+    ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+}
+
+void* ZSTDSeek_cacheWorker(void *arg){
+    ZSTDSeek_FrameCache *cache = (ZSTDSeek_FrameCache *)arg;
+    ZSTD_DCtx *dctx = ZSTD_createDCtx();
+
+    ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+    while(dctx){
+        //the frames are decompressed in the order they were queued
+        ZSTDSeek_CacheEntry *entry = cache->queue.head;
+        if(cache->stop){
+            break;
+        }
+        if(!entry){
+            ZSTDSeek_pthread_cond_wait(&cache->queued, &cache->mutex);
+            continue;
+        }
+        ZSTDSeek_cachePin(cache, entry);
+        entry->state = CACHE_LOADING;
+        ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+
+        ZSTDSeek_cacheLoad(cache, entry, dctx);
+
+        ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+        ZSTDSeek_cacheUnpin(cache, entry);
+    }
+    ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+
+    ZSTD_freeDCtx(dctx);
+    return NULL;
+}
+
+void ZSTDSeek_freeFrameCache(ZSTDSeek_FrameCache *cache){
+    ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+    cache->stop = 1;
+    ZSTDSeek_pthread_cond_broadcast(&cache->queued);
+    ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+    for(int i = 0; i < cache->nthreads; i++){
+        ZSTDSeek_pthread_join(cache->threads[i], NULL);
+    }
+
+    for(size_t i = 0; i < cache->capacity; i++){
+        if(cache->entries[i]){
+            ZSTDSeek_cacheRemove(cache, cache->entries[i]);
+        }
+    }
+    free(cache->entries);
+    ZSTDSeek_pthread_cond_destroy(&cache->loaded);
+    ZSTDSeek_pthread_cond_destroy(&cache->queued);
+    ZSTDSeek_pthread_mutex_destroy(&cache->mutex);
+    free(cache->threads);
+    free(cache);
+}
+
+int ZSTDSeek_enableFrameCache(ZSTDSeek_Context *sctx, size_t budget, int nthreads){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return -1;
+    }
+    if(sctx->parent){
+        sctx = sctx->parent;
+    }
+
+    if(sctx->cache){
+        if(budget == 0){
+            ZSTDSeek_peekRelease(sctx);
+            ZSTDSeek_freeFrameCache(sctx->cache);
+            sctx->cache = NULL;
+            return 0;
+        }
+        ZSTDSeek_pthread_mutex_lock(&sctx->cache->mutex);
+        sctx->cache->budget = budget;
+        ZSTDSeek_cacheReserve(sctx->cache, 0);
+        ZSTDSeek_pthread_mutex_unlock(&sctx->cache->mutex);
+        return 0;
+    }
+    if(budget == 0){
+        return 0;
+    }
+
+    if(nthreads <= 0){
+        nthreads = ZSTDSeek_defaultNumberOfThreads();
+    }
+    ZSTDSeek_FrameCache *cache = calloc(1, sizeof(ZSTDSeek_FrameCache));
+    if(!cache || !(cache->threads = calloc(nthreads, sizeof(ZSTDSeek_pthread_t)))){
+        free(cache);
+        return -1;
+    }
+    cache->budget = budget;
+    cache->buff = (const uint8_t *)sctx->buff;
+    ZSTDSeek_pthread_mutex_init(&cache->mutex, NULL);
+    ZSTDSeek_pthread_cond_init(&cache->queued, NULL);
+    ZSTDSeek_pthread_cond_init(&cache->loaded, NULL);
+    for(; cache->nthreads < nthreads; cache->nthreads++){
+        if(ZSTDSeek_pthread_create(&cache->threads[cache->nthreads], NULL, ZSTDSeek_cacheWorker, cache) != 0){
+            break;
+        }
+    }
+    if(cache->nthreads == 0){
+        DEBUG("Can't start the threads of the cache\n");
+        ZSTDSeek_freeFrameCache(cache);
+        return -1;
+    }
+
+    sctx->cache = cache;
+    return 0;
+}
+
+int ZSTDSeek_willneed(ZSTDSeek_Context *sctx, size_t offset, size_t length){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return -1;
+    }
+    ZSTDSeek_FrameCache *cache = ZSTDSeek_getCache(sctx);
+    if(!cache){
+        DEBUG("The cache is not enabled\n");
+        return -1;
+    }
+    if(length == 0){
+        return 0;
+    }
+
+    ZSTDSeek_CompressedExtent extent;
+    int ret = ZSTDSeek_getCompressedExtent(sctx, offset, length, &extent);
+    if(ret != 0){
+        return ret;
+    }
+
+#if !defined(_WIN32) && defined(MADV_WILLNEED)
+    //ask the kernel to start reading the compressed frames, the address must be aligned to a page
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if(pageSize > 0){
+        uintptr_t from = (uintptr_t)sctx->buff + extent.compressedPos;
+        uintptr_t aligned = from - from % (uintptr_t)pageSize;
+        madvise((void *)aligned, extent.compressedSize + (from - aligned), MADV_WILLNEED);
+    }
+#endif
+
+    //the jump table is read here, by the thread that owns it, the threads of the cache get only the positions
+    ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+    for(size_t frame = extent.firstFrame; frame <= extent.lastFrame; frame++){
+        ZSTDSeek_JumpTableRecord r = sctx->jt->records[frame];
+        ZSTDSeek_JumpTableRecord next = sctx->jt->records[frame+1];
+        size_t size = next.uncompressedPos - r.uncompressedPos;
+        ZSTDSeek_CacheEntry *entry = ZSTDSeek_cacheLookup(cache, frame);
+        if(entry){
+            if(ZSTDSeek_cacheListOf(cache, entry) == &cache->lru){ //it becomes the most recently used
+                ZSTDSeek_cacheUnlink(&cache->lru, entry);
+                ZSTDSeek_cacheAppend(&cache->lru, entry);
+            }
+            continue;
+        }
+        if(size == 0 || ZSTDSeek_cacheReserve(cache, size) != 0){
+            continue;
+        }
+        if(ZSTDSeek_cacheInsert(cache, frame, r, next) != 0){
+            break;
+        }
+    }
+    ZSTDSeek_pthread_cond_broadcast(&cache->queued);
+    ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+    return 0;
+}
+
+size_t ZSTDSeek_cancelWillneed(ZSTDSeek_Context *sctx){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return 0;
+    }
+    ZSTDSeek_FrameCache *cache = ZSTDSeek_getCache(sctx);
+    if(!cache){
+        return 0;
+    }
+
+    size_t cancelled = 0;
+    ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+    while(cache->queue.head){
+        ZSTDSeek_cacheRemove(cache, cache->queue.head);
+        cancelled++;
+    }
+    ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+    return cancelled;
+}
+
+/*
+ * Copy the data at the current position from the frames in the cache, up until the first frame not in the cache.
+ * A frame still queued is decompressed here, one being decompressed by the cache is waited for.
+ * Returns the number of bytes copied.
+ */
+size_t ZSTDSeek_readFromCache(ZSTDSeek_FrameCache *cache, void *outBuff, size_t toRead, ZSTDSeek_Context *sctx, size_t *lastAccessedFrame){
+    size_t copied = 0;
+    while(copied < toRead){
+        size_t frame = ZSTDSeek_frameIndexOfUncompressedPos(sctx, sctx->currentUncompressedPos);
+
+        ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+        ZSTDSeek_CacheEntry *entry = ZSTDSeek_cacheLookup(cache, frame);
+        if(!entry){
+            ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+            break;
+        }
+        ZSTDSeek_cachePin(cache, entry);
+        if(entry->state == CACHE_QUEUED){
+            entry->state = CACHE_LOADING;
+            ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+            ZSTDSeek_cacheLoad(cache, entry, sctx->dctx);
+            sctx->decoderStale = 1; //the decoder lost its state
+            ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+        }
+        while(entry->state == CACHE_LOADING){
+            ZSTDSeek_pthread_cond_wait(&cache->loaded, &cache->mutex);
+        }
+        int failed = entry->failed;
+        ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+
+        if(!failed){
+            size_t offset = sctx->currentUncompressedPos - entry->uncompressedPos;
+            size_t toCopy = entry->size - offset < toRead - copied ? entry->size - offset : toRead - copied;
+            memcpy((uint8_t *)outBuff + copied, entry->data + offset, toCopy);
+            copied += toCopy;
+            sctx->currentUncompressedPos += toCopy;
+            sctx->decoderStale = 1;
+            if(sctx->statsEnabled){
+                sctx->statsFrame = frame;
+                ZSTDSeek_recordReturnedBytes(sctx, toCopy, lastAccessedFrame);
+            }
+        }
+
+        ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+        ZSTDSeek_cacheUnpin(cache, entry);
+        ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+        if(failed){
+            break;
+        }
+    }
+    return copied;
+}
+
+uint64_t ZSTDSeek_monotonicTime(){
+#ifdef _WIN32
+    return (uint64_t)GetTickCount64()*1000000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+int ZSTDSeek_budgetExpired(const ZSTDSeek_ReadBudget *budget, size_t decodedBytes){
+    return (budget->maxDecodedBytes && decodedBytes >= budget->maxDecodedBytes) ||
+           (budget->deadline && ZSTDSeek_monotonicTime() >= budget->deadline);
+}
+
+size_t ZSTDSeek_read(void *outBuff, size_t outBuffSize, ZSTDSeek_Context *sctx){
+    return ZSTDSeek_boundedRead(outBuff, outBuffSize, sctx, NULL, NULL);
+}
+
+size_t ZSTDSeek_boundedRead(void *outBuff, size_t outBuffSize, ZSTDSeek_Context *sctx, const ZSTDSeek_ReadBudget *budget, ZSTDSeek_ReadProgress *progress){
+    if(progress){
+        *progress = (ZSTDSeek_ReadProgress){0, 0};
+    }
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return 0;
+    }
+    ZSTDSeek_peekRelease(sctx);
+    
+    ZSTDSeek_JumpCoordinate localJc = ZSTDSeek_getJumpCoordinate(sctx, sctx->currentUncompressedPos); //trigger the generation of a jump table record, if needed
+    if(localJc.compressedOffset == ZSTDSEEK_INVALID_OFFSET){
+        return ZSTDSEEK_ERR_READ;
+    }
+    sctx->currentCompressedPos = localJc.jtr.compressedPos;
+
+    size_t maxReadable = ZSTDSeek_endOfData(sctx) - sctx->currentUncompressedPos;
+    size_t toRead = maxReadable < outBuffSize ? maxReadable : outBuffSize;
+    size_t shouldRead = toRead;
+    size_t lastAccessedFrame = SIZE_MAX; //used to count an access only once per frame and per read
+    size_t decodedBytes = 0;
+    int expired = 0;
+
+    ZSTDSeek_FrameCache *cache = ZSTDSeek_getCache(sctx);
+    if(cache && toRead > 0){
+        size_t copied = ZSTDSeek_readFromCache(cache, outBuff, toRead, sctx, &lastAccessedFrame);
+        toRead -= copied;
+        outBuff = (uint8_t *)outBuff + copied;
+    }
+    if(sctx->decoderStale && toRead > 0){
+        ZSTDSeek_resetDecoder(sctx, ZSTDSeek_getJumpCoordinate(sctx, sctx->currentUncompressedPos), sctx->currentUncompressedPos);
+    }
+
+    if(sctx->tmpOutBuffPos < sctx->output.pos){
+        if(sctx->jc.uncompressedOffset > sctx->output.pos){
+            sctx->jc.uncompressedOffset -= sctx->output.pos;
+        }else{
+            size_t maxCopy = (sctx->output.pos - sctx->tmpOutBuffPos) - sctx->jc.uncompressedOffset;
+            size_t toCopy = maxCopy < toRead ? maxCopy : toRead;
+
+            memcpy(outBuff, sctx->tmpOutBuff+sctx->tmpOutBuffPos+sctx->jc.uncompressedOffset, toCopy);
+            if(sctx->statsEnabled){
+                ZSTDSeek_recordReturnedBytes(sctx, toCopy, &lastAccessedFrame);
+            }
+            toRead -= toCopy;
+            outBuff = (uint8_t *)outBuff + toCopy;
+            sctx->currentUncompressedPos += toCopy;
+            sctx->tmpOutBuffPos += toCopy + sctx->jc.uncompressedOffset;
+            sctx->jc.uncompressedOffset = 0;
+        }
+    }
+
+    while (toRead > 0 && ((sctx->input.pos < sctx->input.size) || (sctx->lastFrameCompressedSize = ZSTD_findFrameCompressedSize(sctx->inBuff, sctx->size)) > 0)){
+        if(sctx->input.pos == sctx->input.size){
+            sctx->input = (ZSTD_inBuffer){sctx->inBuff, sctx->lastFrameCompressedSize, 0};
+            if(sctx->statsEnabled){
+                sctx->statsFrame = ZSTDSeek_frameIndexOfCompressedPos(sctx, sctx->inBuff - (uint8_t *)sctx->buff);
+            }
+        }
+
+        while (sctx->input.pos < sctx->input.size) {
+            sctx->output = (ZSTD_outBuffer){ sctx->tmpOutBuff, sctx->tmpOutBuffSize, 0 };
+            sctx->tmpOutBuffPos = 0;
+            size_t const ret = ZSTD_decompressStream(sctx->dctx, &sctx->output , &sctx->input);
+
+            if(ZSTD_isError(ret)){
+                DEBUG("Error decompressing: %s\n", ZSTD_getErrorName(ret));
+                return ZSTDSEEK_ERR_READ;
+            }
+
+            sctx->currentCompressedPos += sctx->input.pos;
+
+            if(sctx->statsEnabled){
+                ZSTDSeek_FrameAccessStats *fas = ZSTDSeek_getFrameAccessStats(sctx, sctx->statsFrame);
+                if(fas){
+                    fas->decodedBytes += sctx->output.pos;
+                }
+            }
+            decodedBytes += sctx->output.pos;
+
+            if(sctx->jc.uncompressedOffset > sctx->output.pos){
+                sctx->jc.uncompressedOffset -= sctx->output.pos;
+                sctx->tmpOutBuffPos = sctx->output.pos; //all skipped, nothing left for the next read
+            }else{
+                size_t maxCopy = (sctx->output.pos - sctx->tmpOutBuffPos) - sctx->jc.uncompressedOffset;
+                size_t toCopy = maxCopy < toRead ? maxCopy : toRead;
+
+                memcpy(outBuff, sctx->tmpOutBuff+sctx->tmpOutBuffPos+sctx->jc.uncompressedOffset, toCopy);
+                if(sctx->statsEnabled){
+                    ZSTDSeek_recordReturnedBytes(sctx, toCopy, &lastAccessedFrame);
+                }
+                toRead -= toCopy;
+                outBuff = (uint8_t *)outBuff + toCopy;
+                sctx->currentUncompressedPos += toCopy;
+                sctx->tmpOutBuffPos += toCopy + sctx->jc.uncompressedOffset;
+                sctx->jc.uncompressedOffset = 0;
+            }
+
+            if(toRead == 0){
+                break;
+            }
+            if(budget && ZSTDSeek_budgetExpired(budget, decodedBytes)){ //the state is consistent between two steps, the next read resumes from here
+                expired = 1;
+                break;
+            }
+        }
+
+        if(sctx->input.pos == sctx->input.size){ //end of frame
+            sctx->inBuff+=sctx->lastFrameCompressedSize;
+        }
+
+        if(toRead == 0 || expired){
+            break;
+        }
+    }
+
+    if(progress){
+        *progress = (ZSTDSeek_ReadProgress){decodedBytes, expired};
+    }
+    return shouldRead - toRead;
+}
+
+/*
+ * Decompress until there is data at the current position in tmpOutBuff, like read without copying it.
+ * The current position must be before the end of the data.
+ * Returns the bytes available from tmpOutBuff+tmpOutBuffPos, ZSTDSEEK_ERR_READ in case of failure.
+ */
+size_t ZSTDSeek_fillOutput(ZSTDSeek_Context *sctx){
+    if(sctx->decoderStale){
+        ZSTDSeek_JumpCoordinate jc = ZSTDSeek_getJumpCoordinate(sctx, sctx->currentUncompressedPos);
+        if(jc.compressedOffset == ZSTDSEEK_INVALID_OFFSET){
+            return ZSTDSEEK_ERR_READ;
+        }
+        ZSTDSeek_resetDecoder(sctx, jc, sctx->currentUncompressedPos);
+    }
+
+    while(sctx->tmpOutBuffPos >= sctx->output.pos){
+        if(sctx->input.pos == sctx->input.size){
+            sctx->lastFrameCompressedSize = ZSTD_findFrameCompressedSize(sctx->inBuff, sctx->size);
+            if(ZSTD_isError(sctx->lastFrameCompressedSize)){
+                DEBUG("Error decompressing: %s\n", ZSTD_getErrorName(sctx->lastFrameCompressedSize));
+                return ZSTDSEEK_ERR_READ;
+            }
+            sctx->input = (ZSTD_inBuffer){sctx->inBuff, sctx->lastFrameCompressedSize, 0};
+            if(sctx->statsEnabled){
+                sctx->statsFrame = ZSTDSeek_frameIndexOfCompressedPos(sctx, sctx->inBuff - (uint8_t *)sctx->buff);
+            }
+        }
+
+        sctx->output = (ZSTD_outBuffer){ sctx->tmpOutBuff, sctx->tmpOutBuffSize, 0 };
+        sctx->tmpOutBuffPos = 0;
+        size_t const ret = ZSTD_decompressStream(sctx->dctx, &sctx->output , &sctx->input);
+        if(ZSTD_isError(ret)){
+            DEBUG("Error decompressing: %s\n", ZSTD_getErrorName(ret));
+            return ZSTDSEEK_ERR_READ;
+        }
+
+        sctx->currentCompressedPos += sctx->input.pos;
+        if(sctx->statsEnabled){
+            ZSTDSeek_FrameAccessStats *fas = ZSTDSeek_getFrameAccessStats(sctx, sctx->statsFrame);
+            if(fas){
+                fas->decodedBytes += sctx->output.pos;
+            }
+        }
+        if(sctx->input.pos == sctx->input.size){ //end of frame
+            sctx->inBuff += sctx->lastFrameCompressedSize;
+        }
+
+        if(sctx->jc.uncompressedOffset >= sctx->output.pos){ //all skipped
+            sctx->jc.uncompressedOffset -= sctx->output.pos;
+            sctx->tmpOutBuffPos = sctx->output.pos;
+        }else{
+            sctx->tmpOutBuffPos = sctx->jc.uncompressedOffset;
+            sctx->jc.uncompressedOffset = 0;
+        }
+    }
+    return sctx->output.pos - sctx->tmpOutBuffPos;
+}
+
+int ZSTDSeek_peek(ZSTDSeek_Context *sctx, const void **data, size_t *size){
+    if(!sctx || !data || !size){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+    ZSTDSeek_peekRelease(sctx);
+
+    if(ZSTDSeek_getJumpCoordinate(sctx, sctx->currentUncompressedPos).compressedOffset == ZSTDSEEK_INVALID_OFFSET){ //trigger the generation of a jump table record, if needed
+        return -1;
+    }
+    size_t maxReadable = ZSTDSeek_endOfData(sctx) - sctx->currentUncompressedPos;
+    if(maxReadable == 0){
+        *size = 0;
+        return 0;
+    }
+
+    //the whole frame, if it's in the cache
+    ZSTDSeek_FrameCache *cache = ZSTDSeek_getCache(sctx);
+    if(cache){
+        size_t frame = ZSTDSeek_frameIndexOfUncompressedPos(sctx, sctx->currentUncompressedPos);
+        ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+        ZSTDSeek_CacheEntry *entry = ZSTDSeek_cacheLookup(cache, frame);
+        if(entry){
+            ZSTDSeek_cachePin(cache, entry);
+            if(entry->state == CACHE_QUEUED){
+                entry->state = CACHE_LOADING;
+                ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+                ZSTDSeek_cacheLoad(cache, entry, sctx->dctx);
+                sctx->decoderStale = 1; //the decoder lost its state
+                ZSTDSeek_pthread_mutex_lock(&cache->mutex);
+            }
+            while(entry->state == CACHE_LOADING){
+                ZSTDSeek_pthread_cond_wait(&cache->loaded, &cache->mutex);
+            }
+            if(entry->failed){
+                ZSTDSeek_cacheUnpin(cache, entry);
+                entry = NULL;
+            }
+        }
+        ZSTDSeek_pthread_mutex_unlock(&cache->mutex);
+
+        if(entry){
+            size_t offset = sctx->currentUncompressedPos - entry->uncompressedPos;
+            sctx->peekEntry = entry;
+            sctx->peekSize = entry->size - offset < maxReadable ? entry->size - offset : maxReadable;
+            *data = entry->data + offset;
+            *size = sctx->peekSize;
+            if(sctx->statsEnabled){
+                sctx->statsFrame = frame;
+            }
+            return 1;
+        }
+    }
+
+    size_t available = ZSTDSeek_fillOutput(sctx);
+    if(available == (size_t)ZSTDSEEK_ERR_READ){
+        return -1;
+    }
+    sctx->peekSize = available < maxReadable ? available : maxReadable;
+    *data = sctx->tmpOutBuff + sctx->tmpOutBuffPos;
+    *size = sctx->peekSize;
+    return 1;
+}
+
+int ZSTDSeek_consume(ZSTDSeek_Context *sctx, size_t n){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return -1;
+    }
+    if(n > sctx->peekSize){
+        DEBUG("Consuming more than the data returned by peek\n");
+        return -1;
+    }
+
+    if(sctx->peekEntry){
+        sctx->decoderStale = 1; //the decoder stays where it was, it's moved by the next read that needs it
+    }else{
+        sctx->tmpOutBuffPos += n;
+    }
+    sctx->currentUncompressedPos += n;
+    if(sctx->statsEnabled){
+        size_t lastAccessedFrame = SIZE_MAX;
+        ZSTDSeek_recordReturnedBytes(sctx, n, &lastAccessedFrame);
+    }
+    ZSTDSeek_peekRelease(sctx);
+    return 0;
+}
+
+int ZSTDSeek_boundedSeek(ZSTDSeek_Context *sctx, size_t offset, const ZSTDSeek_ReadBudget *budget, ZSTDSeek_ReadProgress *progress){
+    if(progress){
+        *progress = (ZSTDSeek_ReadProgress){0, 0};
+    }
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return -1;
+    }
+
+    size_t target = offset + sctx->viewStart;
+    if(target <= sctx->currentUncompressedPos || !budget){
+        return ZSTDSeek_seek(sctx, (long)offset, SEEK_SET);
+    }
+    ZSTDSeek_JumpCoordinate new_jc = ZSTDSeek_getJumpCoordinate(sctx, target);
+    if(sctx->jc.compressedOffset != new_jc.compressedOffset || target > ZSTDSeek_endOfData(sctx)){ //nothing to decompress here
+        return ZSTDSeek_seek(sctx, (long)offset, SEEK_SET);
+    }
+
+    //move forward in the current frame reading within the budget, what's left is the budget of the next read
+    size_t const buffOutSize = ZSTD_DStreamOutSize();
+    void*  const buffOut = malloc(buffOutSize);
+    if(!buffOut){
+        return -1;
+    }
+    ZSTDSeek_ReadBudget left = *budget;
+    ZSTDSeek_ReadProgress step = {0, 0};
+    size_t decodedBytes = 0;
+    int ret = 0;
+    sctx->statsSkipping = 1;
+    while(sctx->currentUncompressedPos < target && !step.expired){
+        if(budget->maxDecodedBytes){
+            if(decodedBytes >= budget->maxDecodedBytes){
+                step.expired = 1;
+                break;
+            }
+            left.maxDecodedBytes = budget->maxDecodedBytes - decodedBytes;
+        }
+        size_t toSkip = target - sctx->currentUncompressedPos;
+        size_t len = ZSTDSeek_boundedRead(buffOut, buffOutSize < toSkip ? buffOutSize : toSkip, sctx, &left, &step);
+        decodedBytes += step.decodedBytes;
+        if(len == (size_t)ZSTDSEEK_ERR_READ || (len == 0 && !step.expired)){
+            ret = -1;
+            break;
+        }
+    }
+    sctx->statsSkipping = 0;
+    free(buffOut);
+
+    if(progress){
+        *progress = (ZSTDSeek_ReadProgress){decodedBytes, step.expired};
+    }
+    return ret;
+}
+
+int ZSTDSeek_estimateReadCost(ZSTDSeek_Context *sctx, size_t offset, size_t length, ZSTDSeek_ReadCost *cost){
+    if(!sctx || !cost){
+        DEBUG("Invalid argument\n");
+        return -1;
+    }
+
+    *cost = (ZSTDSeek_ReadCost){0, 0, 0};
+    if(length == 0){
+        return 0;
+    }
+    ZSTDSeek_CompressedExtent extent;
+    int ret = ZSTDSeek_getCompressedExtent(sctx, offset, length, &extent);
+    if(ret != 0){
+        return ret;
+    }
+
+    //like ZSTDSeek_seek, going forward in the current frame continues from the current position, otherwise the frame is decompressed from its beginning
+    size_t target = offset + sctx->viewStart;
+    size_t before = extent.skip;
+    if(target >= sctx->currentUncompressedPos && sctx->jc.compressedOffset == ZSTDSeek_getJumpCoordinate(sctx, target).compressedOffset){
+        before = target - sctx->currentUncompressedPos;
+    }
+    *cost = (ZSTDSeek_ReadCost){before + length, extent.compressedSize, extent.lastFrame - extent.firstFrame + 1};
+    return 0;
+}
+
+int ZSTDSeek_seek(ZSTDSeek_Context *sctx, long offset, int origin){
+    if(!sctx){
+        DEBUG("ZSTDSeek_Context is NULL\n");
+        return -1;
+    }
+    ZSTDSeek_peekRelease(sctx);
+    if(origin == SEEK_CUR){
+        if(offset==0){
+            return 0;
+        }
+        offset = ZSTDSeek_tell(sctx) + offset;
+        origin = SEEK_SET;
+    }else if(origin == SEEK_END){
+        offset = (long)ZSTDSeek_uncompressedFileSize(sctx) + offset;
+        origin = SEEK_SET;
+    }
+    if(origin == SEEK_SET){
         if(offset < 0){
             DEBUG("Negative seek\n");
             return ZSTDSEEK_ERR_NEGATIVE_SEEK;
-        }else if(offset > 0){
+        }
+        offset += (long)sctx->viewStart; //views are positioned in the coordinates of the jump table
+        if((size_t)offset < ZSTDSeek_startOfData(sctx)){
+            DEBUG("Seek before the frame the context was resumed from\n");
+            return ZSTDSEEK_ERR_NEGATIVE_SEEK;
+        }
+        if(offset > 0){
             ZSTDSeek_getJumpCoordinate(sctx, sctx->currentUncompressedPos+offset); //trigger an update of the lastKnownUncompressedFileSize
-            if(offset > ZSTDSeek_lastKnownUncompressedFileSize(sctx)){
+            if(offset > ZSTDSeek_endOfData(sctx)){
                 DEBUG("Seek to a frame beyond the buffer length\n");
                 return ZSTDSEEK_ERR_BEYOND_END_SEEK;
             }
@@ -525,28 +2341,20 @@ int ZSTDSeek_seek(ZSTDSeek_Context *sctx, long offset, int origin){
 
         ZSTDSeek_JumpCoordinate new_jc = ZSTDSeek_getJumpCoordinate(sctx, offset);
 
-        if(sctx->jc.compressedOffset != new_jc.compressedOffset || offset < sctx->currentUncompressedPos){ //reset
-            ZSTD_DCtx_reset(sctx->dctx, ZSTD_reset_session_only);
-
-            sctx->jc = new_jc;
-
-            sctx->inBuff = (uint8_t *)sctx->buff + sctx->jc.compressedOffset; //jump to the beginning of the frame..
-            sctx->currentUncompressedPos = offset; //..and adjust the uncompressed position..
-            sctx->currentCompressedPos = sctx->jc.compressedOffset;
-            sctx->tmpOutBuffPos = 0; //..and reset the position in the tmp buffer
-            sctx->input = (ZSTD_inBuffer){sctx->inBuff, 0, 0};
-            sctx->output = (ZSTD_outBuffer){sctx->tmpOutBuff, 0, 0};
-
+        if(sctx->jc.compressedOffset != new_jc.compressedOffset || offset < sctx->currentUncompressedPos || sctx->decoderStale){ //reset
+            ZSTDSeek_resetDecoder(sctx, new_jc, offset);
         }else{ //move forward
             size_t toSkipTotal = offset - sctx->currentUncompressedPos;
 
             size_t const buffOutSize = ZSTD_DStreamOutSize();
             void*  const buffOut = malloc(buffOutSize);
 
+            sctx->statsSkipping = 1;
             while(toSkipTotal>0){
                 size_t toSkip = buffOutSize < toSkipTotal ? buffOutSize : toSkipTotal;
                 toSkipTotal -= ZSTDSeek_read(buffOut, toSkip, sctx);
             }
+            sctx->statsSkipping = 0;
 
             free(buffOut);
         }
@@ -564,7 +2372,7 @@ long ZSTDSeek_tell(ZSTDSeek_Context *sctx){
         return -1;
     }
 
-    return sctx->currentUncompressedPos;
+    return sctx->currentUncompressedPos - sctx->viewStart;
 }
 
 long ZSTDSeek_compressedTell(ZSTDSeek_Context *sctx){
@@ -582,6 +2390,10 @@ size_t ZSTDSeek_uncompressedFileSize(ZSTDSeek_Context *sctx){
         return 0;
     }
 
+    if(sctx->parent){
+        return sctx->viewLength;
+    }
+
     ZSTDSeek_initializeJumpTable(sctx);
 
     return ZSTDSeek_lastKnownUncompressedFileSize(sctx);
@@ -593,6 +2405,10 @@ size_t ZSTDSeek_lastKnownUncompressedFileSize(ZSTDSeek_Context *sctx){
         return 0;
     }
 
+    if(sctx->parent){
+        return sctx->viewLength;
+    }
+
     return sctx->jt->length > 0 ? sctx->jt->records[sctx->jt->length-1].uncompressedPos : 0;
 }
 
@@ -638,11 +2454,19 @@ void ZSTDSeek_free(ZSTDSeek_Context *sctx){
         return;
     }
 
+    ZSTDSeek_peekRelease(sctx);
+
+    if(sctx->cache){ //the threads of the cache read the compressed data
+        ZSTDSeek_freeFrameCache(sctx->cache);
+    }
+
     if(sctx->dctx){
         ZSTD_freeDCtx(sctx->dctx);
     }
 
-    ZSTDSeek_freeJumpTable(sctx->jt);
+    if(!sctx->parent){ //views share the jump table of the parent
+        ZSTDSeek_freeJumpTable(sctx->jt);
+    }
 
     if(sctx->mmap_fd>=0 && sctx->close_fd){
         munmap(sctx->buff, sctx->size);
@@ -650,6 +2474,7 @@ void ZSTDSeek_free(ZSTDSeek_Context *sctx){
     }
 
     free(sctx->tmpOutBuff);
+    free(sctx->stats);
 
     free(sctx);
 }
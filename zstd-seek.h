@@ -17,6 +17,7 @@ extern "C" {
 #endif
 
 #include <stdio.h>
+#include <stdint.h>
 #include <zstd.h>
 
 #ifndef _ZSTD_SEEK_DEBUG_
@@ -47,6 +48,11 @@ do { \
 #define ZSTD_SEEKABLE_MAGICNUMBER 0x8F92EAB1
 #define ZSTD_SKIPPABLE_HEADER_SIZE 8
 
+/* Resume token constants */
+#define ZSTDSEEK_RESUME_TOKEN_MAGICNUMBER 0x5452535A //"ZSRT"
+#define ZSTDSEEK_RESUME_TOKEN_VERSION 1
+#define ZSTDSEEK_RESUME_TOKEN_ENCODED_SIZE 72 //the size of an encoded resume token
+
 /* Structs */
 
 typedef struct{
@@ -60,8 +66,70 @@ typedef struct{
     uint64_t capacity;
 } ZSTDSeek_JumpTable;
 
+typedef struct{
+    size_t compressedPos;  //where the first frame covering the range begins in the compressed stream
+    size_t compressedSize; //the length of the frames covering the range, they can be sent as they are
+    size_t firstFrame;     //the index of the first frame covering the range
+    size_t lastFrame;      //the index of the last frame covering the range
+    size_t skip;           //how many uncompressed bytes to discard at the beginning of the first frame
+    size_t trim;           //how many uncompressed bytes to discard at the end of the last frame
+} ZSTDSeek_CompressedExtent;
+
+typedef struct{
+    uint64_t fileSize;        //the size of the compressed file
+    uint64_t fileHash;        //a hash of the beginning and the end of the compressed file
+    uint64_t frame;           //the frame of the position, as numbered in the jump table of the whole file
+    uint64_t compressedPos;   //where the frame begins in the compressed file
+    uint64_t uncompressedPos; //where the frame begins in the uncompressed data
+    uint64_t offset;          //the position in the frame
+    uint64_t checksum;        //the checksum of the frame as returned by ZSTDSeek_getFrameChecksum, UINT64_MAX if it has none
+} ZSTDSeek_ResumeToken;
+
+typedef struct{
+    uint64_t deadline;       //when to stop, in nanoseconds as returned by ZSTDSeek_monotonicTime, 0 for no deadline
+    size_t maxDecodedBytes;  //how many bytes can be decompressed, 0 for no limit
+} ZSTDSeek_ReadBudget;
+
+typedef struct{
+    size_t decodedBytes;     //the bytes decompressed, including the ones decoded only to reach the position
+    int expired;             //1 if the budget ran out before the end of the request, call again to resume
+} ZSTDSeek_ReadProgress;
+
+typedef struct{
+    size_t decodedBytes;     //the bytes to decompress, including the ones before the position in its frame
+    size_t compressedBytes;  //the length of the frames to read
+    size_t frames;           //the number of frames
+} ZSTDSeek_ReadCost;
+
+typedef struct{
+    uint64_t accesses;     //number of reads that returned data from this frame
+    uint64_t decodedBytes; //bytes decompressed from this frame, including the ones decoded only to reach the requested position
+    uint64_t returnedBytes;//bytes of this frame returned to the caller
+} ZSTDSeek_FrameAccessStats;
+
 typedef struct ZSTDSeek_Context_s ZSTDSeek_Context;
 
+/*
+ * Called by ZSTDSeek_forEachFrameParallel with the uncompressed data of a frame.
+ * data is owned by the library and it's valid only until the callback returns.
+ * uncompressedPos is the position of data in the uncompressed file, frame is the index of the frame in the jump table.
+ * Return 0 to continue, anything else to stop.
+ */
+typedef int (*ZSTDSeek_FrameCallback)(const void *data, size_t size, size_t uncompressedPos, size_t frame, void *user);
+
+/*
+ * Called by ZSTDSeek_mapReduceFramesParallel with the uncompressed data of a frame, like ZSTDSeek_FrameCallback.
+ * Set result to what has to be passed to ZSTDSeek_ReduceCallback for this frame, NULL or allocated with malloc.
+ * Return 0 to continue, anything else to stop.
+ */
+typedef int (*ZSTDSeek_MapCallback)(const void *data, size_t size, size_t uncompressedPos, size_t frame, void **result, void *user);
+
+/*
+ * Called by ZSTDSeek_mapReduceFramesParallel with the result of ZSTDSeek_MapCallback for each frame, in the order of the file.
+ * It owns result. Return 0 to continue, anything else to stop.
+ */
+typedef int (*ZSTDSeek_ReduceCallback)(void *result, size_t uncompressedPos, size_t frame, void *user);
+
 /* Jump Table API */
 
 /*
@@ -156,12 +224,53 @@ ZSTDSeek_Context* ZSTDSeek_createFromFileDescriptorWithoutJumpTable(int fd);
  */
 ZSTDSeek_Context* ZSTDSeek_createFromFileDescriptor(int fd);
 
+/*
+ * Create a view of length bytes of the uncompressed data of sctx starting at start.
+ * The view is a ZSTDSeek_Context where read, seek, tell and the file size are relative to the slice, so it can be handed to
+ * code that expects a whole file, eg a member of an archive.
+ * It shares the buffer and the jump table of sctx, nothing is copied and no index is built,
+ * but it has its own position and decoder so it can be used along with sctx and other views.
+ * The jump table returned by ZSTDSeek_getJumpTableOfContext is the one of sctx, see ZSTDSeek_getViewStart.
+ * sctx must outlive the view. To use views from other threads initialize the jump table of sctx first.
+ * Free it with ZSTDSeek_free.
+ * Returns 0 in case of failure.
+ */
+ZSTDSeek_Context* ZSTDSeek_createView(ZSTDSeek_Context *sctx, size_t start, size_t length);
+
+/*
+ * Move a view created by ZSTDSeek_createView to another slice of the same parent, reusing its decoder.
+ * start is a position in the uncompressed file of the parent, ie in the coordinates of the jump table.
+ * The slice must be within the part of the file already covered by the jump table of the parent.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_moveView(ZSTDSeek_Context *view, size_t start, size_t length);
+
+/*
+ * Returns the position of the view in the uncompressed file of its parent, 0 if sctx is not a view.
+ */
+size_t ZSTDSeek_getViewStart(ZSTDSeek_Context *sctx);
+
 /*
  * It reads outBuffSize bytes of uncompressed data from the sctx context buffer into outBuff.
  * Returns the number of bytes read.
  */
 size_t ZSTDSeek_read(void *outBuff, size_t outBuffSize, ZSTDSeek_Context *sctx);
 
+/*
+ * Get the data at the current position without copying it, eg to scan it: data points to the decode buffer of sctx,
+ * or to the whole frame if it's in the cache, see ZSTDSeek_enableFrameCache.
+ * The position doesn't change, use ZSTDSeek_consume to move forward. data is valid until the next call to peek,
+ * consume, read or seek on sctx.
+ * Returns 1 on success, 0 at the end of the data, -1 in case of failure.
+ */
+int ZSTDSeek_peek(ZSTDSeek_Context *sctx, const void **data, size_t *size);
+
+/*
+ * Move forward n bytes of the data returned by the last call to ZSTDSeek_peek, at most its size.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_consume(ZSTDSeek_Context *sctx, size_t n);
+
 /*
  * Like fseek.
  * Origin can be SEEK_SET, SEEK_END or SEEK_CUR.
@@ -207,6 +316,180 @@ size_t ZSTDSeek_getNumberOfFrames(ZSTDSeek_Context *sctx);
  */
 int ZSTDSeek_isMultiframe(ZSTDSeek_Context *sctx);
 
+/* Bounded read API */
+
+/*
+ * Returns a monotonic time in nanoseconds, to set ZSTDSeek_ReadBudget.deadline, eg ZSTDSeek_monotonicTime() + 2000000 for 2ms from now.
+ */
+uint64_t ZSTDSeek_monotonicTime();
+
+/*
+ * Like ZSTDSeek_read, but it stops when the budget runs out, checking it after each step of the decoder, ie every ZSTD_DStreamOutSize() bytes at most.
+ * The bytes decoded to reach the position aren't lost: the state is kept in sctx and calling it again resumes from there.
+ * progress, if not NULL, is set to what has been done, progress->expired tells if the read stopped early.
+ * Returns the number of bytes read, they can be less than outBuffSize even if the end of the file hasn't been reached.
+ */
+size_t ZSTDSeek_boundedRead(void *outBuff, size_t outBuffSize, ZSTDSeek_Context *sctx, const ZSTDSeek_ReadBudget *budget, ZSTDSeek_ReadProgress *progress);
+
+/*
+ * Like ZSTDSeek_seek with SEEK_SET, but it stops when the budget runs out.
+ * ZSTDSeek_seek decompresses the data up until offset only when moving forward in the current frame, here that's done within the budget
+ * and if it expires the same call can be repeated to resume. In the other cases the data is decompressed by the following read.
+ * Returns 0 if seek was successfull, even if expired.
+ */
+int ZSTDSeek_boundedSeek(ZSTDSeek_Context *sctx, size_t offset, const ZSTDSeek_ReadBudget *budget, ZSTDSeek_ReadProgress *progress);
+
+/*
+ * Estimate the cost of reading length bytes from offset, from the current state of sctx and the jump table, without decompressing anything.
+ * It can be used to defer or refuse expensive reads.
+ * Returns 0 on success, ZSTDSEEK_ERR_BEYOND_END_SEEK if the range goes beyond the end of the file,
+ * ZSTDSEEK_ERR_NEGATIVE_SEEK if it begins before the frame the context was resumed from.
+ */
+int ZSTDSeek_estimateReadCost(ZSTDSeek_Context *sctx, size_t offset, size_t length, ZSTDSeek_ReadCost *cost);
+
+/* Resume API */
+
+/*
+ * Get a token of the current position, to save it as a checkpoint, eg after processing a batch of records.
+ * It identifies the file and holds the frame of the position, where it begins and the offset in it,
+ * so a process restarted after a crash can go back there without the jump table, see ZSTDSeek_seekToResumeToken.
+ * The decoding state of zstd can't be saved, so the frame is decompressed again from its beginning up to the offset.
+ * For a view the position is the one in the file.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_getResumeToken(ZSTDSeek_Context *sctx, ZSTDSeek_ResumeToken *token);
+
+/*
+ * Encode token in ZSTDSEEK_RESUME_TOKEN_ENCODED_SIZE bytes, independent of the platform.
+ */
+void ZSTDSeek_encodeResumeToken(const ZSTDSeek_ResumeToken *token, uint8_t *buff);
+
+/*
+ * Decode a token encoded with ZSTDSeek_encodeResumeToken. Returns 0 on success.
+ */
+int ZSTDSeek_decodeResumeToken(const uint8_t *buff, size_t size, ZSTDSeek_ResumeToken *token);
+
+/*
+ * Seek to the position of token, after checking that it's a token of the same file and of the same frame.
+ * On a context created without the jump table and not read yet, eg with ZSTDSeek_createFromFileWithoutJumpTable,
+ * the jump table starts from the frame of the token, so the frames before it are never parsed, not even the seek table.
+ * Such a context can't seek before that frame and numbers the frames from it, tokens taken from it are still of the whole file.
+ * Returns 0 on success, -1 if the token doesn't match the file.
+ */
+int ZSTDSeek_seekToResumeToken(ZSTDSeek_Context *sctx, const ZSTDSeek_ResumeToken *token);
+
+/* Cache API */
+
+/*
+ * Enable a cache of up to budget bytes of decompressed frames, filled by ZSTDSeek_willneed on nthreads threads (<= 0 means one per CPU).
+ * The cache is shared with the views, if sctx is a view it's enabled on its parent.
+ * Reads copy the frames in the cache instead of decompressing them, when it's full the least recently used frames are evicted.
+ * Calling it again changes the budget, 0 disables the cache. Don't disable it while views are used from other threads.
+ * Returns 0 on success, -1 in case of failure, eg on Windows where the threads of the cache are not supported.
+ */
+int ZSTDSeek_enableFrameCache(ZSTDSeek_Context *sctx, size_t budget, int nthreads);
+
+/*
+ * Hint that length bytes from offset will be read soon, eg by a query planner.
+ * It returns immediately: the kernel is asked to load the compressed frames covering the range and the threads of the cache decompress them,
+ * as long as they fit in the budget. A read of a frame being decompressed waits for it instead of decompressing it again.
+ * Returns 0 on success, -1 if the cache is not enabled, ZSTDSEEK_ERR_BEYOND_END_SEEK if the range goes beyond the end of the file,
+ * ZSTDSEEK_ERR_NEGATIVE_SEEK if it begins before the frame the context was resumed from.
+ */
+int ZSTDSeek_willneed(ZSTDSeek_Context *sctx, size_t offset, size_t length);
+
+/*
+ * Cancel the frames hinted with ZSTDSeek_willneed not yet being decompressed.
+ * Returns how many.
+ */
+size_t ZSTDSeek_cancelWillneed(ZSTDSeek_Context *sctx);
+
+/* Parallel API */
+
+/*
+ * Decompress the whole frame number frame, as numbered in the jump table, into outBuff using dctx.
+ * outBuff must be big enough for the uncompressed frame.
+ * It doesn't change the position of sctx, so with a fully initialized jump table it can be called from many threads, each with its own dctx.
+ * Returns the number of bytes written in outBuff or ZSTDSEEK_ERR_READ.
+ */
+size_t ZSTDSeek_decompressFrame(ZSTDSeek_Context *sctx, ZSTD_DCtx *dctx, size_t frame, void *outBuff, size_t outBuffSize);
+
+/*
+ * Returns the number of threads used when a parallel function is called with nthreads <= 0, ie the number of CPUs.
+ */
+int ZSTDSeek_defaultNumberOfThreads();
+
+/*
+ * Decompress every frame of sctx on nthreads threads and call fn with the data of each one, in no particular order.
+ * Every thread reuses its own decoder and buffer. nthreads <= 0 means one thread per CPU.
+ * Every thread begins with its own range of consecutive frames, when it's done it steals half of the biggest range left.
+ * The jump table is fully initialized first. If sctx is a view only the data of the view is passed to fn.
+ * fn is called concurrently from different threads.
+ * Returns 0 on success, the value returned by fn if it stopped the processing or -1 in case of failure.
+ */
+int ZSTDSeek_forEachFrameParallel(ZSTDSeek_Context *sctx, ZSTDSeek_FrameCallback fn, void *user, int nthreads);
+
+/*
+ * Like ZSTDSeek_forEachFrameParallel, but the result of map for each frame is passed to reduce in the order of the file.
+ * map is called concurrently, reduce one call at a time from any of the threads, while the following frames are mapped.
+ * The threads map at most a few frames per thread ahead of the first one not reduced, so the results in memory are bounded.
+ * If the processing stops the results not reduced are freed with free.
+ * Returns 0 on success, the value returned by map or reduce if they stopped the processing or -1 in case of failure.
+ */
+int ZSTDSeek_mapReduceFramesParallel(ZSTDSeek_Context *sctx, ZSTDSeek_MapCallback map, ZSTDSeek_ReduceCallback reduce, void *user, int nthreads);
+
+/* Passthrough API */
+
+/*
+ * Returns a pointer to the buffer with the compressed data, eg the memory mapped file, 0 if the context is not valid.
+ * size is set to the length of the buffer.
+ */
+const void* ZSTDSeek_getCompressedBuffer(ZSTDSeek_Context *sctx, size_t *size);
+
+/*
+ * Find the smallest run of whole frames covering length bytes of uncompressed data starting at offset.
+ * The frames can be served as they are, eg with sendfile on ZSTDSeek_fileno or from ZSTDSeek_getCompressedBuffer,
+ * and the receiver gets the requested range discarding extent->skip bytes at the beginning and extent->trim bytes at the end.
+ * No data is decompressed, but the jump table is initialized up until offset+length if needed.
+ * Returns 0 on success, ZSTDSEEK_ERR_BEYOND_END_SEEK if the range goes beyond the end of the file,
+ * ZSTDSEEK_ERR_NEGATIVE_SEEK if it begins before the frame the context was resumed from.
+ */
+int ZSTDSeek_getCompressedExtent(ZSTDSeek_Context *sctx, size_t offset, size_t length, ZSTDSeek_CompressedExtent *extent);
+
+/*
+ * Get the checksum of the frame number frame, as numbered in the jump table: the lowest 4 bytes of the XXH64 of its uncompressed data.
+ * It's taken from the seek table if it has checksums, otherwise from the end of the frame if the frame has one.
+ * Returns 0 on success, -1 if the frame has no checksum.
+ */
+int ZSTDSeek_getFrameChecksum(ZSTDSeek_Context *sctx, size_t frame, uint32_t *checksum);
+
+/* Access Statistics API */
+
+/*
+ * Enable (enable=1) or disable (enable=0) the recording of per frame access statistics.
+ * Statistics are disabled by default and enabling them doesn't reset the ones recorded so far.
+ */
+void ZSTDSeek_enableAccessStats(ZSTDSeek_Context *sctx, int enable);
+
+/*
+ * Returns the per frame access statistics recorded so far, indexed like the jump table records, 0 if none.
+ * length is set to the number of entries.
+ * The pointer is valid until the next read, seek or ZSTDSeek_resetAccessStats.
+ */
+const ZSTDSeek_FrameAccessStats* ZSTDSeek_getAccessStats(ZSTDSeek_Context *sctx, size_t *length);
+
+/*
+ * Reset the per frame access statistics.
+ */
+void ZSTDSeek_resetAccessStats(ZSTDSeek_Context *sctx);
+
+/*
+ * Write the access statistics as a heatmap to f, one line per frame with:
+ * frame index, compressed position, uncompressed position, uncompressed size, accesses, decoded bytes and returned bytes.
+ * Returns 0 on success.
+ */
+int ZSTDSeek_writeAccessStats(ZSTDSeek_Context *sctx, FILE *f);
+
 /*
  * Free the context.
  */
@@ -0,0 +1,342 @@
+/* ******************************************************************
+ * libzstd-seek
+ * Copyright (c) 2020, Martinelli Marco
+ *
+ * You can contact the author at :
+ * - Source repository : https://github.com/martinellimarco/libzstd-seek
+ *
+ * This source code is licensed under the GPLv3 (found in the LICENSE
+ * file in the root directory of this source tree).
+****************************************************************** */
+
+#ifndef _ZSTD_SEEK_HPP_
+#define _ZSTD_SEEK_HPP_
+
+/*
+ * C++20 wrapper of the context, header only.
+ *
+ *     zstdseek::Context ctx = zstdseek::Context::fromFile("file.zst");
+ *     for(std::span<const std::byte> chunk : ctx.chunks()){
+ *         //chunk points to the decode buffer, no copy
+ *     }
+ *
+ *     zstdseek::IStream in(ctx);
+ *     std::string line;
+ *     while(std::getline(in, line)){ ... }
+ *
+ * The failures to create a context or to decompress throw std::runtime_error.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <iterator>
+#include <istream>
+#include <span>
+#include <stdexcept>
+#include <streambuf>
+#include <utility>
+#include "zstd-seek.h"
+
+namespace zstdseek {
+
+class Chunks;
+
+class Context {
+public:
+    /*
+     * Take the ownership of sctx, that is freed with the Context.
+     */
+    explicit Context(ZSTDSeek_Context *sctx) : sctx(sctx) {
+        if(!sctx){
+            throw std::runtime_error("Can't create the context");
+        }
+    }
+
+    static Context fromFile(const char *file, bool jumpTable = true) {
+        return Context(jumpTable ? ZSTDSeek_createFromFile(file) : ZSTDSeek_createFromFileWithoutJumpTable(file));
+    }
+
+    static Context fromFileDescriptor(int fd, bool jumpTable = true) {
+        return Context(jumpTable ? ZSTDSeek_createFromFileDescriptor(fd) : ZSTDSeek_createFromFileDescriptorWithoutJumpTable(fd));
+    }
+
+    /*
+     * buff must outlive the Context.
+     */
+    static Context fromBuffer(void *buff, size_t size, bool jumpTable = true) {
+        return Context(jumpTable ? ZSTDSeek_create(buff, size) : ZSTDSeek_createWithoutJumpTable(buff, size));
+    }
+
+    /*
+     * A view of length bytes from start, see ZSTDSeek_createView. This Context must outlive it.
+     */
+    Context view(size_t start, size_t length) {
+        return Context(ZSTDSeek_createView(sctx, start, length));
+    }
+
+    ~Context() {
+        if(sctx){
+            ZSTDSeek_free(sctx);
+        }
+    }
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    Context(Context &&other) noexcept : sctx(std::exchange(other.sctx, nullptr)) {}
+
+    Context& operator=(Context &&other) noexcept {
+        if(this != &other){
+            if(sctx){
+                ZSTDSeek_free(sctx);
+            }
+            sctx = std::exchange(other.sctx, nullptr);
+        }
+        return *this;
+    }
+
+    /*
+     * Read into buff from the current position. Returns the bytes read, less than its size only at the end of the data.
+     */
+    size_t read(std::span<std::byte> buff) {
+        size_t total = 0;
+        while(total < buff.size()){
+            size_t len = ZSTDSeek_read(buff.data() + total, buff.size() - total, sctx);
+            if(len == (size_t)ZSTDSEEK_ERR_READ){
+                throw std::runtime_error("Can't decompress the data");
+            }
+            if(len == 0){
+                break;
+            }
+            total += len;
+        }
+        return total;
+    }
+
+    /*
+     * Like ZSTDSeek_seek. Returns false if the position is not valid.
+     */
+    bool seek(long offset, int origin = SEEK_SET) noexcept {
+        return ZSTDSeek_seek(sctx, offset, origin) == 0;
+    }
+
+    size_t tell() const noexcept {
+        return (size_t)ZSTDSeek_tell(sctx);
+    }
+
+    /*
+     * The size of the uncompressed data, it initializes the whole jump table.
+     */
+    size_t size() const noexcept {
+        return ZSTDSeek_uncompressedFileSize(sctx);
+    }
+
+    /*
+     * The records of the whole jump table, the last one is the end of the data.
+     * A view has the jump table of its parent, see ZSTDSeek_getViewStart.
+     */
+    std::span<const ZSTDSeek_JumpTableRecord> jumpTable() const {
+        if(ZSTDSeek_initializeJumpTable(sctx) != 0){
+            throw std::runtime_error("Can't initialize the jump table");
+        }
+        ZSTDSeek_JumpTable *jt = ZSTDSeek_getJumpTableOfContext(sctx);
+        return std::span<const ZSTDSeek_JumpTableRecord>(jt->records, (size_t)jt->length);
+    }
+
+    /*
+     * The decoded data from the current position to the end, as it's produced by the decoder, see ZSTDSeek_peek.
+     * Moving to the next chunk consumes the previous one.
+     */
+    Chunks chunks() noexcept;
+
+    ZSTDSeek_Context* get() const noexcept {
+        return sctx;
+    }
+
+    ZSTDSeek_Context* release() noexcept {
+        return std::exchange(sctx, nullptr);
+    }
+
+private:
+    ZSTDSeek_Context *sctx;
+};
+
+class Chunks {
+public:
+    class iterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = std::span<const std::byte>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() noexcept = default;
+
+        std::span<const std::byte> operator*() const noexcept {
+            return chunk;
+        }
+
+        iterator& operator++() {
+            if(ZSTDSeek_consume(sctx, chunk.size()) != 0){
+                throw std::runtime_error("Can't consume the data");
+            }
+            next();
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        bool operator==(std::default_sentinel_t) const noexcept {
+            return chunk.empty();
+        }
+
+    private:
+        friend class Chunks;
+
+        explicit iterator(ZSTDSeek_Context *sctx) : sctx(sctx) {
+            next();
+        }
+
+        void next() {
+            const void *data;
+            size_t size;
+            int ret = ZSTDSeek_peek(sctx, &data, &size);
+            if(ret < 0){
+                throw std::runtime_error("Can't decompress the data");
+            }
+            chunk = ret == 1 ? std::span<const std::byte>((const std::byte *)data, size) : std::span<const std::byte>();
+        }
+
+        ZSTDSeek_Context *sctx = nullptr;
+        std::span<const std::byte> chunk;
+    };
+
+    explicit Chunks(ZSTDSeek_Context *sctx) noexcept : sctx(sctx) {}
+
+    iterator begin() {
+        return iterator(sctx);
+    }
+
+    std::default_sentinel_t end() const noexcept {
+        return std::default_sentinel;
+    }
+
+private:
+    ZSTDSeek_Context *sctx;
+};
+
+inline Chunks Context::chunks() noexcept {
+    return Chunks(sctx);
+}
+
+/*
+ * A std::streambuf whose get area is the data returned by ZSTDSeek_peek, so underflow doesn't copy it.
+ * The position of the context is moved forward when the get area is exhausted, or by sync, that is called on destruction.
+ * The context must not be used directly until then.
+ */
+class StreamBuf : public std::streambuf {
+public:
+    explicit StreamBuf(ZSTDSeek_Context *sctx) noexcept : sctx(sctx) {}
+    explicit StreamBuf(Context &ctx) noexcept : sctx(ctx.get()) {}
+
+    ~StreamBuf() override {
+        sync();
+    }
+
+    StreamBuf(const StreamBuf&) = delete;
+    StreamBuf& operator=(const StreamBuf&) = delete;
+
+protected:
+    int_type underflow() override {
+        if(gptr() < egptr()){
+            return traits_type::to_int_type(*gptr());
+        }
+        if(sync() != 0){
+            return traits_type::eof();
+        }
+        const void *data;
+        size_t size;
+        if(ZSTDSeek_peek(sctx, &data, &size) != 1){
+            return traits_type::eof();
+        }
+        char *begin = const_cast<char *>(static_cast<const char *>(data)); //the get area is never written
+        setg(begin, begin, begin + size);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::streamsize showmanyc() override {
+        long pos = ZSTDSeek_tell(sctx);
+        size_t size = ZSTDSeek_lastKnownUncompressedFileSize(sctx);
+        if(pos < 0){
+            return -1;
+        }
+        pos += gptr() - eback();
+        return (size_t)pos < size ? (std::streamsize)(size - pos) : 0;
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if(!(which & std::ios_base::in)){
+            return pos_type(off_type(-1));
+        }
+        long start = ZSTDSeek_tell(sctx); //the position of eback
+        if(start < 0){
+            return pos_type(off_type(-1));
+        }
+        off_type target;
+        if(dir == std::ios_base::beg){
+            target = off;
+        }else if(dir == std::ios_base::cur){
+            target = start + (gptr() - eback()) + off;
+        }else{
+            target = (off_type)ZSTDSeek_uncompressedFileSize(sctx) + off;
+        }
+        if(target >= start && target <= start + (egptr() - eback())){ //within the get area, eg tellg
+            setg(eback(), eback() + (target - start), egptr());
+            return pos_type(target);
+        }
+        setg(nullptr, nullptr, nullptr); //the seek invalidates the data of the last peek
+        if(ZSTDSeek_seek(sctx, (long)target, SEEK_SET) != 0){
+            return pos_type(off_type(-1));
+        }
+        return pos_type(target);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+    /*
+     * Move the context to the current position of the get area, that becomes empty.
+     */
+    int sync() override {
+        if(!eback()){
+            return 0;
+        }
+        size_t consumed = gptr() - eback();
+        setg(nullptr, nullptr, nullptr);
+        return ZSTDSeek_consume(sctx, consumed) == 0 ? 0 : -1;
+    }
+
+private:
+    ZSTDSeek_Context *sctx;
+};
+
+/*
+ * A std::istream reading from the current position of the context through a StreamBuf.
+ */
+class IStream : public std::istream {
+public:
+    explicit IStream(ZSTDSeek_Context *sctx) : std::istream(nullptr), buf(sctx) {
+        rdbuf(&buf);
+    }
+
+    explicit IStream(Context &ctx) : IStream(ctx.get()) {}
+
+private:
+    StreamBuf buf;
+};
+
+}
+
+#endif